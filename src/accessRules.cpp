@@ -0,0 +1,318 @@
+#include "./accessRules.hpp"
+#include <algorithm>
+#include <cctype>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr bool isSeparator(char c)
+    {
+#ifdef _WIN32
+        return c == '\\' || c == '/';
+#else
+        return c == '/';
+#endif
+    }
+
+    // Calls `visit` for each non-empty component of `path`; stops early when it returns false.
+    template <typename Visitor>
+    bool forEachComponent(std::string_view path, Visitor &&visit)
+    {
+        std::size_t begin = 0;
+        while (begin < path.size())
+        {
+            std::size_t end = begin;
+            while (end < path.size() && !isSeparator(path[end]))
+            {
+                ++end;
+            }
+
+            if (end > begin && !visit(path.substr(begin, end - begin)))
+            {
+                return false;
+            }
+            begin = end + 1;
+        }
+        return true;
+    }
+
+    // Same rules as std::filesystem::path::extension(): no extension for "." and "..", or when the
+    // only dot starts the name.
+    std::string_view extensionOf(std::string_view fileName)
+    {
+        if (fileName == "." || fileName == "..")
+        {
+            return {};
+        }
+
+        const std::size_t dot = fileName.rfind('.');
+        if (dot == std::string_view::npos || dot == 0)
+        {
+            return {};
+        }
+        return fileName.substr(dot);
+    }
+
+    std::string_view lastComponent(std::string_view path)
+    {
+        while (!path.empty() && isSeparator(path.back()))
+        {
+            path.remove_suffix(1);
+        }
+
+        std::size_t start = path.size();
+        while (start > 0 && !isSeparator(path[start - 1]))
+        {
+            --start;
+        }
+        return path.substr(start);
+    }
+} // namespace
+
+AccessRules::AccessRules(const fs::path &baseDir,
+                         const std::vector<std::string> &allowedExtensions,
+                         const std::vector<std::string> &deniedExtensions,
+                         const std::vector<std::string> &allowedFiles,
+                         const std::vector<std::string> &deniedFiles)
+    : nodes(1),
+      baseText(baseDir.string()),
+      allowedExtensions(normalizeExtensions(allowedExtensions)),
+      deniedExtensions(normalizeExtensions(deniedExtensions))
+{
+    for (const auto *extensions : {&this->allowedExtensions, &this->deniedExtensions})
+    {
+        for (const auto &extension : *extensions)
+        {
+            longestExtension = std::max(longestExtension, extension.size());
+        }
+    }
+
+    addRules(deniedFiles, baseDir, false);
+    addRules(allowedFiles, baseDir, true);
+}
+
+bool AccessRules::isAccessible(const fs::path &canonicalPath, bool isDirectory) const
+{
+#ifdef _WIN32
+    const std::string text = canonicalPath.string();
+    return isAccessible(std::string_view{text}, isDirectory);
+#else
+    return isAccessible(std::string_view{canonicalPath.native()}, isDirectory);
+#endif
+}
+
+bool AccessRules::isAccessible(std::string_view canonicalPath, bool isDirectory) const
+{
+    // Walk as far as the trie follows the path. Subtree verdicts apply to everything below their node;
+    // exact and ancestor verdicts only when the walk ends on the node itself.
+    std::uint32_t node = 0;
+    bool matchedWhole = true;
+    bool deniedHit = false;
+    bool allowedHit = false;
+    forEachComponent(canonicalPath, [&](std::string_view component) {
+        const auto &children = nodes[node].children;
+        const auto it = children.find(component);
+        if (it == children.end())
+        {
+            matchedWhole = false;
+            return false;
+        }
+
+        node = it->second;
+        const std::uint8_t flags = nodes[node].flags;
+        if (flags & DeniedSubtree)
+        {
+            deniedHit = true;
+            return false;
+        }
+        allowedHit = allowedHit || (flags & AllowedSubtree) != 0;
+        return true;
+    });
+
+    const std::uint8_t flags = matchedWhole ? nodes[node].flags : 0;
+    if (deniedHit || (flags & DeniedExact))
+    {
+        return false;
+    }
+
+    const GlobMatcher::Result patternResult = matchPatterns(canonicalPath, isDirectory);
+    if (patternResult.matched & (1U << denyTag))
+    {
+        return false;
+    }
+
+    const std::string_view fileName = lastComponent(canonicalPath);
+    if (!deniedExtensions.empty() && hasExtension(deniedExtensions, fileName))
+    {
+        return false;
+    }
+
+    if (hasAllowedFiles)
+    {
+        if (allowedHit || (flags & AllowedExact) || (patternResult.matched & (1U << allowTag)))
+        {
+            return true;
+        }
+        // Directories stay listable while an allow pattern could still match something inside them.
+        return isDirectory && ((flags & AllowedAncestor) != 0 || (patternResult.pending & (1U << allowTag)) != 0);
+    }
+
+    if (isDirectory)
+    {
+        return true;
+    }
+
+    if (!allowedExtensions.empty())
+    {
+        return hasExtension(allowedExtensions, fileName);
+    }
+
+    return true;
+}
+
+void AccessRules::hidePath(const fs::path &canonicalPath)
+{
+    nodes[insert(canonicalPath.string(), nullptr)].flags |= DeniedSubtree;
+}
+
+AccessRules::ComponentSet AccessRules::normalizeExtensions(const std::vector<std::string> &extensions)
+{
+    ComponentSet result;
+    for (const auto &ext : extensions)
+    {
+        std::string normalized = ext;
+        std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
+        if (!normalized.empty() && normalized[0] != '.')
+        {
+            normalized = "." + normalized;
+        }
+        result.insert(normalized);
+    }
+    return result;
+}
+
+std::uint32_t AccessRules::insert(std::string_view canonicalPath, std::vector<std::uint32_t> *trail)
+{
+    std::uint32_t node = 0;
+    if (trail != nullptr)
+    {
+        trail->assign(1, 0U);
+    }
+
+    forEachComponent(canonicalPath, [&](std::string_view component) {
+        auto it = nodes[node].children.find(component);
+        if (it == nodes[node].children.end())
+        {
+            const auto child = static_cast<std::uint32_t>(nodes.size());
+            nodes[node].children.emplace(std::string{component}, child);
+            nodes.emplace_back();
+            node = child;
+        }
+        else
+        {
+            node = it->second;
+        }
+
+        if (trail != nullptr)
+        {
+            trail->push_back(node);
+        }
+        return true;
+    });
+    return node;
+}
+
+void AccessRules::addRules(const std::vector<std::string> &items, const fs::path &baseDir, bool allow)
+{
+    const std::string baseText = baseDir.string();
+    const std::uint32_t baseNode = insert(baseText, nullptr);
+
+    std::vector<std::uint32_t> trail;
+    for (const auto &pathStr : items)
+    {
+        if (GlobMatcher::isPattern(pathStr))
+        {
+            if (patterns.add(pathStr, allow ? allowTag : denyTag) && allow)
+            {
+                hasAllowedFiles = true;
+            }
+            continue;
+        }
+
+        std::error_code fileEc;
+        const fs::path canonicalPath = fs::weakly_canonical(baseDir / fs::path{pathStr}, fileEc);
+        if (fileEc)
+        {
+            continue;
+        }
+
+        const bool isDirectory = fs::is_directory(canonicalPath, fileEc);
+        const std::uint32_t node = insert(canonicalPath.string(), &trail);
+        if (allow)
+        {
+            nodes[node].flags |= isDirectory ? AllowedSubtree : AllowedExact;
+            hasAllowedFiles = true;
+
+            // The entry and every directory above it, up to the shared root, stay listable so the
+            // allowed entry can be reached from the root page.
+            for (auto it = trail.rbegin(); it != trail.rend(); ++it)
+            {
+                nodes[*it].flags |= AllowedAncestor;
+                if (*it == baseNode)
+                {
+                    break;
+                }
+            }
+        }
+        else
+        {
+            nodes[node].flags |= isDirectory ? DeniedSubtree : DeniedExact;
+        }
+    }
+}
+
+bool AccessRules::hasExtension(const ComponentSet &extensions, std::string_view fileName) const
+{
+    const std::string_view extension = extensionOf(fileName);
+    if (extension.size() > longestExtension)
+    {
+        return false;
+    }
+
+    // Lower-case into a stack buffer; configured extensions longer than it are rare enough to copy.
+    char lowered[64];
+    if (extension.size() > sizeof(lowered))
+    {
+        std::string copy{extension};
+        std::transform(copy.begin(), copy.end(), copy.begin(), ::tolower);
+        return extensions.count(copy) > 0;
+    }
+
+    for (std::size_t i = 0; i < extension.size(); ++i)
+    {
+        lowered[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(extension[i])));
+    }
+    return extensions.find(std::string_view{lowered, extension.size()}) != extensions.end();
+}
+
+GlobMatcher::Result AccessRules::matchPatterns(std::string_view canonicalPath, bool isDirectory) const
+{
+    // Patterns are relative to the shared root and do not apply to symlink targets outside it.
+    if (patterns.empty() || !canonicalPath.starts_with(baseText))
+    {
+        return {};
+    }
+
+    std::string_view relative = canonicalPath.substr(baseText.size());
+    if (!relative.empty() && !baseText.empty() && !isSeparator(baseText.back()))
+    {
+        if (!isSeparator(relative.front()))
+        {
+            return {};
+        }
+        relative.remove_prefix(1);
+    }
+    return patterns.match(relative, isDirectory);
+}
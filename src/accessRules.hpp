@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "./globMatcher.hpp"
+
+// The --allow-*/--deny-* options compiled into a trie of canonical path components. A check walks the
+// path once, component by component, without touching the filesystem or allocating. File entries that
+// contain `*`, `?` or `[` are gitignore-style patterns relative to the shared root instead, and are
+// compiled together into one GlobMatcher.
+class AccessRules
+{
+public:
+    AccessRules(const std::filesystem::path &baseDir,
+                const std::vector<std::string> &allowedExtensions,
+                const std::vector<std::string> &deniedExtensions,
+                const std::vector<std::string> &allowedFiles,
+                const std::vector<std::string> &deniedFiles);
+
+    // `canonicalPath` must already be canonical; it is compared component-wise, not resolved.
+    bool isAccessible(const std::filesystem::path &canonicalPath, bool isDirectory) const;
+    bool isAccessible(std::string_view canonicalPath, bool isDirectory) const;
+
+    // Denies `canonicalPath` and everything below it regardless of the other rules, for the server's own
+    // directories such as the upload staging area.
+    void hidePath(const std::filesystem::path &canonicalPath);
+
+private:
+    struct ComponentHash
+    {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view text) const noexcept
+        {
+            return std::hash<std::string_view>{}(text);
+        }
+    };
+
+    using ComponentSet = std::unordered_set<std::string, ComponentHash, std::equal_to<>>;
+
+    enum Flag : std::uint8_t
+    {
+        DeniedExact = 1U << 0,
+        DeniedSubtree = 1U << 1,
+        AllowedExact = 1U << 2,
+        AllowedSubtree = 1U << 3,
+        AllowedAncestor = 1U << 4
+    };
+
+    struct Node
+    {
+        std::unordered_map<std::string, std::uint32_t, ComponentHash, std::equal_to<>> children;
+        std::uint8_t flags = 0;
+    };
+
+    static constexpr unsigned denyTag = 0;
+    static constexpr unsigned allowTag = 1;
+
+    static ComponentSet normalizeExtensions(const std::vector<std::string> &extensions);
+    std::uint32_t insert(std::string_view canonicalPath, std::vector<std::uint32_t> *trail);
+    void addRules(const std::vector<std::string> &items, const std::filesystem::path &baseDir, bool allow);
+    bool hasExtension(const ComponentSet &extensions, std::string_view fileName) const;
+    GlobMatcher::Result matchPatterns(std::string_view canonicalPath, bool isDirectory) const;
+
+private:
+    std::vector<Node> nodes;
+    std::string baseText;
+    GlobMatcher patterns;
+    ComponentSet allowedExtensions;
+    ComponentSet deniedExtensions;
+    std::size_t longestExtension = 0;
+    bool hasAllowedFiles = false;
+};
@@ -1,4 +1,13 @@
 #include "./core.hpp"
+#include "./accessRules.hpp"
+#include "./listingCache.hpp"
+#include "./pathResolver.hpp"
+#include "./sessionTokens.hpp"
+#include "./uploadAdmission.hpp"
+#include "./uploadNames.hpp"
+#include "./uploadSessions.hpp"
+#include "./uploadStore.hpp"
+#include "./workerPool.hpp"
 #include <string>
 #include <string_view>
 #include <vector>
@@ -9,14 +18,25 @@
 #include <fstream>
 #include <filesystem>
 #include <limits>
+#include <chrono>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <span>
 #include <algorithm>
+#include <array>
 #include <type_traits>
 #include <stdexcept>
 #include <system_error>
+#include <cctype>
 #include <httplib.h>
+#include "utils/checksum.hpp"
+#include "utils/compression.hpp"
+#include "utils/directoryScanner.hpp"
 #include "utils/file.hpp"
+#include "utils/fileReader.hpp"
+#include "utils/fileWriter.hpp"
+#include "utils/http.hpp"
 #include "utils/network.hpp"
 #include "utils/string.hpp"
 #include "indexHtml.hpp"
@@ -34,285 +54,474 @@ namespace
 #ifdef CPPHTTPLIB_VERSION_NUM
     // New httplib has StatusCode enum and FormData type
     constexpr int HTTP_STATUS_OK = httplib::StatusCode::OK_200;
+    constexpr int HTTP_STATUS_CREATED = httplib::StatusCode::Created_201;
+    constexpr int HTTP_STATUS_NO_CONTENT = httplib::StatusCode::NoContent_204;
+    constexpr int HTTP_STATUS_NOT_MODIFIED = httplib::StatusCode::NotModified_304;
     constexpr int HTTP_STATUS_BAD_REQUEST = httplib::StatusCode::BadRequest_400;
     constexpr int HTTP_STATUS_UNAUTHORIZED = httplib::StatusCode::Unauthorized_401;
     constexpr int HTTP_STATUS_FORBIDDEN = httplib::StatusCode::Forbidden_403;
     constexpr int HTTP_STATUS_NOT_FOUND = httplib::StatusCode::NotFound_404;
     constexpr int HTTP_STATUS_INTERNAL_SERVER_ERROR = httplib::StatusCode::InternalServerError_500;
+    constexpr int HTTP_STATUS_SERVICE_UNAVAILABLE = httplib::StatusCode::ServiceUnavailable_503;
+    constexpr int HTTP_STATUS_INSUFFICIENT_STORAGE = httplib::StatusCode::InsufficientStorage_507;
     using UploadPartType = httplib::FormData;
 #else
     // Old httplib doesn't have StatusCode enum; uses MultipartFormData
     constexpr int HTTP_STATUS_OK = 200;
+    constexpr int HTTP_STATUS_CREATED = 201;
+    constexpr int HTTP_STATUS_NO_CONTENT = 204;
+    constexpr int HTTP_STATUS_NOT_MODIFIED = 304;
     constexpr int HTTP_STATUS_BAD_REQUEST = 400;
     constexpr int HTTP_STATUS_UNAUTHORIZED = 401;
     constexpr int HTTP_STATUS_FORBIDDEN = 403;
     constexpr int HTTP_STATUS_NOT_FOUND = 404;
     constexpr int HTTP_STATUS_INTERNAL_SERVER_ERROR = 500;
+    constexpr int HTTP_STATUS_SERVICE_UNAVAILABLE = 503;
+    constexpr int HTTP_STATUS_INSUFFICIENT_STORAGE = 507;
     using UploadPartType = httplib::MultipartFormData;
 #endif
-} // namespace
-
-void Core::start(const std::string &path,
-                 const std::string &uploadsPath,
-                 const std::string &host,
-                 unsigned short port,
-                 bool uploadsEnabled,
-                 const std::string &password,
-                 bool passwordEnabled,
-                 const std::vector<std::string> &allowedExtensions,
-                 const std::vector<std::string> &deniedExtensions,
-                 const std::vector<std::string> &allowedFiles,
-                 const std::vector<std::string> &deniedFiles)
-{
-    constexpr std::size_t maxRequestBytes = 50ULL * 1024ULL * 1024ULL * 1024ULL; // 50GB
+    // "Checksum Mismatch" from the tus checksum extension; httplib has no name for it.
+    constexpr int HTTP_STATUS_CHECKSUM_MISMATCH = 460;
 
-    auto httpServer = std::make_shared<httplib::Server>();
-    httpServer->set_payload_max_length(maxRequestBytes);
+    enum class ListingSort
+    {
+        Name,
+        Size,
+        Modified
+    };
 
-    const std::string uploadHtml = uploadsEnabled ? std::string{resources::uploadHtml} : std::string{};
+    // Rows rendered into the listing page; the page script loads the rest through /api/list on demand.
+    constexpr std::size_t listingPageSize = 200U;
+    constexpr std::size_t listingApiDefaultLimit = 200U;
+    constexpr std::size_t listingApiMaxLimit = 1000U;
 
-    fs::path baseCandidate = path.empty() ? fs::current_path() : fs::path(path);
-    if (baseCandidate.is_relative())
+    // Cursors name the last entry a client has seen ("d" or "f", the sort key, the name), so a page
+    // continues after that entry even if entries were added or removed in between.
+    std::string encodeListingCursor(const ListingCache::Entry &entry, ListingSort sort)
     {
-        baseCandidate = fs::current_path() / baseCandidate;
+        std::string cursor = entry.isDirectory ? "d:" : "f:";
+        if (sort == ListingSort::Size)
+        {
+            cursor += std::to_string(entry.fileSize);
+        }
+        else if (sort == ListingSort::Modified)
+        {
+            cursor += std::to_string(entry.modified);
+        }
+        cursor.push_back(':');
+        cursor += entry.name;
+        return cursor;
     }
 
-    std::error_code ec;
-    const std::filesystem::path baseDir = fs::weakly_canonical(baseCandidate, ec);
-    if (ec || !fs::exists(baseDir) || !fs::is_directory(baseDir))
+    std::tuple<bool, ListingCache::Entry> decodeListingCursor(const std::string &cursor, ListingSort sort)
     {
-        throw std::runtime_error("invalid base directory: " + baseCandidate.string());
+        ListingCache::Entry entry{{}, false, 0, 0};
+        const std::size_t keyEnd = cursor.find(':', 2);
+        if (cursor.size() < 2 || (cursor[0] != 'd' && cursor[0] != 'f') || cursor[1] != ':' || keyEnd == std::string::npos)
+        {
+            return {false, entry};
+        }
+
+        entry.isDirectory = cursor[0] == 'd';
+        entry.name = cursor.substr(keyEnd + 1);
+        const std::string key = cursor.substr(2, keyEnd - 2);
+        try
+        {
+            if (sort == ListingSort::Size)
+            {
+                entry.fileSize = std::stoull(key);
+            }
+            else if (sort == ListingSort::Modified)
+            {
+                entry.modified = std::stoll(key);
+            }
+        }
+        catch (const std::exception &)
+        {
+            return {false, entry};
+        }
+
+        return {true, entry};
     }
 
-    const std::unordered_set<std::string> normalizedAllowedExtensions = Core::normalizeExtensions(allowedExtensions);
-    const std::unordered_set<std::string> normalizedDeniedExtensions = Core::normalizeExtensions(deniedExtensions);
-
-    std::unordered_set<std::string> normalizedAllowedFiles;
-    std::vector<fs::path> normalizedAllowedDirs;
-    std::unordered_set<std::string> normalizedAllowedAncestors;
-    Core::resolveAllowedPaths(allowedFiles, baseDir, normalizedAllowedFiles, normalizedAllowedDirs, normalizedAllowedAncestors);
-
-    std::unordered_set<std::string> normalizedDeniedFiles;
-    std::vector<fs::path> normalizedDeniedDirs;
-    Core::resolveDeniedPaths(deniedFiles, baseDir, normalizedDeniedFiles, normalizedDeniedDirs);
-
-    const bool hasAllowedExt = !normalizedAllowedExtensions.empty();
-    const bool hasDeniedExt = !normalizedDeniedExtensions.empty();
-    const bool hasAllowedFiles = !normalizedAllowedFiles.empty() || !normalizedAllowedDirs.empty();
-
-    const auto isEntryAccessible = [&](const fs::path &canonicalPath, bool isDirectory) {
-        return Core::isEntryAccessible(canonicalPath,
-                                       isDirectory,
-                                       normalizedAllowedFiles,
-                                       normalizedAllowedDirs,
-                                       normalizedAllowedAncestors,
-                                       normalizedDeniedFiles,
-                                       normalizedDeniedDirs,
-                                       normalizedAllowedExtensions,
-                                       normalizedDeniedExtensions,
-                                       hasAllowedExt,
-                                       hasDeniedExt,
-                                       hasAllowedFiles);
-    };
+    constexpr std::size_t listingChunkBytes = 16U * 1024U;
 
-    const bool authEnabled = passwordEnabled && !password.empty();
+    // Smaller bodies fit in a packet or two either way, so compressing them only adds latency.
+    constexpr std::size_t minCompressedBodyBytes = 1024U;
 
-    authRequired.store(authEnabled);
-    if (!authEnabled)
-    {
-        std::lock_guard<std::mutex> guard(authMutex);
-        authorizedIps.clear();
-    }
+    // An httplib built with codec support compresses text responses on its own; encoding here as well
+    // would compress them twice.
+#if defined(CPPHTTPLIB_ZLIB_SUPPORT) || defined(CPPHTTPLIB_BROTLI_SUPPORT) || defined(CPPHTTPLIB_ZSTD_SUPPORT)
+    constexpr bool compressResponses = false;
+#else
+    constexpr bool compressResponses = true;
+#endif
 
-    auto requireAuth = [this, authEnabled](const httplib::Request &request, httplib::Response &response) {
-        if (!authEnabled)
+    Util::Compression::Encoding negotiateResponseEncoding(const httplib::Request &request, std::span<const Util::Compression::Encoding> offered)
+    {
+        if (!compressResponses || offered.empty())
         {
-            return true;
+            return Util::Compression::Encoding::Identity;
         }
+        return Util::Compression::negotiate(request.get_header_value("Accept-Encoding"), offered);
+    }
 
-        if (isAuthorized(request.remote_addr))
+    void setCompressibleContent(const httplib::Request &request, httplib::Response &response, std::string body, const std::string &contentType)
+    {
+        response.set_header("Vary", "Accept-Encoding");
+        if (body.size() >= minCompressedBodyBytes)
         {
-            return true;
+            const auto encoding = negotiateResponseEncoding(request, Util::Compression::availableEncodings());
+            if (encoding != Util::Compression::Encoding::Identity)
+            {
+                auto [compressedOk, compressed] = Util::Compression::compress(encoding, body);
+                if (compressedOk)
+                {
+                    response.set_header("Content-Encoding", std::string{Util::Compression::encodingToken(encoding)});
+                    response.set_content(std::move(compressed), contentType);
+                    return;
+                }
+            }
         }
+        response.set_content(std::move(body), contentType);
+    }
 
-        response.status = HTTP_STATUS_UNAUTHORIZED;
-        response.set_content(resources::authHtml, "text/html");
-        return false;
+    struct Sidecar
+    {
+        Util::Compression::Encoding encoding;
+        const char *suffix;
     };
 
-    auto handleEntryRequest = [baseDir, uploadHtml, isEntryAccessible](const httplib::Request &request, httplib::Response &response) {
-        const std::string relativePath = Util::File::normalizeRelativePath(request.path);
-        fs::path target = baseDir;
-        if (!relativePath.empty())
+    // Precompressed siblings of a file, in the order preferred when the client accepts several equally.
+    constexpr std::array<Sidecar, 3> sidecars{{
+        {Util::Compression::Encoding::Zstd, ".zst"},
+        {Util::Compression::Encoding::Brotli, ".br"},
+        {Util::Compression::Encoding::Gzip, ".gz"},
+    }};
+    constexpr std::array<Util::Compression::Encoding, 3> sidecarEncodings{
+        Util::Compression::Encoding::Zstd,
+        Util::Compression::Encoding::Brotli,
+        Util::Compression::Encoding::Gzip,
+    };
+
+    bool isNewerOrSame(const Util::File::EntryStat &candidate, const Util::File::EntryStat &reference)
+    {
+        return candidate.mtimeSeconds > reference.mtimeSeconds
+               || (candidate.mtimeSeconds == reference.mtimeSeconds && candidate.mtimeNanoseconds >= reference.mtimeNanoseconds);
+    }
+
+    void setAuthPageContent(const httplib::Request &request, httplib::Response &response)
+    {
+        using Util::Compression::Encoding;
+
+        // Build-time variants cost nothing to serve; the runtime codecs only cover encodings they lack.
+        std::array<Encoding, 2> prebuilt{};
+        std::size_t prebuiltCount = 0;
+        if (resources::authHtmlZstdSize > 0)
+        {
+            prebuilt[prebuiltCount++] = Encoding::Zstd;
+        }
+        if (resources::authHtmlGzipSize > 0)
         {
-            target /= fs::path{relativePath};
+            prebuilt[prebuiltCount++] = Encoding::Gzip;
         }
 
-        std::error_code ec;
-        const std::filesystem::path canonicalTarget = fs::weakly_canonical(target, ec);
-        if (ec || !fs::exists(canonicalTarget) || !Util::File::isWithinBase(canonicalTarget, baseDir))
+        const Encoding encoding = negotiateResponseEncoding(request, std::span<const Encoding>{prebuilt.data(), prebuiltCount});
+        if (encoding == Encoding::Zstd || encoding == Encoding::Gzip)
         {
-            setPlainTextResponse(response, HTTP_STATUS_NOT_FOUND, "Entry not found");
+            const bool zstd = encoding == Encoding::Zstd;
+            response.set_header("Vary", "Accept-Encoding");
+            response.set_header("Content-Encoding", std::string{Util::Compression::encodingToken(encoding)});
+            response.set_content(reinterpret_cast<const char *>(zstd ? resources::authHtmlZstd : resources::authHtmlGzip),
+                                 zstd ? resources::authHtmlZstdSize : resources::authHtmlGzipSize,
+                                 "text/html");
             return;
         }
 
-        const bool targetIsDirectory = fs::is_directory(canonicalTarget);
-        const bool targetIsFile = fs::is_regular_file(canonicalTarget);
+        setCompressibleContent(request, response, resources::authHtml, "text/html");
+    }
 
-        if (!isEntryAccessible(canonicalTarget, targetIsDirectory))
+    struct ListingStream
+    {
+        enum class Stage
         {
-            setPlainTextResponse(response, HTTP_STATUS_FORBIDDEN, "Access denied");
-            return;
+            Head,
+            Rows,
+            Tail
+        };
+
+        Stage stage = Stage::Head;
+        std::string relativePath;
+        std::shared_ptr<const ListingCache::Entries> entries;
+        std::size_t rowCount = 0;
+        std::size_t nextRow = 0;
+        // Left closed when the response is sent uncompressed.
+        Util::Compression::Encoder encoder;
+    };
+
+    bool writeListing(ListingStream &stream, httplib::DataSink &sink, const char *data, std::size_t length, bool flush = false)
+    {
+        if (!stream.encoder.isOpen())
+        {
+            return length == 0 || sink.write(data, length);
         }
+        return stream.encoder.write(data, length, flush, sink.write);
+    }
 
-        if (targetIsFile)
+    template <std::size_t N>
+    bool writeResource(ListingStream &stream, httplib::DataSink &sink, const char (&resource)[N])
+    {
+        return writeListing(stream, sink, resource, N - 1);
+    }
+
+    void appendListingRow(std::string &out, const std::string &relativePath, const ListingCache::Entry &entry)
+    {
+        const std::string childPath = relativePath.empty() ? entry.name : relativePath + "/" + entry.name;
+        out += "<li><a href=\"";
+        out += Util::File::buildHrefForPath(childPath);
+        out += "\">";
+        if (entry.isDirectory)
         {
-            if (!Core::streamFileResponse(response, canonicalTarget))
+            out += "📁 ";
+            out += Util::File::escapeForHtml(entry.name);
+            out += "/</a>";
+        }
+        else
+        {
+            out += Util::File::escapeForHtml(entry.name);
+            out += "</a> <span style=\"margin-left:10px;color:#888;\">[";
+            out += Util::File::formatFileSize(entry.fileSize);
+            out += "]</span>";
+        }
+        out += "</li>\n";
+    }
+
+    // What a listing's validators are made of: an FNV-1a digest of every entry's name, type, size and
+    // modification time, started from `seed`, and the latest of those times. Rewriting a file in place
+    // changes its size or mtime but not the directory's, so the directory's own stat is not enough.
+    std::tuple<std::uint64_t, std::int64_t> summarizeListing(const ListingCache::Entries &entries, std::uint64_t seed)
+    {
+        constexpr std::uint64_t prime = 0x100000001b3ULL;
+        std::uint64_t digest = 0xcbf29ce484222325ULL ^ seed;
+        const auto mix = [&digest](const void *data, std::size_t length) {
+            const auto *bytes = static_cast<const unsigned char *>(data);
+            for (std::size_t i = 0; i < length; ++i)
             {
-                setPlainTextResponse(response, HTTP_STATUS_INTERNAL_SERVER_ERROR, "Failed to read file");
-                return;
+                digest = (digest ^ bytes[i]) * prime;
             }
+        };
 
-            response.set_header("Content-Disposition", Core::buildContentDispositionHeader(canonicalTarget.filename().string()));
-            return;
+        std::int64_t latest = 0;
+        for (const ListingCache::Entry &entry : entries)
+        {
+            // The terminating zero keeps "ab" + "c" apart from "a" + "bc".
+            mix(entry.name.c_str(), entry.name.size() + 1);
+            mix(&entry.isDirectory, sizeof(entry.isDirectory));
+            mix(&entry.fileSize, sizeof(entry.fileSize));
+            mix(&entry.modified, sizeof(entry.modified));
+            latest = std::max(latest, entry.modified);
         }
+        return {digest, latest};
+    }
 
-        if (!targetIsDirectory)
+#ifdef CPPHTTPLIB_VERSION_NUM
+    // Hands the server's connections to a WorkerPool. The server deletes its queue once it stops
+    // listening, after shutting it down, which stops the pool's threads.
+    class WorkerPoolQueue final : public httplib::TaskQueue
+    {
+    public:
+        explicit WorkerPoolQueue(std::shared_ptr<WorkerPool> pool)
+            : pool(std::move(pool))
         {
-            setPlainTextResponse(response, HTTP_STATUS_NOT_FOUND, "Entry not found");
-            return;
         }
 
-        struct Entry
+        bool enqueue(std::function<void()> fn) override
         {
-            std::string name;
-            bool isDirectory;
-            std::uintmax_t fileSize;
-        };
+            return pool->enqueue(std::move(fn));
+        }
 
-        std::vector<Entry> entries;
-        for (const auto &entry : fs::directory_iterator{canonicalTarget})
+        void shutdown() override
         {
-            const bool entryIsDirectory = entry.is_directory();
+            pool->shutdown();
+        }
 
-            std::error_code childEc;
-            const std::filesystem::path entryCanonical = fs::weakly_canonical(entry.path(), childEc);
-            if (childEc)
-            {
-                continue;
-            }
+    private:
+        std::shared_ptr<WorkerPool> pool;
+    };
+#endif
 
-            if (!isEntryAccessible(entryCanonical, entryIsDirectory))
-            {
-                continue;
-            }
+    constexpr std::string_view sessionCookieName = "accio_session";
+    // Signed URLs last an hour unless the request for one asks otherwise.
+    constexpr std::chrono::seconds signedUrlDefaultLifetime{60 * 60};
 
-            std::uintmax_t fileSize = 0;
-            if (entry.is_regular_file())
-            {
-                std::error_code sizeEc;
-                fileSize = entry.file_size(sizeEc);
-                if (sizeEc)
-                {
-                    fileSize = 0;
-                }
-            }
-            entries.push_back(Entry{entry.path().filename().string(), entry.is_directory(), fileSize});
+    std::string_view trimSpaces(std::string_view text)
+    {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+        {
+            text.remove_prefix(1);
         }
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+        {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
 
-        std::sort(entries.begin(), entries.end(), [](const Entry &lhs, const Entry &rhs) {
-            if (lhs.isDirectory != rhs.isDirectory)
-            {
-                return lhs.isDirectory > rhs.isDirectory;
-            }
-            return Core::caseInsensitiveLess(lhs.name, rhs.name);
-        });
-
-        std::string filesHtml;
-        filesHtml += "<ul>\n";
-
-        if (!relativePath.empty())
+    // A request is signed in by a session token in its cookie or Authorization header, or, for reads, by
+    // a signature over its path.
+    bool hasValidCredentials(const SessionTokens &tokens, const httplib::Request &request)
+    {
+        const std::string authorization = request.get_header_value("Authorization");
+        if (authorization.size() > 7 && Util::String::toLowerCopy(std::string_view{authorization}.substr(0, 7)) == "bearer "
+            && tokens.verify(trimSpaces(std::string_view{authorization}.substr(7))))
         {
-            const std::string parentPath = fs::path(relativePath).parent_path().generic_string();
-            const std::string href = Util::File::buildHrefForPath(parentPath);
-            filesHtml += "<li><a href=\"" + href + "\">↩ ../</a></li>\n";
+            return true;
         }
 
-        for (const auto &[filename, isDirectory, fileSize] : entries)
+        const std::size_t cookieHeaders = request.get_header_value_count("Cookie");
+        for (std::size_t id = 0; id < cookieHeaders; ++id)
         {
-            const std::string childPath = relativePath.empty() ? filename : relativePath + "/" + filename;
-            const std::string href = Util::File::buildHrefForPath(childPath);
-            const std::string linkText = isDirectory ? "📁 " + filename + "/" : filename;
-            std::string line = "<li><a href=\"" + href + "\">" + Util::File::escapeForHtml(linkText) + "</a>";
-            if (!isDirectory)
+            const std::string cookies = request.get_header_value("Cookie", "", id);
+            std::string_view rest{cookies};
+            while (!rest.empty())
             {
-                line += " <span style=\"margin-left:10px;color:#888;\">[" + Util::File::formatFileSize(fileSize) + "]</span>";
+                const std::size_t separator = rest.find(';');
+                const std::string_view cookie = trimSpaces(rest.substr(0, separator));
+                rest = separator == std::string_view::npos ? std::string_view{} : rest.substr(separator + 1);
+                if (cookie.size() > sessionCookieName.size() && cookie.starts_with(sessionCookieName)
+                    && cookie[sessionCookieName.size()] == '=' && tokens.verify(cookie.substr(sessionCookieName.size() + 1)))
+                {
+                    return true;
+                }
             }
-            line += "</li>\n";
-            filesHtml += line;
         }
 
-        filesHtml += "</ul>\n";
+        return (request.method == "GET" || request.method == "HEAD") && request.has_param("signature")
+               && tokens.verifyPath(request.path, request.get_param_value("expires"), request.get_param_value("signature"));
+    }
+
+    // Resumable uploads travel in chunks of this size; a lost connection costs at most one chunk.
+    constexpr std::uint64_t uploadChunkBytes = 8ULL * 1024ULL * 1024ULL;
+    constexpr std::chrono::seconds uploadSessionIdleTimeout{24 * 60 * 60};
 
-        std::string html = resources::indexHtml;
-        const std::string filesPlaceholder = "{{files}}";
-        if (std::size_t pos = html.find(filesPlaceholder); pos != std::string::npos)
+    bool parseUploadNumber(const std::string &text, std::uint64_t &value)
+    {
+        if (text.empty() || text.size() > 19 || !std::all_of(text.begin(), text.end(), [](char ch) { return ch >= '0' && ch <= '9'; }))
         {
-            html.replace(pos, filesPlaceholder.size(), filesHtml);
+            return false;
         }
+        value = std::stoull(text);
+        return true;
+    }
 
-        const std::string uploadPlaceholder = "{{upload}}";
-        if (std::size_t pos = html.find(uploadPlaceholder); pos != std::string::npos)
+    // An absent Upload-Checksum header is fine; one that is present must name crc32c and be well formed.
+    bool parseUploadChecksum(const httplib::Request &request, std::optional<std::uint32_t> &checksum)
+    {
+        checksum.reset();
+        if (!request.has_header("Upload-Checksum"))
         {
-            html.replace(pos, uploadPlaceholder.size(), uploadHtml);
+            return true;
         }
-
-        response.set_content(std::move(html), "text/html");
-    };
-
-    httpServer->Post("/auth", [this, authEnabled, password](const httplib::Request &request, httplib::Response &response) {
-        if (!authEnabled)
+        const auto [ok, crc] = Util::Checksum::parseCrc32c(request.get_header_value("Upload-Checksum"));
+        if (ok)
         {
-            setPlainTextResponse(response, HTTP_STATUS_OK, "Auth disabled");
-            return;
+            checksum = crc;
         }
+        return ok;
+    }
 
-        const std::string provided = request.body;
-        if (provided == password)
+    int uploadOutcomeStatus(UploadSessions::Outcome outcome)
+    {
+        switch (outcome)
         {
-            authorizeIp(request.remote_addr);
-            setPlainTextResponse(response, HTTP_STATUS_OK, "OK");
-            return;
+        case UploadSessions::Outcome::Ok:
+            return HTTP_STATUS_OK;
+        case UploadSessions::Outcome::NotFound:
+            return HTTP_STATUS_NOT_FOUND;
+        case UploadSessions::Outcome::Invalid:
+            return HTTP_STATUS_BAD_REQUEST;
+        case UploadSessions::Outcome::InsufficientStorage:
+            return HTTP_STATUS_INSUFFICIENT_STORAGE;
+        case UploadSessions::Outcome::ChecksumMismatch:
+            return HTTP_STATUS_CHECKSUM_MISMATCH;
+        case UploadSessions::Outcome::Busy:
+            return HTTP_STATUS_SERVICE_UNAVAILABLE;
+        case UploadSessions::Outcome::Failed:
+            break;
         }
+        return HTTP_STATUS_INTERNAL_SERVER_ERROR;
+    }
 
-        setPlainTextResponse(response, HTTP_STATUS_UNAUTHORIZED, "Unauthorized");
-    });
+    void setUploadStatus(httplib::Response &response, const UploadSessions::Status &status)
+    {
+        response.set_header("Upload-Offset", std::to_string(status.offset));
+        response.set_header("Upload-Length", std::to_string(status.length));
+        response.set_header("Upload-Chunk-Size", std::to_string(status.chunkSize));
+        response.set_header("Upload-Received", status.receivedChunks);
+        response.set_header("Cache-Control", "no-store");
+    }
 
-    httpServer->Get(R"(/.*)", [requireAuth, handleEntryRequest](const httplib::Request &request, httplib::Response &response) {
-        if (!requireAuth(request, response))
-        {
-            return;
-        }
-        handleEntryRequest(request, response);
-    });
+    bool containsCaseInsensitive(std::string_view text, std::string_view needle)
+    {
+        const auto it = std::search(text.begin(), text.end(), needle.begin(), needle.end(), [](char lhs, char rhs) {
+            return std::tolower(static_cast<unsigned char>(lhs)) == std::tolower(static_cast<unsigned char>(rhs));
+        });
+        return it != text.end() || needle.empty();
+    }
+} // namespace
 
-    httpServer->set_pre_routing_handler([this, requireAuth, handleEntryRequest](const httplib::Request &request, httplib::Response &response) {
-        if (request.method == "HEAD")
-        {
-            if (!requireAuth(request, response))
-            {
-                return httplib::Server::HandlerResponse::Handled;
-            }
+void Core::start(const std::string &path,
+                 const std::string &uploadsPath,
+                 const std::string &host,
+                 unsigned short port,
+                 bool uploadsEnabled,
+                 const std::string &password,
+                 bool passwordEnabled,
+                 const std::vector<std::string> &allowedExtensions,
+                 const std::vector<std::string> &deniedExtensions,
+                 const std::vector<std::string> &allowedFiles,
+                 const std::vector<std::string> &deniedFiles,
+                 const ServerTuning &tuning)
+{
+    constexpr std::size_t maxRequestBytes = 50ULL * 1024ULL * 1024ULL * 1024ULL; // 50GB
 
-            handleEntryRequest(request, response);
-            response.body.clear();
-            return httplib::Server::HandlerResponse::Handled;
-        }
+    auto httpServer = std::make_shared<httplib::Server>();
+    httpServer->set_payload_max_length(maxRequestBytes);
+    httpServer->set_keep_alive_max_count(tuning.keepAliveMax);
+    httpServer->set_keep_alive_timeout(static_cast<time_t>(tuning.keepAliveSeconds));
+    httpServer->set_read_timeout(static_cast<time_t>(tuning.readTimeoutSeconds));
+    httpServer->set_write_timeout(static_cast<time_t>(tuning.writeTimeoutSeconds));
 
-        return httplib::Server::HandlerResponse::Unhandled;
-    });
+    // Releases before 0.18 lack the version number and, with it, a task queue interface this tree can
+    // rely on; they get a plain thread pool of the requested size without the queue and per-client caps.
+#ifdef CPPHTTPLIB_VERSION_NUM
+    const auto workerPool = std::make_shared<WorkerPool>(WorkerPool::Limits{tuning.workers, tuning.workerQueue, tuning.connectionsPerIp});
+    httpServer->new_task_queue = [workerPool] { return new WorkerPoolQueue(workerPool); };
+#else
+    const std::shared_ptr<WorkerPool> workerPool;
+    if (tuning.workers > 0)
+    {
+        httpServer->new_task_queue = [workers = tuning.workers] { return new httplib::ThreadPool(workers); };
+    }
+#endif
+
+    fs::path baseCandidate = path.empty() ? fs::current_path() : fs::path(path);
+    if (baseCandidate.is_relative())
+    {
+        baseCandidate = fs::current_path() / baseCandidate;
+    }
+
+    std::error_code ec;
+    const std::filesystem::path baseDir = fs::weakly_canonical(baseCandidate, ec);
+    if (ec || !fs::exists(baseDir) || !fs::is_directory(baseDir))
+    {
+        throw std::runtime_error("invalid base directory: " + baseCandidate.string());
+    }
 
     std::string uploadsDirStr = "disabled";
+    fs::path uploadsDir;
+    fs::path stagingDir;
+    fs::path storeDir;
     if (uploadsEnabled)
     {
         const bool userProvidedUploads = !uploadsPath.empty();
@@ -320,7 +529,6 @@ void Core::start(const std::string &path,
         const fs::path primaryUploads =
             userProvidedUploads ? fs::path{uploadsPath} : Util::File::getDefaultUploadsDirectory(baseDir);
 
-        fs::path uploadsDir;
         const auto primaryResult = Util::File::resolveUploadsDirectory(primaryUploads);
         const bool primaryOk = std::get<0>(primaryResult);
         const fs::path primaryResolved = std::get<1>(primaryResult);
@@ -355,124 +563,1195 @@ void Core::start(const std::string &path,
         }
         uploadsDirStr = uploadsDir.string();
 
-        httpServer->Post(
-            "/upload",
-            [uploadsDir](const httplib::Request &request, httplib::Response &response, const httplib::ContentReader &content_reader) {
-                if (!request.is_multipart_form_data())
-                {
-                    setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid multipart payload");
-                    return;
-                }
+        auto [stagingOk, stagingResolved, stagingError] = Util::File::prepareStagingDirectory(uploadsDir);
+        if (!stagingOk)
+        {
+            throw std::runtime_error("failed to prepare upload staging directory in '" + uploadsDirStr + "' (" + stagingError + ")");
+        }
+        stagingDir = std::move(stagingResolved);
 
-                enum class UploadError
-                {
-                    None,
-                    BadRequest,
-                    Internal
-                };
+        // Shared content must never be a second name for a visible file, so without reflinks there is no
+        // deduplication at all.
+        if (tuning.dedup && !Util::File::supportsCloning(stagingDir))
+        {
+            std::cerr << "Warning: --dedup needs a filesystem with reflinks (btrfs, XFS, ...) for '" << uploadsDirStr
+                      << "'; uploads are stored without deduplication" << std::endl;
+        }
+        else if (tuning.dedup)
+        {
+            auto [storeOk, storeResolved, storeError] = UploadStore::prepareDirectory(uploadsDir);
+            if (!storeOk)
+            {
+                throw std::runtime_error("failed to prepare upload store in '" + uploadsDirStr + "' (" + storeError + ")");
+            }
+            storeDir = std::move(storeResolved);
+        }
+    }
 
-                UploadError error = UploadError::None;
-                std::string errorMessage;
+    const bool authEnabled = passwordEnabled && !password.empty();
 
-                std::ofstream currentFile;
-                bool currentIsFile = false;
-                bool hasFiles = false;
-                std::vector<std::string> savedNames;
+    // Without a key file, sign-ins last only until the server stops.
+    std::string sessionKey;
+    fs::path sessionKeyFile;
+    if (authEnabled)
+    {
+        if (tuning.sessionKeyFile.empty())
+        {
+            std::cerr << "Warning: no home directory to keep the session key in (see --session-key); sign-ins will not survive a restart"
+                      << std::endl;
+        }
+        else if (auto [keyOk, key, keyError] = SessionTokens::loadKey(tuning.sessionKeyFile, password); keyOk)
+        {
+            sessionKey = std::move(key);
+            sessionKeyFile = fs::weakly_canonical(tuning.sessionKeyFile, ec);
+        }
+        else
+        {
+            std::cerr << "Warning: cannot keep the session key in '" << tuning.sessionKeyFile.string() << "' (" << keyError
+                      << "); sign-ins will not survive a restart" << std::endl;
+        }
+        if (sessionKey.empty())
+        {
+            sessionKey = SessionTokens::generateKey();
+        }
+    }
+
+    // Uploads in progress live in the staging directory and the deduplication store holds private copies of
+    // saved uploads; neither is to be listed or downloaded. Nor is the session key.
+    auto rules = std::make_shared<AccessRules>(baseDir, allowedExtensions, deniedExtensions, allowedFiles, deniedFiles);
+    if (!stagingDir.empty())
+    {
+        rules->hidePath(stagingDir);
+    }
+    if (!storeDir.empty())
+    {
+        rules->hidePath(storeDir);
+    }
+    if (!sessionKeyFile.empty())
+    {
+        rules->hidePath(sessionKeyFile);
+    }
+    const std::shared_ptr<const AccessRules> accessRules = std::move(rules);
+    const auto isEntryAccessible = [accessRules](const fs::path &canonicalPath, bool isDirectory) {
+        return accessRules->isAccessible(canonicalPath, isDirectory);
+    };
+
+    auto pathResolver = std::make_shared<PathResolver>(baseDir);
+
+    std::shared_ptr<UploadNames> uploadNames;
+    std::shared_ptr<UploadStore> uploadStore;
+    std::shared_ptr<UploadAdmission> uploadAdmission;
+    if (uploadsEnabled)
+    {
+        uploadAdmission = std::make_shared<UploadAdmission>(
+            uploadsDir, UploadAdmission::Limits{tuning.uploadWriters, tuning.uploadPendingBytes, tuning.uploadReserveBytes});
+        uploadNames = std::make_shared<UploadNames>(uploadsDir);
+        if (!storeDir.empty())
+        {
+            uploadStore = std::make_shared<UploadStore>(uploadNames, storeDir, stagingDir);
+        }
+    }
+
+    // Answers a refused admission with 503 or 507 and a Retry-After hint; returns false then.
+    const auto admitUpload = [uploadAdmission](std::uint64_t expectedBytes, httplib::Response &response, UploadAdmission::Ticket &ticket) {
+        auto [outcome, admitted] = uploadAdmission->admit(expectedBytes);
+        if (outcome == UploadAdmission::Outcome::Admitted)
+        {
+            ticket = std::move(admitted);
+            return true;
+        }
+
+        const bool busy = outcome == UploadAdmission::Outcome::Busy;
+        const auto retryAfter = busy ? UploadAdmission::busyRetryAfter : UploadAdmission::noSpaceRetryAfter;
+        response.set_header("Retry-After", std::to_string(retryAfter.count()));
+        setPlainTextResponse(response, busy ? HTTP_STATUS_SERVICE_UNAVAILABLE : HTTP_STATUS_INSUFFICIENT_STORAGE,
+                             busy ? "Too many uploads in progress" : "Insufficient storage");
+        return false;
+    };
+
+    const bool naturalSort = tuning.naturalSort;
+
+    const auto loadEntries = [isEntryAccessible, statThreads = tuning.statThreads, naturalSort](const fs::path &directory) {
+        Util::DirectoryScanner scanner;
+        if (!scanner.open(directory))
+        {
+            throw std::runtime_error("Cannot read directory: " + directory.string());
+        }
+
+        // `directory` is canonical, so only a symlink child can have a different canonical path. Entries are
+        // filtered before their metadata is collected, so hidden ones never cost a stat.
+        std::vector<Util::DirectoryScanner::Entry> &scanned = scanner.entries();
+        std::erase_if(scanned, [&](const Util::DirectoryScanner::Entry &entry) {
+            fs::path entryCanonical = directory / entry.name;
+            if (entry.isSymlink)
+            {
+                std::error_code childEc;
+                entryCanonical = fs::weakly_canonical(entryCanonical, childEc);
+                if (childEc)
+                {
+                    return true;
+                }
+            }
+            return !isEntryAccessible(entryCanonical, entry.isDirectory);
+        });
+        scanner.collectMetadata(statThreads);
+
+        ListingCache::Entries entries;
+        entries.reserve(scanned.size());
+        for (Util::DirectoryScanner::Entry &entry : scanned)
+        {
+            entries.push_back(ListingCache::Entry{std::move(entry.name), entry.isDirectory, entry.size, entry.mtimeSeconds});
+        }
+
+        std::sort(entries.begin(), entries.end(), [naturalSort](const ListingCache::Entry &lhs, const ListingCache::Entry &rhs) {
+            if (lhs.isDirectory != rhs.isDirectory)
+            {
+                return lhs.isDirectory > rhs.isDirectory;
+            }
+            return Core::nameLess(lhs.name, rhs.name, naturalSort);
+        });
+
+        return entries;
+    };
+
+    auto listingCache = std::make_shared<ListingCache>(tuning.listingCacheBytes);
+
+    const auto sessionTokens = authEnabled ? std::make_shared<SessionTokens>(std::move(sessionKey), std::chrono::hours{tuning.sessionHours}) : nullptr;
+
+    auto requireAuth = [this, sessionTokens](const httplib::Request &request, httplib::Response &response) {
+        if (!sessionTokens || hasValidCredentials(*sessionTokens, request))
+        {
+            return true;
+        }
+
+        response.status = HTTP_STATUS_UNAUTHORIZED;
+        setAuthPageContent(request, response);
+        return false;
+    };
+
+    const auto resolveEntry = [isEntryAccessible, pathResolver](const std::string &relativePath) {
+        const auto [found, canonicalTarget, targetStat] = pathResolver->resolve(relativePath);
+        if (!found)
+        {
+            return std::make_tuple(HTTP_STATUS_NOT_FOUND, fs::path{}, Util::File::EntryStat{});
+        }
+
+        if (!isEntryAccessible(canonicalTarget, targetStat.isDirectory))
+        {
+            return std::make_tuple(HTTP_STATUS_FORBIDDEN, fs::path{}, Util::File::EntryStat{});
+        }
+
+        return std::make_tuple(HTTP_STATUS_OK, canonicalTarget, targetStat);
+    };
+
+    const auto listingLess = [naturalSort](const ListingCache::Entry &lhs, const ListingCache::Entry &rhs, ListingSort sort, bool descending) {
+        if (lhs.isDirectory != rhs.isDirectory)
+        {
+            return lhs.isDirectory > rhs.isDirectory;
+        }
+
+        if (sort == ListingSort::Size && lhs.fileSize != rhs.fileSize)
+        {
+            return descending ? lhs.fileSize > rhs.fileSize : lhs.fileSize < rhs.fileSize;
+        }
+
+        if (sort == ListingSort::Modified && lhs.modified != rhs.modified)
+        {
+            return descending ? lhs.modified > rhs.modified : lhs.modified < rhs.modified;
+        }
+
+        return descending ? Core::nameLess(rhs.name, lhs.name, naturalSort) : Core::nameLess(lhs.name, rhs.name, naturalSort);
+    };
+
+    // Listings depend on the startup options as well as on the entries, so their validators also carry a
+    // per-run generation and never match a listing rendered by a previous server instance.
+    const std::uint64_t listingGeneration = static_cast<std::uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+
+    // Picks a precompressed sibling ("name.zst", "name.br", "name.gz") the client accepts. Siblings are resolved
+    // like any requested entry, so the access rules apply to them too, and one older than its source is stale.
+    // Range requests keep the plain file, so segmented downloads receive the bytes they expect.
+    const auto findSidecar = [baseDir, resolveEntry](const httplib::Request &request, const std::string &relativePath, const Util::File::EntryStat &sourceStat) {
+        using Util::Compression::Encoding;
+
+        const std::string acceptEncoding = request.get_header_value("Accept-Encoding");
+        if (!request.ranges.empty() || Util::Compression::negotiate(acceptEncoding, sidecarEncodings) == Encoding::Identity)
+        {
+            return std::make_tuple(Encoding::Identity, fs::path{}, Util::File::EntryStat{});
+        }
+
+        std::array<Encoding, sidecars.size()> present{};
+        std::array<std::tuple<fs::path, Util::File::EntryStat>, sidecars.size()> found{};
+        std::size_t presentCount = 0;
+        // Most files have no sidecar, so each is first looked for with one stat of the lexical sibling; only
+        // one that exists goes through full resolution and the access rules.
+        const std::string lexicalSource = (relativePath.empty() ? baseDir : baseDir / fs::path{relativePath}).string();
+        for (const Sidecar &sidecar : sidecars)
+        {
+            const auto [probeOk, probeStat] = Util::File::statEntry(lexicalSource + sidecar.suffix);
+            if (!probeOk || !probeStat.isRegularFile || !isNewerOrSame(probeStat, sourceStat))
+            {
+                continue;
+            }
+            auto [sidecarStatus, sidecarPath, sidecarStat] = resolveEntry(relativePath + sidecar.suffix);
+            if (sidecarStatus == HTTP_STATUS_OK && sidecarStat.isRegularFile && isNewerOrSame(sidecarStat, sourceStat))
+            {
+                present[presentCount] = sidecar.encoding;
+                found[presentCount] = std::make_tuple(std::move(sidecarPath), sidecarStat);
+                ++presentCount;
+            }
+        }
+
+        const Encoding chosen = Util::Compression::negotiate(acceptEncoding, std::span<const Encoding>{present.data(), presentCount});
+        for (std::size_t i = 0; i < presentCount; ++i)
+        {
+            if (present[i] == chosen)
+            {
+                return std::make_tuple(chosen, std::get<0>(found[i]), std::get<1>(found[i]));
+            }
+        }
+        return std::make_tuple(Encoding::Identity, fs::path{}, Util::File::EntryStat{});
+    };
+
+    auto handleEntryRequest = [uploadsEnabled, resolveEntry, findSidecar, listingGeneration, listingCache, loadEntries](const httplib::Request &request, httplib::Response &response) {
+        const std::string relativePath = Util::File::normalizeRelativePath(request.path);
+        const auto [resolveStatus, canonicalTarget, targetStat] = resolveEntry(relativePath);
+        if (resolveStatus == HTTP_STATUS_FORBIDDEN)
+        {
+            setPlainTextResponse(response, HTTP_STATUS_FORBIDDEN, "Access denied");
+            return;
+        }
+
+        if (resolveStatus != HTTP_STATUS_OK)
+        {
+            setPlainTextResponse(response, HTTP_STATUS_NOT_FOUND, "Entry not found");
+            return;
+        }
+
+        const bool targetIsDirectory = targetStat.isDirectory;
+        const bool targetIsFile = targetStat.isRegularFile;
+
+        if (targetIsFile)
+        {
+            // The sidecar is a separate representation with its own validators; the download keeps the source's name.
+            const auto [encoding, sidecarPath, sidecarStat] = findSidecar(request, relativePath, targetStat);
+            const bool useSidecar = encoding != Util::Compression::Encoding::Identity;
+            const fs::path &servedPath = useSidecar ? sidecarPath : canonicalTarget;
+            const Util::File::EntryStat &servedStat = useSidecar ? sidecarStat : targetStat;
+
+            response.set_header("Vary", "Accept-Encoding");
+            const std::string entityTag = Util::Http::buildEntityTag(servedStat, false);
+            if (Core::respondIfNotModified(request, response, entityTag, servedStat.mtimeSeconds))
+            {
+                return;
+            }
+
+            // A client whose partial copy is stale must receive the whole file instead of the ranges it asked for.
+            const bool staleRange = !request.ranges.empty() && request.has_header("If-Range")
+                                    && !Util::Http::isIfRangeSatisfied(request.get_header_value("If-Range"), entityTag, servedStat.mtimeSeconds);
+            if (!Core::streamFileResponse(response, servedPath, staleRange))
+            {
+                setPlainTextResponse(response, HTTP_STATUS_INTERNAL_SERVER_ERROR, "Failed to read file");
+                return;
+            }
+
+            if (useSidecar)
+            {
+                response.set_header("Content-Encoding", std::string{Util::Compression::encodingToken(encoding)});
+            }
+            response.set_header("Accept-Ranges", "bytes");
+            response.set_header("ETag", entityTag);
+            response.set_header("Last-Modified", Util::Http::formatHttpDate(servedStat.mtimeSeconds));
+            response.set_header("Content-Disposition", Core::buildContentDispositionHeader(canonicalTarget.filename().string()));
+            return;
+        }
+
+        if (!targetIsDirectory)
+        {
+            setPlainTextResponse(response, HTTP_STATUS_NOT_FOUND, "Entry not found");
+            return;
+        }
+
+        // The directory is read before anything is sent: its entries make up the validators, and a failure
+        // can still be answered with an error status.
+        auto stream = std::make_shared<ListingStream>();
+        try
+        {
+            stream->entries = listingCache->get(canonicalTarget, targetStat, loadEntries);
+        }
+        catch (const std::exception &)
+        {
+            setPlainTextResponse(response, HTTP_STATUS_INTERNAL_SERVER_ERROR, "Failed to read directory");
+            return;
+        }
+
+        // The paged and the complete view are different representations, so they get different validators.
+        const bool showAll = request.get_param_value("view") == "all";
+        const auto [listingDigest, latestEntry] = summarizeListing(*stream->entries, listingGeneration * 2U + (showAll ? 1U : 0U));
+        const std::string listingTag = Util::Http::buildEntityTag(targetStat, true, listingDigest);
+        const std::int64_t lastModified = std::max(targetStat.mtimeSeconds, latestEntry);
+        response.set_header("Vary", "Accept-Encoding");
+        if (Core::respondIfNotModified(request, response, listingTag, lastModified))
+        {
+            return;
+        }
+
+        stream->rowCount = showAll ? stream->entries->size() : std::min(stream->entries->size(), listingPageSize);
+        stream->relativePath = relativePath;
+
+        const auto encoding = negotiateResponseEncoding(request, Util::Compression::availableEncodings());
+        if (encoding != Util::Compression::Encoding::Identity && stream->encoder.open(encoding))
+        {
+            response.set_header("Content-Encoding", std::string{Util::Compression::encodingToken(encoding)});
+        }
+
+        response.set_header("ETag", listingTag);
+        response.set_header("Last-Modified", Util::Http::formatHttpDate(lastModified));
+        response.set_header("Cache-Control", "no-cache");
+
+        // The page head goes out first and is flushed, so the browser can lay out the page while the rows
+        // follow in bounded batches.
+        response.set_chunked_content_provider(
+            "text/html",
+            [stream, uploadsEnabled](std::size_t, httplib::DataSink &sink) {
+                switch (stream->stage)
+                {
+                case ListingStream::Stage::Head:
+                {
+                    stream->stage = ListingStream::Stage::Rows;
+                    if (!writeResource(*stream, sink, resources::indexHtmlBeforeUpload)
+                        || (uploadsEnabled && !writeResource(*stream, sink, resources::uploadHtml))
+                        || !writeResource(*stream, sink, resources::indexHtmlBeforeFiles))
+                    {
+                        return false;
+                    }
+
+                    std::string chunk = "<ul>\n";
+                    if (!stream->relativePath.empty())
+                    {
+                        const std::string parentPath = fs::path(stream->relativePath).parent_path().generic_string();
+                        chunk += "<li><a href=\"" + Util::File::buildHrefForPath(parentPath) + "\">↩ ../</a></li>\n";
+                    }
+                    // Flushed so a compressing encoder does not hold the head back behind the rows.
+                    return writeListing(*stream, sink, chunk.data(), chunk.size(), true);
+                }
+                case ListingStream::Stage::Rows:
+                {
+                    std::string chunk;
+                    const ListingCache::Entries &entries = *stream->entries;
+                    while (stream->nextRow < stream->rowCount && chunk.size() < listingChunkBytes)
+                    {
+                        appendListingRow(chunk, stream->relativePath, entries[stream->nextRow]);
+                        ++stream->nextRow;
+                    }
+
+                    if (stream->nextRow == stream->rowCount)
+                    {
+                        stream->stage = ListingStream::Stage::Tail;
+                        if (stream->rowCount < entries.size())
+                        {
+                            // The page script continues from here through /api/list; without scripts the link shows everything.
+                            const std::string total = std::to_string(entries.size());
+                            const std::string cursor = encodeListingCursor(entries[stream->rowCount - 1], ListingSort::Name);
+                            chunk += "<li class=\"files__more\" data-path=\"" + Util::File::escapeForHtml(stream->relativePath) + "\" data-cursor=\""
+                                     + Util::File::escapeForHtml(cursor) + "\" data-total=\"" + total + "\"><a href=\"?view=all\">Show all "
+                                     + total + " entries</a></li>\n";
+                        }
+                    }
+
+                    return writeListing(*stream, sink, chunk.data(), chunk.size(), true);
+                }
+                case ListingStream::Stage::Tail:
+                {
+                    if (!writeListing(*stream, sink, "</ul>\n", 6) || !writeResource(*stream, sink, resources::indexHtmlAfterFiles)
+                        || (stream->encoder.isOpen() && !stream->encoder.finish(sink.write)))
+                    {
+                        return false;
+                    }
+                    sink.done();
+                    return true;
+                }
+                }
+                return false;
+            });
+    };
+
+    httpServer->Post("/auth", [sessionTokens, password](const httplib::Request &request, httplib::Response &response) {
+        if (!sessionTokens)
+        {
+            setPlainTextResponse(response, HTTP_STATUS_OK, "Auth disabled");
+            return;
+        }
+
+        if (Util::Checksum::equalConstantTime(request.body, password))
+        {
+            // The same token works as the browser's cookie and, taken from the body, as a bearer token.
+            const std::string token = sessionTokens->issue();
+            response.set_header("Set-Cookie", std::string{sessionCookieName} + "=" + token + "; Path=/; Max-Age="
+                                                  + std::to_string(sessionTokens->lifetime().count()) + "; HttpOnly; SameSite=Lax");
+            response.set_header("Cache-Control", "no-store");
+            setPlainTextResponse(response, HTTP_STATUS_OK, token);
+            return;
+        }
+
+        setPlainTextResponse(response, HTTP_STATUS_UNAUTHORIZED, "Unauthorized");
+    });
+
+    httpServer->Get("/api/sign", [requireAuth, sessionTokens](const httplib::Request &request, httplib::Response &response) {
+        if (!requireAuth(request, response))
+        {
+            return;
+        }
+        if (!sessionTokens)
+        {
+            setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Auth disabled; URLs need no signature");
+            return;
+        }
+
+        // Only downloads and listings can be signed, so a signed URL never reaches this endpoint or uploads.
+        const std::string path = request.get_param_value("path");
+        if (!path.starts_with('/') || path.starts_with("/api/") || path == "/auth" || path == "/upload" || path.starts_with("/upload/"))
+        {
+            setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid path");
+            return;
+        }
+
+        std::chrono::seconds validFor = std::min(signedUrlDefaultLifetime, sessionTokens->lifetime());
+        if (request.has_param("ttl"))
+        {
+            std::uint64_t seconds = 0;
+            if (!parseUploadNumber(request.get_param_value("ttl"), seconds) || seconds == 0
+                || seconds > static_cast<std::uint64_t>(sessionTokens->lifetime().count()))
+            {
+                setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid ttl");
+                return;
+            }
+            validFor = std::chrono::seconds{seconds};
+        }
+
+        std::string url;
+        for (std::size_t start = 1; start <= path.size();)
+        {
+            const std::size_t end = std::min(path.find('/', start), path.size());
+            url += "/" + Util::File::urlEncode(std::string_view{path}.substr(start, end - start));
+            start = end + 1;
+        }
+        setPlainTextResponse(response, HTTP_STATUS_OK, url + "?" + sessionTokens->signPath(path, validFor));
+    });
+
+    httpServer->Get("/api/stats", [requireAuth, listingCache, pathResolver, uploadStore, uploadAdmission, workerPool](const httplib::Request &request, httplib::Response &response) {
+        if (!requireAuth(request, response))
+        {
+            return;
+        }
+
+        const ListingCache::Stats cacheStats = listingCache->stats();
+        std::string body = "{\"listingCache\":{";
+        body += "\"hits\":" + std::to_string(cacheStats.hits);
+        body += ",\"misses\":" + std::to_string(cacheStats.misses);
+        body += ",\"invalidations\":" + std::to_string(cacheStats.invalidations);
+        body += ",\"evictions\":" + std::to_string(cacheStats.evictions);
+        body += ",\"directories\":" + std::to_string(cacheStats.cachedDirectories);
+        body += ",\"bytes\":" + std::to_string(cacheStats.cachedBytes);
+        body += ",\"budgetBytes\":" + std::to_string(cacheStats.budgetBytes);
+        body += std::string{",\"inotify\":"} + (cacheStats.watcherActive ? "true" : "false");
+        body += "}";
+
+        // direct counts paths resolved by one openat2 call, canonicalised those that took the full walk.
+        const PathResolver::Stats pathStats = pathResolver->stats();
+        body += ",\"paths\":{";
+        body += std::string{"\"openat2\":"} + (pathStats.openat2 ? "true" : "false");
+        body += ",\"direct\":" + std::to_string(pathStats.direct);
+        body += ",\"canonicalised\":" + std::to_string(pathStats.canonicalised);
+        body += ",\"missing\":" + std::to_string(pathStats.missing);
+        body += "}";
+
+        body += ",\"workers\":";
+        if (workerPool)
+        {
+            const WorkerPool::Stats workerStats = workerPool->stats();
+            body += "{\"threads\":" + std::to_string(workerStats.workers);
+            body += ",\"busy\":" + std::to_string(workerStats.busy);
+            body += ",\"queued\":" + std::to_string(workerStats.queued);
+            body += ",\"served\":" + std::to_string(workerStats.served);
+            body += ",\"rejectedQueueFull\":" + std::to_string(workerStats.rejectedQueueFull);
+            body += ",\"rejectedPerIp\":" + std::to_string(workerStats.rejectedPerAddress);
+            body += "}";
+        }
+        else
+        {
+            body += "null";
+        }
+
+        body += ",\"uploads\":";
+        if (uploadAdmission)
+        {
+            const UploadAdmission::Stats admissionStats = uploadAdmission->stats();
+            body += "{\"writers\":" + std::to_string(admissionStats.writers);
+            body += ",\"pendingBytes\":" + std::to_string(admissionStats.pendingBytes);
+            body += ",\"admitted\":" + std::to_string(admissionStats.admitted);
+            body += ",\"rejectedBusy\":" + std::to_string(admissionStats.rejectedBusy);
+            body += ",\"rejectedNoSpace\":" + std::to_string(admissionStats.rejectedNoSpace);
+            body += "}";
+        }
+        else
+        {
+            body += "null";
+        }
+
+        body += ",\"dedup\":";
+        if (uploadStore)
+        {
+            const UploadStore::Stats storeStats = uploadStore->stats();
+            body += "{\"stored\":" + std::to_string(storeStats.stored);
+            body += ",\"duplicates\":" + std::to_string(storeStats.duplicates);
+            body += ",\"earlyFinishes\":" + std::to_string(storeStats.earlyFinishes);
+            body += ",\"bytesSaved\":" + std::to_string(storeStats.bytesSaved);
+            body += "}";
+        }
+        else
+        {
+            body += "null";
+        }
+        body += "}";
+        setCompressibleContent(request, response, std::move(body), "application/json");
+    });
+
+    httpServer->Get("/api/list", [requireAuth, resolveEntry, listingCache, loadEntries, listingLess](const httplib::Request &request, httplib::Response &response) {
+        if (!requireAuth(request, response))
+        {
+            return;
+        }
+
+        const std::string relativePath = Util::File::normalizeRelativePath(request.get_param_value("path"));
+        const auto [resolveStatus, canonicalTarget, targetStat] = resolveEntry(relativePath);
+        if (resolveStatus == HTTP_STATUS_FORBIDDEN)
+        {
+            setPlainTextResponse(response, HTTP_STATUS_FORBIDDEN, "Access denied");
+            return;
+        }
+
+        if (resolveStatus != HTTP_STATUS_OK || !targetStat.isDirectory)
+        {
+            setPlainTextResponse(response, HTTP_STATUS_NOT_FOUND, "Directory not found");
+            return;
+        }
+
+        ListingSort sort = ListingSort::Name;
+        const std::string sortValue = request.get_param_value("sort");
+        if (sortValue == "size")
+        {
+            sort = ListingSort::Size;
+        }
+        else if (sortValue == "mtime")
+        {
+            sort = ListingSort::Modified;
+        }
+        else if (!sortValue.empty() && sortValue != "name")
+        {
+            setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid sort (expected name, size or mtime)");
+            return;
+        }
+
+        const std::string orderValue = request.get_param_value("order");
+        if (!orderValue.empty() && orderValue != "asc" && orderValue != "desc")
+        {
+            setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid order (expected asc or desc)");
+            return;
+        }
+        const bool descending = orderValue == "desc";
+
+        const std::string typeValue = request.get_param_value("type");
+        if (!typeValue.empty() && typeValue != "all" && typeValue != "file" && typeValue != "dir")
+        {
+            setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid type (expected all, file or dir)");
+            return;
+        }
+
+        std::size_t limit = listingApiDefaultLimit;
+        if (const std::string limitValue = request.get_param_value("limit"); !limitValue.empty())
+        {
+            try
+            {
+                std::size_t parsed = 0;
+                limit = std::stoul(limitValue, &parsed, 10);
+                if (parsed != limitValue.size() || limit == 0)
+                {
+                    throw std::invalid_argument("limit");
+                }
+            }
+            catch (const std::exception &)
+            {
+                setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid limit");
+                return;
+            }
+            limit = std::min(limit, listingApiMaxLimit);
+        }
+
+        const std::string cursorValue = request.get_param_value("cursor");
+        const auto [cursorOk, cursorEntry] = decodeListingCursor(cursorValue, sort);
+        if (!cursorValue.empty() && !cursorOk)
+        {
+            setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid cursor");
+            return;
+        }
+
+        std::shared_ptr<const ListingCache::Entries> entries;
+        try
+        {
+            entries = listingCache->get(canonicalTarget, targetStat, loadEntries);
+        }
+        catch (const std::exception &)
+        {
+            setPlainTextResponse(response, HTTP_STATUS_INTERNAL_SERVER_ERROR, "Failed to read directory");
+            return;
+        }
+
+        const std::string filter = request.get_param_value("filter");
+        std::vector<const ListingCache::Entry *> view;
+        view.reserve(entries->size());
+        for (const auto &entry : *entries)
+        {
+            if ((typeValue == "file" && entry.isDirectory) || (typeValue == "dir" && !entry.isDirectory))
+            {
+                continue;
+            }
+            if (!filter.empty() && !containsCaseInsensitive(entry.name, filter))
+            {
+                continue;
+            }
+            view.push_back(&entry);
+        }
+
+        const auto less = [sort, descending, &listingLess](const ListingCache::Entry *lhs, const ListingCache::Entry *rhs) {
+            return listingLess(*lhs, *rhs, sort, descending);
+        };
+
+        // Cached entries are already in ascending name order.
+        if (sort != ListingSort::Name || descending)
+        {
+            std::sort(view.begin(), view.end(), less);
+        }
+
+        auto first = view.begin();
+        if (cursorOk)
+        {
+            first = std::upper_bound(view.begin(), view.end(), &cursorEntry, less);
+        }
+        const auto last = first + static_cast<std::ptrdiff_t>(std::min<std::size_t>(limit, static_cast<std::size_t>(view.end() - first)));
+
+        std::string body = "{\"path\":\"" + Util::String::escapeForJson(relativePath) + "\"";
+        body += ",\"total\":" + std::to_string(view.size());
+        body += ",\"entries\":[";
+        for (auto it = first; it != last; ++it)
+        {
+            const ListingCache::Entry &entry = **it;
+            if (it != first)
+            {
+                body.push_back(',');
+            }
+            body += "{\"name\":\"" + Util::String::escapeForJson(entry.name) + "\"";
+            body += entry.isDirectory ? ",\"type\":\"dir\"" : ",\"type\":\"file\"";
+            body += ",\"size\":" + std::to_string(entry.fileSize);
+            body += ",\"mtime\":" + std::to_string(entry.modified) + "}";
+        }
+        body += "],\"nextCursor\":";
+        if (last != view.end() && last != first)
+        {
+            body += "\"" + Util::String::escapeForJson(encodeListingCursor(**(last - 1), sort)) + "\"";
+        }
+        else
+        {
+            body += "null";
+        }
+        body += "}";
+
+        response.set_header("Cache-Control", "no-cache");
+        setCompressibleContent(request, response, std::move(body), "application/json");
+    });
+
+    if (uploadsEnabled)
+    {
+        httpServer->Post(
+            "/upload",
+            [uploadNames, uploadStore, admitUpload, stagingDir, uploadWriteMode = tuning.uploadWriteMode](const httplib::Request &request, httplib::Response &response, const httplib::ContentReader &content_reader) {
+                if (!request.is_multipart_form_data())
+                {
+                    setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid multipart payload");
+                    return;
+                }
+
+                // The whole body is reserved; the few bytes of multipart framing make no difference.
+                std::uint64_t expectedSize = 0;
+                if (!parseUploadNumber(request.get_header_value("Content-Length"), expectedSize))
+                {
+                    expectedSize = 0;
+                }
+                UploadAdmission::Ticket ticket;
+                if (!admitUpload(expectedSize, response, ticket))
+                {
+                    return;
+                }
+
+                enum class UploadError
+                {
+                    None,
+                    BadRequest,
+                    NoSpace,
+                    Internal
+                };
+
+                UploadError error = UploadError::None;
+                std::string errorMessage;
+
+                Util::FileWriter currentFile;
+                bool currentIsFile = false;
+                fs::path currentStaged;
+                std::string currentName;
+                Util::Checksum::Crc32c currentChecksum;
+                Util::Checksum::Sha256 currentHash;
+                bool hasFiles = false;
+                std::vector<std::string> savedNames;
+
+                auto fail = [&](UploadError type, std::string message) {
+                    if (error == UploadError::None)
+                    {
+                        error = type;
+                        errorMessage = std::move(message);
+                    }
+                    return false;
+                };
+
+                auto writeFailure = [&]() {
+                    return fail(currentFile.outOfSpace() ? UploadError::NoSpace : UploadError::Internal,
+                                currentFile.outOfSpace() ? "Insufficient storage" : "Failed to save file");
+                };
+
+                // Each part is written to the staging directory and only appears under its name once it is
+                // complete; a part cut short by an error or a dropped connection is discarded.
+                auto closeCurrent = [&](bool keep) {
+                    bool closed = true;
+                    if (currentFile.isOpen() && !currentFile.close())
+                    {
+                        closed = writeFailure();
+                    }
+                    if (currentIsFile && closed && keep)
+                    {
+                        Util::Checksum::storeCrc32c(currentStaged, currentChecksum.value());
+                        auto [committed, destination, commitError] =
+                            uploadStore ? uploadStore->commit(currentStaged, currentName, currentHash.finish(), currentFile.size())
+                                        : uploadNames->commit(currentStaged, currentName);
+                        if (committed)
+                        {
+                            savedNames.push_back(destination.filename().string());
+                        }
+                        else
+                        {
+                            closed = fail(UploadError::Internal, commitError.empty() ? "Failed to save file" : commitError);
+                        }
+                    }
+                    if (currentIsFile && (!closed || !keep))
+                    {
+                        std::error_code removeEc;
+                        fs::remove(currentStaged, removeEc);
+                    }
+                    currentIsFile = false;
+                    return closed;
+                };
+
+                bool ok = content_reader(
+                    [&](const UploadPartType &file) {
+                        if (!closeCurrent(true))
+                        {
+                            return false;
+                        }
+                        const std::string fileName = file.filename;
+                        if (fileName.empty())
+                        {
+                            return true;
+                        }
+
+                        const auto [nameOk, sanitizedName] = Util::File::sanitizeUploadFilename(fileName);
+                        if (!nameOk)
+                        {
+                            return fail(UploadError::BadRequest, "Invalid file name");
+                        }
+
+                        currentStaged = Util::File::makeStagingPath(stagingDir);
+                        if (!currentFile.open(currentStaged, 0, uploadWriteMode))
+                        {
+                            std::error_code removeEc;
+                            fs::remove(currentStaged, removeEc);
+                            return writeFailure();
+                        }
+
+                        currentName = sanitizedName;
+                        currentChecksum = Util::Checksum::Crc32c{};
+                        currentHash = Util::Checksum::Sha256{};
+                        currentIsFile = true;
+                        hasFiles = true;
+                        return true;
+                    },
+                    [&](const char *data, size_t dataLength) {
+                        if (!currentIsFile)
+                        {
+                            return true;
+                        }
+
+                        currentChecksum.update(data, dataLength);
+                        if (uploadStore)
+                        {
+                            currentHash.update(data, dataLength);
+                        }
+                        if (!currentFile.write(data, dataLength))
+                        {
+                            return writeFailure();
+                        }
+                        ticket.allocated(dataLength);
+                        return true;
+                    });
+
+                closeCurrent(ok && error == UploadError::None);
+
+                if (!ok || error != UploadError::None)
+                {
+                    int status = HTTP_STATUS_INTERNAL_SERVER_ERROR;
+                    if (error == UploadError::BadRequest)
+                    {
+                        status = HTTP_STATUS_BAD_REQUEST;
+                    }
+                    else if (error == UploadError::NoSpace)
+                    {
+                        status = HTTP_STATUS_INSUFFICIENT_STORAGE;
+                    }
+                    if (errorMessage.empty())
+                    {
+                        errorMessage = "Upload failed";
+                    }
+                    setPlainTextResponse(response, status, errorMessage);
+                    return;
+                }
+
+                if (!hasFiles)
+                {
+                    setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "No files provided");
+                    return;
+                }
+
+                std::string responseBody = "Uploaded files:\n";
+                for (const auto &name : savedNames)
+                {
+                    responseBody += name;
+                    responseBody.push_back('\n');
+                }
+
+                setPlainTextResponse(response, HTTP_STATUS_OK, responseBody);
+            });
+
+        // Resumable uploads: POST creates a session, PATCH sends one chunk at Upload-Offset, GET/HEAD report
+        // which chunks arrived and DELETE abandons the upload.
+        const auto uploadSessions = std::make_shared<UploadSessions>(uploadNames, uploadStore, stagingDir, uploadChunkBytes, uploadSessionIdleTimeout);
+        const std::string sessionPattern = R"(/upload/sessions/([A-Za-z0-9]+))";
+
+        httpServer->Post("/upload/sessions", [requireAuth, uploadSessions, uploadStore, uploadAdmission](const httplib::Request &request, httplib::Response &response) {
+            if (!requireAuth(request, response))
+            {
+                return;
+            }
+
+            const auto [nameOk, sanitizedName] = Util::File::sanitizeUploadFilename(request.get_param_value("name"));
+            if (!nameOk)
+            {
+                setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid file name");
+                return;
+            }
+
+            std::uint64_t length = 0;
+            if (!parseUploadNumber(request.get_header_value("Upload-Length"), length))
+            {
+                setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid Upload-Length");
+                return;
+            }
+
+            std::optional<std::uint32_t> checksum;
+            if (!parseUploadChecksum(request, checksum))
+            {
+                setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Upload-Checksum must be 'crc32c <base64>'");
+                return;
+            }
+
+            // Content the store already holds needs no data sent; the client learns so from a 200 without
+            // a Location. An unknown or malformed digest just starts an ordinary upload.
+            if (uploadStore && request.has_header("Repr-Digest"))
+            {
+                const auto [digestOk, digest] = Util::Checksum::parseSha256(request.get_header_value("Repr-Digest"));
+                if (digestOk)
+                {
+                    auto [committed, destination, commitError] = uploadStore->commitKnown(sanitizedName, digest, length);
+                    if (committed)
+                    {
+                        response.set_header("Upload-Offset", std::to_string(length));
+                        response.set_header("Upload-Length", std::to_string(length));
+                        setPlainTextResponse(response, HTTP_STATUS_OK, "Uploaded files:\n" + destination.filename().string() + "\n");
+                        return;
+                    }
+                }
+            }
+
+            // The length is held against the free space until the session has preallocated its file; each
+            // chunk then takes a writer slot. Where the file could not be preallocated, the chunks are
+            // admitted with their own lengths instead.
+            auto [reserved, reservation] = uploadAdmission->reserve(length);
+            if (!reserved)
+            {
+                response.set_header("Retry-After", std::to_string(UploadAdmission::noSpaceRetryAfter.count()));
+                setPlainTextResponse(response, HTTP_STATUS_INSUFFICIENT_STORAGE, "Insufficient storage");
+                return;
+            }
+
+            const auto [outcome, id, error] = uploadSessions->create(sanitizedName, length, checksum);
+            if (outcome != UploadSessions::Outcome::Ok)
+            {
+                setPlainTextResponse(response, uploadOutcomeStatus(outcome), error);
+                return;
+            }
+
+            const std::string location = "/upload/sessions/" + id;
+            response.set_header("Location", location);
+            response.set_header("Upload-Offset", "0");
+            response.set_header("Upload-Length", std::to_string(length));
+            response.set_header("Upload-Chunk-Size", std::to_string(uploadChunkBytes));
+            response.status = HTTP_STATUS_CREATED;
+            response.set_content("{\"location\":\"" + location + "\",\"chunkSize\":" + std::to_string(uploadChunkBytes) + "}", "application/json");
+        });
+
+        httpServer->Get(sessionPattern, [requireAuth, uploadSessions](const httplib::Request &request, httplib::Response &response) {
+            if (!requireAuth(request, response))
+            {
+                return;
+            }
+
+            const auto [outcome, status] = uploadSessions->status(request.matches[1].str());
+            if (outcome != UploadSessions::Outcome::Ok)
+            {
+                setPlainTextResponse(response, uploadOutcomeStatus(outcome), "Upload not found");
+                return;
+            }
+
+            setUploadStatus(response, status);
+            std::string body = "{\"length\":" + std::to_string(status.length);
+            body += ",\"chunkSize\":" + std::to_string(status.chunkSize);
+            body += ",\"offset\":" + std::to_string(status.offset);
+            body += ",\"received\":\"" + status.receivedChunks + "\"";
+            body += std::string{",\"complete\":"} + (status.complete ? "true" : "false");
+            if (status.complete)
+            {
+                body += ",\"fileName\":\"" + Util::String::escapeForJson(status.fileName) + "\"";
+            }
+            body += "}";
+            response.set_content(std::move(body), "application/json");
+        });
+
+        httpServer->Patch(sessionPattern, [requireAuth, uploadSessions, admitUpload](const httplib::Request &request, httplib::Response &response, const httplib::ContentReader &content_reader) {
+            if (!requireAuth(request, response))
+            {
+                return;
+            }
+
+            std::uint64_t offset = 0;
+            std::uint64_t length = 0;
+            if (!parseUploadNumber(request.get_header_value("Upload-Offset"), offset)
+                || !parseUploadNumber(request.get_header_value("Content-Length"), length))
+            {
+                setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Upload-Offset and Content-Length are required");
+                return;
+            }
+
+            std::optional<std::uint32_t> checksum;
+            if (!parseUploadChecksum(request, checksum))
+            {
+                setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Upload-Checksum must be 'crc32c <base64>'");
+                return;
+            }
 
-                auto fail = [&](UploadError type, std::string message) {
-                    if (error == UploadError::None)
-                    {
-                        error = type;
-                        errorMessage = std::move(message);
-                    }
-                    return false;
-                };
+            const std::string id = request.matches[1].str();
+            UploadAdmission::Ticket ticket;
+            if (!admitUpload(uploadSessions->isPreallocated(id) ? 0 : length, response, ticket))
+            {
+                return;
+            }
 
-                auto closeCurrent = [&]() {
-                    if (currentFile.is_open())
-                    {
-                        currentFile.close();
-                    }
-                    currentIsFile = false;
-                };
+            const auto [outcome, status, error] = uploadSessions->writeChunk(id, offset, length, checksum, [&content_reader](const UploadSessions::Receiver &receive) {
+                return content_reader(receive);
+            });
+            if (outcome != UploadSessions::Outcome::Ok)
+            {
+                if (outcome == UploadSessions::Outcome::Busy)
+                {
+                    response.set_header("Retry-After", "1");
+                }
+                setPlainTextResponse(response, uploadOutcomeStatus(outcome), error);
+                return;
+            }
 
-                bool ok = content_reader(
-                    [&](const UploadPartType &file) {
-                        closeCurrent();
-                        const std::string fileName = file.filename;
-                        if (fileName.empty())
-                        {
-                            return true;
-                        }
+            setUploadStatus(response, status);
+            if (status.complete)
+            {
+                response.set_header("Upload-Checksum", Util::Checksum::formatCrc32c(status.checksum));
+                setPlainTextResponse(response, HTTP_STATUS_OK, "Uploaded files:\n" + status.fileName + "\n");
+                return;
+            }
+            response.status = HTTP_STATUS_NO_CONTENT;
+        });
 
-                        const auto [nameOk, sanitizedName] = Util::File::sanitizeUploadFilename(fileName);
-                        if (!nameOk)
-                        {
-                            return fail(UploadError::BadRequest, "Invalid file name");
-                        }
+        httpServer->Delete(sessionPattern, [requireAuth, uploadSessions](const httplib::Request &request, httplib::Response &response) {
+            if (!requireAuth(request, response))
+            {
+                return;
+            }
 
-                        auto [destinationOk, destination, destinationError] =
-                            Util::File::chooseUploadDestination(uploadsDir, sanitizedName);
-                        if (!destinationOk)
-                        {
-                            return fail(UploadError::Internal, destinationError.empty() ? "Failed to save file" : destinationError);
-                        }
+            if (!uploadSessions->remove(request.matches[1].str()))
+            {
+                setPlainTextResponse(response, HTTP_STATUS_NOT_FOUND, "Upload not found");
+                return;
+            }
+            response.status = HTTP_STATUS_NO_CONTENT;
+        });
 
-                        currentFile.open(destination, std::ios::binary);
-                        if (!currentFile)
-                        {
-                            return fail(UploadError::Internal, "Failed to save file");
-                        }
+        // The raw request body is the file (`curl -T file http://host/upload/`), so nothing has to be parsed.
+        httpServer->Put(R"(/upload/([^/]+))", [requireAuth, uploadNames, uploadStore, admitUpload, stagingDir, uploadWriteMode = tuning.uploadWriteMode](const httplib::Request &request, httplib::Response &response, const httplib::ContentReader &content_reader) {
+            if (!requireAuth(request, response))
+            {
+                return;
+            }
 
-                        currentIsFile = true;
-                        hasFiles = true;
-                        savedNames.push_back(destination.filename().string());
-                        return true;
-                    },
-                    [&](const char *data, size_t dataLength) {
-                        if (!currentIsFile)
-                        {
-                            return true;
-                        }
+            const auto [nameOk, sanitizedName] = Util::File::sanitizeUploadFilename(request.matches[1].str());
+            if (!nameOk)
+            {
+                setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Invalid file name");
+                return;
+            }
 
-                        currentFile.write(data, static_cast<std::streamsize>(dataLength));
-                        if (!currentFile)
-                        {
-                            return fail(UploadError::Internal, "Failed to save file");
-                        }
-                        return true;
-                    });
+            std::optional<std::uint32_t> checksum;
+            if (!parseUploadChecksum(request, checksum))
+            {
+                setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "Upload-Checksum must be 'crc32c <base64>'");
+                return;
+            }
 
-                closeCurrent();
+            // A chunked body has no Content-Length; it is then written without a reservation.
+            std::uint64_t expectedSize = 0;
+            if (!parseUploadNumber(request.get_header_value("Content-Length"), expectedSize))
+            {
+                expectedSize = 0;
+            }
+            UploadAdmission::Ticket ticket;
+            if (!admitUpload(expectedSize, response, ticket))
+            {
+                return;
+            }
 
-                if (!ok || error != UploadError::None)
+            const fs::path staged = Util::File::makeStagingPath(stagingDir);
+            Util::FileWriter writer;
+            if (!writer.open(staged, expectedSize, uploadWriteMode))
+            {
+                std::error_code removeEc;
+                fs::remove(staged, removeEc);
+                setPlainTextResponse(response, writer.outOfSpace() ? HTTP_STATUS_INSUFFICIENT_STORAGE : HTTP_STATUS_INTERNAL_SERVER_ERROR,
+                                     writer.outOfSpace() ? "Insufficient storage" : "Failed to save file");
+                return;
+            }
+            ticket.allocated(writer.reservedSize());
+
+            // The digest is taken as the body streams past, so checking it needs no second read of the file.
+            Util::Checksum::Crc32c crc;
+            Util::Checksum::Sha256 contentHash;
+            bool writeFailed = false;
+            const bool readOk = content_reader([&writer, &writeFailed, &crc, &contentHash, &ticket, hashContent = uploadStore != nullptr](const char *data, size_t dataLength) {
+                crc.update(data, dataLength);
+                if (hashContent)
                 {
-                    int status = error == UploadError::BadRequest ? HTTP_STATUS_BAD_REQUEST : HTTP_STATUS_INTERNAL_SERVER_ERROR;
-                    if (errorMessage.empty())
-                    {
-                        errorMessage = "Upload failed";
-                    }
-                    setPlainTextResponse(response, status, errorMessage);
-                    return;
+                    contentHash.update(data, dataLength);
                 }
+                writeFailed = !writer.write(data, dataLength);
+                ticket.allocated(dataLength);
+                return !writeFailed;
+            });
+            const bool closeOk = writer.close();
 
-                if (!hasFiles)
+            if (!readOk || writeFailed || !closeOk)
+            {
+                std::error_code removeEc;
+                fs::remove(staged, removeEc);
+                // A refused write also stops the reader, so only a reader failure of its own is the client's.
+                const bool clientFailed = !readOk && !writeFailed && closeOk;
+                if (writer.outOfSpace())
                 {
-                    setPlainTextResponse(response, HTTP_STATUS_BAD_REQUEST, "No files provided");
+                    setPlainTextResponse(response, HTTP_STATUS_INSUFFICIENT_STORAGE, "Insufficient storage");
                     return;
                 }
+                setPlainTextResponse(response, clientFailed ? HTTP_STATUS_BAD_REQUEST : HTTP_STATUS_INTERNAL_SERVER_ERROR,
+                                     clientFailed ? "Upload failed" : "Failed to save file");
+                return;
+            }
 
-                std::string responseBody = "Uploaded files:\n";
-                for (const auto &name : savedNames)
-                {
-                    responseBody += name;
-                    responseBody.push_back('\n');
-                }
+            if (checksum && *checksum != crc.value())
+            {
+                std::error_code removeEc;
+                fs::remove(staged, removeEc);
+                setPlainTextResponse(response, HTTP_STATUS_CHECKSUM_MISMATCH, "Checksum mismatch");
+                return;
+            }
 
-                setPlainTextResponse(response, HTTP_STATUS_OK, responseBody);
-            });
+            Util::Checksum::storeCrc32c(staged, crc.value());
+            auto [committed, destination, commitError] = uploadStore ? uploadStore->commit(staged, sanitizedName, contentHash.finish(), writer.size())
+                                                                     : uploadNames->commit(staged, sanitizedName);
+            if (!committed)
+            {
+                std::error_code removeEc;
+                fs::remove(staged, removeEc);
+                setPlainTextResponse(response, HTTP_STATUS_INTERNAL_SERVER_ERROR, commitError.empty() ? "Failed to save file" : commitError);
+                return;
+            }
+
+            response.set_header("Upload-Checksum", Util::Checksum::formatCrc32c(crc.value()));
+            setPlainTextResponse(response, HTTP_STATUS_CREATED, "Uploaded files:\n" + destination.filename().string() + "\n");
+        });
     }
 
+    httpServer->Get(R"(/.*)", [requireAuth, handleEntryRequest](const httplib::Request &request, httplib::Response &response) {
+        if (!requireAuth(request, response))
+        {
+            return;
+        }
+        handleEntryRequest(request, response);
+    });
+
+    httpServer->set_pre_routing_handler([this, requireAuth, handleEntryRequest, uploadsEnabled, workerPool](const httplib::Request &request, httplib::Response &response) {
+        if (workerPool && !workerPool->admitConnection(request.remote_addr))
+        {
+            response.set_header("Connection", "close");
+            response.set_header("Retry-After", "1");
+            setPlainTextResponse(response, HTTP_STATUS_SERVICE_UNAVAILABLE, "Too many connections");
+            return httplib::Server::HandlerResponse::Handled;
+        }
+
+        // Upload sessions answer HEAD through their GET route.
+        const bool uploadSessionPath = uploadsEnabled && request.path.rfind("/upload/sessions/", 0) == 0;
+        if (request.method == "HEAD" && !uploadSessionPath)
+        {
+            if (!requireAuth(request, response))
+            {
+                return httplib::Server::HandlerResponse::Handled;
+            }
+
+            handleEntryRequest(request, response);
+            response.body.clear();
+            return httplib::Server::HandlerResponse::Handled;
+        }
+
+        return httplib::Server::HandlerResponse::Unhandled;
+    });
+
     const std::string listenerHost = host.empty() ? std::string{"0.0.0.0"} : host;
     unsigned short boundPort = port;
     bool boundOk = false;
@@ -672,28 +1951,6 @@ void Core::printLine(bool colorEnabled, const std::string &label, const std::str
     std::cout << valuePrefix << value << valueSuffix << std::endl;
 }
 
-bool Core::isAuthorized(const std::string &ip) const
-{
-    if (!authRequired.load())
-    {
-        return true;
-    }
-
-    std::lock_guard<std::mutex> guard(authMutex);
-    return authorizedIps.find(ip) != authorizedIps.end();
-}
-
-void Core::authorizeIp(const std::string &ip)
-{
-    if (ip.empty())
-    {
-        return;
-    }
-
-    std::lock_guard<std::mutex> guard(authMutex);
-    authorizedIps.insert(ip);
-}
-
 void Core::setPlainTextResponse(httplib::Response &response, int status, std::string_view body)
 {
     response.status = status;
@@ -717,235 +1974,71 @@ std::string Core::buildContentDispositionHeader(const std::string &filename)
     return header;
 }
 
-bool Core::streamFileResponse(httplib::Response &response, const fs::path &filePath)
+bool Core::respondIfNotModified(const httplib::Request &request,
+                                httplib::Response &response,
+                                const std::string &entityTag,
+                                std::int64_t lastModified)
 {
-    std::error_code ec;
-    const uintmax_t fileSize = fs::file_size(filePath, ec);
-    if (ec)
+    const std::string ifNoneMatch = request.get_header_value("If-None-Match");
+    const std::string ifModifiedSince = request.get_header_value("If-Modified-Since");
+    if (!Util::Http::isNotModified(ifNoneMatch, ifModifiedSince, entityTag, lastModified))
     {
         return false;
     }
 
-    if (fileSize > static_cast<uintmax_t>(std::numeric_limits<std::size_t>::max()))
+    response.status = HTTP_STATUS_NOT_MODIFIED;
+    response.set_header("ETag", entityTag);
+    response.set_header("Last-Modified", Util::Http::formatHttpDate(lastModified));
+    return true;
+}
+
+bool Core::streamFileResponse(httplib::Response &response, const fs::path &filePath, bool ignoreRanges)
+{
+    auto reader = std::make_shared<Util::FileReader>();
+    if (!reader->open(filePath))
     {
         return false;
     }
 
-    auto fileStream = std::make_shared<std::ifstream>(filePath, std::ios::binary);
-    if (!fileStream->is_open())
+    if (reader->size() > static_cast<uintmax_t>(std::numeric_limits<std::size_t>::max()))
     {
         return false;
     }
 
-    const std::size_t contentLength = static_cast<std::size_t>(fileSize);
+    // httplib answers ranged requests with 206 and slices the provider unless the handler set a status.
+    // An explicit 200 makes it frame the whole length; the provider then also sends the file from its start
+    // in one call whatever offset it is handed, so no range can cut the body short of that length.
+    const std::size_t contentLength = static_cast<std::size_t>(reader->size());
+    if (ignoreRanges)
+    {
+        response.status = HTTP_STATUS_OK;
+    }
     response.set_content_provider(
         contentLength,
         "application/octet-stream",
-        [fileStream](std::size_t offset, std::size_t length, httplib::DataSink &sink) {
-            if (length == 0)
-            {
-                return true;
-            }
-
-            if (!fileStream->good())
+        [reader, ignoreRanges, contentLength](std::size_t offset, std::size_t length, httplib::DataSink &sink) {
+            if (ignoreRanges)
             {
-                fileStream->clear();
+                offset = 0;
+                length = contentLength;
             }
-
-            fileStream->seekg(static_cast<std::streamoff>(offset), std::ios::beg);
-            if (!fileStream->good())
-            {
-                return false;
-            }
-
-            static constexpr std::size_t chunkSize = 64U * 1024U;
-            std::vector<char> buffer(chunkSize);
-            std::size_t remaining = length;
-            while (remaining > 0)
+            if (length == 0)
             {
-                const std::size_t toRead = std::min(remaining, buffer.size());
-                fileStream->read(buffer.data(), static_cast<std::streamsize>(toRead));
-                const std::streamsize readBytes = fileStream->gcount();
-                if (readBytes <= 0)
-                {
-                    return false;
-                }
-
-                if (!sink.write(buffer.data(), static_cast<std::size_t>(readBytes)))
-                {
-                    return false;
-                }
-
-                remaining -= static_cast<std::size_t>(readBytes);
+                return true;
             }
 
-            return true;
+            return reader->stream(offset, length, [&sink](const char *data, std::size_t dataLength) {
+                return sink.write(data, dataLength);
+            });
         },
-        [fileStream](bool) {
-            if (fileStream->is_open())
-            {
-                fileStream->close();
-            }
+        [reader](bool) {
+            reader->close();
         });
 
     return true;
 }
 
-bool Core::caseInsensitiveLess(const std::string &lhs, const std::string &rhs)
-{
-    const std::string lhsLower = Util::String::toLowerCopy(lhs);
-    const std::string rhsLower = Util::String::toLowerCopy(rhs);
-    if (lhsLower == rhsLower)
-    {
-        return lhs < rhs;
-    }
-    return lhsLower < rhsLower;
-}
-
-std::unordered_set<std::string> Core::normalizeExtensions(const std::vector<std::string> &extensions)
-{
-    std::unordered_set<std::string> result;
-    for (const auto &ext : extensions)
-    {
-        std::string normalized = ext;
-        std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
-        if (!normalized.empty() && normalized[0] != '.')
-        {
-            normalized = "." + normalized;
-        }
-        result.insert(normalized);
-    }
-    return result;
-}
-
-void Core::resolveDeniedPaths(const std::vector<std::string> &items,
-                              const fs::path &baseDir,
-                              std::unordered_set<std::string> &outFiles,
-                              std::vector<fs::path> &outDirs)
-{
-    for (const auto &pathStr : items)
-    {
-        fs::path candidate{baseDir / fs::path{pathStr}};
-        std::error_code fileEc;
-        const std::filesystem::path canonicalPath = fs::weakly_canonical(candidate, fileEc);
-        if (fileEc)
-        {
-            continue;
-        }
-
-        if (fs::is_directory(canonicalPath))
-        {
-            outDirs.push_back(canonicalPath);
-        }
-        else
-        {
-            outFiles.insert(canonicalPath.string());
-        }
-    }
-}
-
-void Core::resolveAllowedPaths(const std::vector<std::string> &items,
-                               const fs::path &baseDir,
-                               std::unordered_set<std::string> &outFiles,
-                               std::vector<fs::path> &outDirs,
-                               std::unordered_set<std::string> &outAncestors)
-{
-    Core::resolveDeniedPaths(items, baseDir, outFiles, outDirs);
-
-    for (const auto &pathStr : items)
-    {
-        fs::path candidate{baseDir / fs::path{pathStr}};
-        std::error_code fileEc;
-        const std::filesystem::path canonicalPath = fs::weakly_canonical(candidate, fileEc);
-        if (fileEc)
-        {
-            continue;
-        }
-
-        fs::path currentPath = canonicalPath;
-        while (true)
-        {
-            outAncestors.insert(currentPath.string());
-            if (currentPath == baseDir || !currentPath.has_parent_path())
-            {
-                break;
-            }
-            currentPath = currentPath.parent_path();
-        }
-    }
-}
-
-bool Core::isInList(const fs::path &canonicalPath,
-                    const std::unordered_set<std::string> &fileSet,
-                    const std::vector<fs::path> &dirList)
-{
-    if (!canonicalPath.empty() && fileSet.count(canonicalPath.string()))
-    {
-        return true;
-    }
-    for (const auto &dir : dirList)
-    {
-        if (Util::File::isWithinBase(canonicalPath, dir))
-        {
-            return true;
-        }
-    }
-    return false;
-}
-
-bool Core::isEntryAccessible(const fs::path &canonicalPath,
-                             bool isDirectory,
-                             const std::unordered_set<std::string> &allowedFiles,
-                             const std::vector<fs::path> &allowedDirs,
-                             const std::unordered_set<std::string> &allowedAncestors,
-                             const std::unordered_set<std::string> &deniedFiles,
-                             const std::vector<fs::path> &deniedDirs,
-                             const std::unordered_set<std::string> &normalizedAllowedExtensions,
-                             const std::unordered_set<std::string> &normalizedDeniedExtensions,
-                             bool hasAllowedExt,
-                             bool hasDeniedExt,
-                             bool hasAllowedFiles)
+bool Core::nameLess(const std::string &lhs, const std::string &rhs, bool natural)
 {
-    const bool deniedHit = isInList(canonicalPath, deniedFiles, deniedDirs);
-    if (deniedHit)
-    {
-        return false;
-    }
-
-    std::string ext = canonicalPath.extension().string();
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-    if (hasDeniedExt && normalizedDeniedExtensions.count(ext))
-    {
-        return false;
-    }
-
-    const bool allowedHit = isInList(canonicalPath, allowedFiles, allowedDirs);
-    const bool allowedAncestor = allowedAncestors.count(canonicalPath.string()) > 0;
-
-    if (hasAllowedFiles)
-    {
-        if (allowedHit)
-        {
-            return true;
-        }
-
-        if (isDirectory)
-        {
-            return allowedAncestor;
-        }
-
-        return false;
-    }
-
-    if (isDirectory)
-    {
-        return true;
-    }
-
-    if (hasAllowedExt)
-    {
-        return normalizedAllowedExtensions.count(ext) > 0;
-    }
-
-    return true;
+    return (natural ? Util::String::compareNatural(lhs, rhs) : Util::String::compareCaseInsensitive(lhs, rhs)) < 0;
 }
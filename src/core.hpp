@@ -1,20 +1,49 @@
 #pragma once
 
-#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <filesystem>
-#include <unordered_set>
+#include "utils/fileWriter.hpp"
 
 namespace httplib
 {
     class Server;
+    class Request;
     class Response;
 } // namespace httplib
 
+struct ServerTuning
+{
+    std::size_t listingCacheBytes = 64ULL * 1024ULL * 1024ULL;
+    unsigned statThreads = 1U;
+    bool naturalSort = false;
+    bool dedup = false;
+    // How long a sign-in lasts, and the file keeping the key that signs it; without a file the key lives
+    // only as long as the process.
+    unsigned sessionHours = 7U * 24U;
+    std::filesystem::path sessionKeyFile;
+    // Upload admission control; 0 leaves the writer count or the pending bytes unlimited.
+    unsigned uploadWriters = 8U;
+    std::uint64_t uploadPendingBytes = 0;
+    std::uint64_t uploadReserveBytes = 256ULL * 1024ULL * 1024ULL;
+    Util::FileWriter::Mode uploadWriteMode = Util::FileWriter::Mode::Cached;
+    // HTTP connections. 0 workers picks max(8, hardware threads - 1); a queue depth or per-IP cap of 0 is
+    // unlimited. Each connection holds a worker until it closes, so keep-alive and timeouts decide how long
+    // an idle or slow client can keep one.
+    unsigned workers = 0U;
+    std::size_t workerQueue = 0U;
+    unsigned connectionsPerIp = 0U;
+    unsigned keepAliveMax = 100U;
+    unsigned keepAliveSeconds = 5U;
+    unsigned readTimeoutSeconds = 5U;
+    unsigned writeTimeoutSeconds = 5U;
+};
+
 class Core
 {
 private:
@@ -38,7 +67,8 @@ public:
                const std::vector<std::string> &allowedExtensions = {},
                const std::vector<std::string> &deniedExtensions = {},
                const std::vector<std::string> &allowedFiles = {},
-               const std::vector<std::string> &deniedFiles = {});
+               const std::vector<std::string> &deniedFiles = {},
+               const ServerTuning &tuning = {});
     void stop();
 
 private:
@@ -49,42 +79,17 @@ private:
                                const std::string &password,
                                bool passwordEnabled);
     static void printLine(bool colorEnabled, const std::string &label, const std::string &value, Color color = Color::Green);
-    bool isAuthorized(const std::string &ip) const;
-    void authorizeIp(const std::string &ip);
     static inline void setPlainTextResponse(httplib::Response &response, int status, std::string_view body);
     static std::string buildContentDispositionHeader(const std::string &filename);
-    static bool streamFileResponse(httplib::Response &response, const std::filesystem::path &filePath);
-    static bool caseInsensitiveLess(const std::string &lhs, const std::string &rhs);
-    static std::unordered_set<std::string> normalizeExtensions(const std::vector<std::string> &extensions);
-    static void resolveDeniedPaths(const std::vector<std::string> &items,
-                                   const std::filesystem::path &baseDir,
-                                   std::unordered_set<std::string> &outFiles,
-                                   std::vector<std::filesystem::path> &outDirs);
-    static void resolveAllowedPaths(const std::vector<std::string> &items,
-                                    const std::filesystem::path &baseDir,
-                                    std::unordered_set<std::string> &outFiles,
-                                    std::vector<std::filesystem::path> &outDirs,
-                                    std::unordered_set<std::string> &outAncestors);
-    static bool isInList(const std::filesystem::path &canonicalPath,
-                         const std::unordered_set<std::string> &fileSet,
-                         const std::vector<std::filesystem::path> &dirList);
-    static bool isEntryAccessible(const std::filesystem::path &canonicalPath,
-                                  bool isDirectory,
-                                  const std::unordered_set<std::string> &allowedFiles,
-                                  const std::vector<std::filesystem::path> &allowedDirs,
-                                  const std::unordered_set<std::string> &allowedAncestors,
-                                  const std::unordered_set<std::string> &deniedFiles,
-                                  const std::vector<std::filesystem::path> &deniedDirs,
-                                  const std::unordered_set<std::string> &normalizedAllowedExts,
-                                  const std::unordered_set<std::string> &normalizedDeniedExts,
-                                  bool hasAllowedExt,
-                                  bool hasDeniedExt,
-                                  bool hasAllowedFiles);
+    static bool respondIfNotModified(const httplib::Request &request,
+                                     httplib::Response &response,
+                                     const std::string &entityTag,
+                                     std::int64_t lastModified);
+    // With `ignoreRanges` the whole file is sent with status 200 even though the request asked for ranges.
+    static bool streamFileResponse(httplib::Response &response, const std::filesystem::path &filePath, bool ignoreRanges = false);
+    static bool nameLess(const std::string &lhs, const std::string &rhs, bool natural);
 
 private:
-    std::atomic_bool authRequired{false};
-    mutable std::mutex authMutex;
-    std::unordered_set<std::string> authorizedIps;
     std::mutex serverMutex;
     std::shared_ptr<httplib::Server> server;
 };
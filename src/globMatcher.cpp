@@ -0,0 +1,417 @@
+#include "./globMatcher.hpp"
+#include <algorithm>
+
+namespace
+{
+    bool isSeparator(char c)
+    {
+#ifdef _WIN32
+        return c == '/' || c == '\\';
+#else
+        return c == '/';
+#endif
+    }
+
+    bool isMeta(char c)
+    {
+        return c == '*' || c == '?' || c == '[';
+    }
+
+    // Index one past the ']' closing the bracket expression at `open`, or 0 when it is unterminated
+    // (the '[' is then an ordinary character, as in fnmatch).
+    std::size_t classEnd(std::string_view pattern, std::size_t open)
+    {
+        std::size_t i = open + 1;
+        if (i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^'))
+        {
+            ++i;
+        }
+        if (i < pattern.size() && pattern[i] == ']')
+        {
+            ++i;
+        }
+        while (i < pattern.size() && pattern[i] != ']')
+        {
+            i += pattern[i] == '\\' && i + 1 < pattern.size() ? 2 : 1;
+        }
+        return i < pattern.size() ? i + 1 : 0;
+    }
+
+    bool classMatches(std::string_view expression, char c)
+    {
+        // `expression` is the text between '[' and ']'.
+        std::size_t i = 0;
+        const bool negated = !expression.empty() && (expression[0] == '!' || expression[0] == '^');
+        if (negated)
+        {
+            ++i;
+        }
+
+        bool found = false;
+        bool first = true;
+        while (i < expression.size())
+        {
+            char low = expression[i];
+            if (low == '\\' && i + 1 < expression.size())
+            {
+                low = expression[++i];
+            }
+            else if (low == ']' && !first)
+            {
+                break;
+            }
+            ++i;
+            first = false;
+
+            char high = low;
+            if (i + 1 < expression.size() && expression[i] == '-')
+            {
+                high = expression[i + 1];
+                if (high == '\\' && i + 2 < expression.size())
+                {
+                    high = expression[i + 2];
+                    ++i;
+                }
+                i += 2;
+            }
+
+            if (static_cast<unsigned char>(c) >= static_cast<unsigned char>(low) && static_cast<unsigned char>(c) <= static_cast<unsigned char>(high))
+            {
+                found = true;
+            }
+        }
+        return found != negated;
+    }
+
+    // fnmatch-style matching of one component; `*` backtracks to its most recent position only,
+    // which is enough because components contain no separators.
+    bool matchSegment(std::string_view pattern, std::string_view text)
+    {
+        std::size_t p = 0;
+        std::size_t t = 0;
+        std::size_t starPattern = std::string_view::npos;
+        std::size_t starText = 0;
+
+        while (t < text.size())
+        {
+            if (p < pattern.size())
+            {
+                const char pc = pattern[p];
+                if (pc == '*')
+                {
+                    starPattern = ++p;
+                    starText = t;
+                    continue;
+                }
+
+                std::size_t next = p + 1;
+                bool matched = false;
+                if (pc == '?')
+                {
+                    matched = true;
+                }
+                else if (pc == '[' && classEnd(pattern, p) != 0)
+                {
+                    next = classEnd(pattern, p);
+                    matched = classMatches(pattern.substr(p + 1, next - p - 2), text[t]);
+                }
+                else if (pc == '\\' && p + 1 < pattern.size())
+                {
+                    next = p + 2;
+                    matched = pattern[p + 1] == text[t];
+                }
+                else
+                {
+                    matched = pc == text[t];
+                }
+
+                if (matched)
+                {
+                    p = next;
+                    ++t;
+                    continue;
+                }
+            }
+
+            if (starPattern == std::string_view::npos)
+            {
+                return false;
+            }
+            p = starPattern;
+            t = ++starText;
+        }
+
+        while (p < pattern.size() && pattern[p] == '*')
+        {
+            ++p;
+        }
+        return p == pattern.size();
+    }
+
+    bool hasMeta(std::string_view segment)
+    {
+        for (std::size_t i = 0; i < segment.size(); ++i)
+        {
+            if (segment[i] == '\\')
+            {
+                ++i;
+            }
+            else if (isMeta(segment[i]))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string unescape(std::string_view segment)
+    {
+        std::string result;
+        result.reserve(segment.size());
+        for (std::size_t i = 0; i < segment.size(); ++i)
+        {
+            if (segment[i] == '\\' && i + 1 < segment.size())
+            {
+                ++i;
+            }
+            result.push_back(segment[i]);
+        }
+        return result;
+    }
+
+    // "*.ext" with a single dot and nothing else special: matched through the extension index.
+    bool isExtensionSegment(std::string_view segment)
+    {
+        return segment.size() >= 2 && segment[0] == '*' && segment[1] == '.' && segment.find('.', 2) == std::string_view::npos
+               && segment.find('\\') == std::string_view::npos && !hasMeta(segment.substr(1));
+    }
+
+    std::vector<std::uint32_t> &scratch(std::size_t which)
+    {
+        // Reused between calls so matching does not allocate once the buffers have grown.
+        thread_local std::vector<std::uint32_t> buffers[2];
+        return buffers[which];
+    }
+} // namespace
+
+bool GlobMatcher::isPattern(std::string_view text)
+{
+    return hasMeta(text);
+}
+
+bool GlobMatcher::add(std::string_view pattern, unsigned tag)
+{
+    const auto tagBit = static_cast<std::uint8_t>(1U << tag);
+
+    bool directoryOnly = false;
+    while (pattern.size() > 1 && pattern.back() == '/')
+    {
+        pattern.remove_suffix(1);
+        directoryOnly = true;
+    }
+
+    // Only a separator at the start or in the middle anchors the pattern to the root.
+    const bool anchored = pattern.find('/') != std::string_view::npos;
+    while (!pattern.empty() && pattern.front() == '/')
+    {
+        pattern.remove_prefix(1);
+    }
+
+    std::vector<std::string_view> segments;
+    std::size_t begin = 0;
+    while (begin <= pattern.size())
+    {
+        std::size_t end = pattern.find('/', begin);
+        if (end == std::string_view::npos)
+        {
+            end = pattern.size();
+        }
+
+        const std::string_view segment = pattern.substr(begin, end - begin);
+        if (!segment.empty() && segment != "." && !(segment == "**" && !segments.empty() && segments.back() == "**"))
+        {
+            segments.push_back(segment);
+        }
+        begin = end + 1;
+    }
+
+    // "a/**" matches everything inside "a" but not "a" itself, which is "a/*" once matches cover subtrees.
+    if (!segments.empty() && segments.back() == "**")
+    {
+        segments.back() = "*";
+    }
+    if (segments.empty())
+    {
+        return false;
+    }
+    if (!anchored && segments.front() != "**")
+    {
+        segments.insert(segments.begin(), "**");
+    }
+
+    std::uint32_t node = 0;
+    for (const std::string_view segment : segments)
+    {
+        nodes[node].below |= tagBit;
+        node = addChild(node, segment);
+    }
+
+    if (directoryOnly)
+    {
+        nodes[node].acceptDirectory |= tagBit;
+    }
+    else
+    {
+        nodes[node].accept |= tagBit;
+    }
+    return true;
+}
+
+bool GlobMatcher::empty() const
+{
+    return nodes.size() == 1;
+}
+
+GlobMatcher::Result GlobMatcher::match(std::string_view relativePath, bool isDirectory) const
+{
+    Result result;
+    if (empty())
+    {
+        return result;
+    }
+
+    std::vector<std::uint32_t> &states = scratch(0);
+    std::vector<std::uint32_t> &next = scratch(1);
+    states.clear();
+    enter(0, states);
+
+    std::size_t begin = 0;
+    while (begin < relativePath.size() && !states.empty())
+    {
+        std::size_t end = begin;
+        while (end < relativePath.size() && !isSeparator(relativePath[end]))
+        {
+            ++end;
+        }
+        const std::string_view component = relativePath.substr(begin, end - begin);
+        begin = end + 1;
+        if (component.empty())
+        {
+            continue;
+        }
+
+        const std::size_t dot = component.rfind('.');
+        const std::string_view extension = dot == std::string_view::npos ? std::string_view{} : component.substr(dot);
+
+        next.clear();
+        for (const std::uint32_t state : states)
+        {
+            const Node &node = nodes[state];
+            if (node.isDoubleStar)
+            {
+                next.push_back(state);
+            }
+
+            if (const auto it = node.literals.find(component); it != node.literals.end())
+            {
+                enter(it->second, next);
+            }
+
+            if (!extension.empty() && !node.extensions.empty())
+            {
+                if (const auto it = node.extensions.find(extension); it != node.extensions.end())
+                {
+                    enter(it->second, next);
+                }
+            }
+
+            for (const auto &[glob, child] : node.globs)
+            {
+                if (matchSegment(glob, component))
+                {
+                    enter(child, next);
+                }
+            }
+        }
+
+        std::sort(next.begin(), next.end());
+        next.erase(std::unique(next.begin(), next.end()), next.end());
+        states.swap(next);
+
+        // Components before the last are directories, so every kind of match covers the rest of the path.
+        const bool last = begin >= relativePath.size();
+        for (const std::uint32_t state : states)
+        {
+            result.matched |= nodes[state].accept;
+            if (!last || isDirectory)
+            {
+                result.matched |= nodes[state].acceptDirectory;
+            }
+        }
+    }
+
+    if (isDirectory)
+    {
+        for (const std::uint32_t state : states)
+        {
+            result.pending |= nodes[state].below;
+        }
+    }
+    return result;
+}
+
+std::uint32_t GlobMatcher::addChild(std::uint32_t parent, std::string_view segment)
+{
+    const auto newNode = [this]() {
+        nodes.emplace_back();
+        return static_cast<std::uint32_t>(nodes.size() - 1);
+    };
+
+    if (segment == "**")
+    {
+        if (nodes[parent].doubleStar == noNode)
+        {
+            const std::uint32_t child = newNode();
+            nodes[child].isDoubleStar = true;
+            nodes[parent].doubleStar = child;
+        }
+        return nodes[parent].doubleStar;
+    }
+
+    const bool literal = !hasMeta(segment);
+    if (literal || isExtensionSegment(segment))
+    {
+        std::string key = literal ? unescape(segment) : std::string{segment.substr(1)};
+        const ChildMap &map = literal ? nodes[parent].literals : nodes[parent].extensions;
+        if (const auto it = map.find(key); it != map.end())
+        {
+            return it->second;
+        }
+
+        // newNode() may reallocate `nodes`, so the map is looked up again afterwards.
+        const std::uint32_t child = newNode();
+        (literal ? nodes[parent].literals : nodes[parent].extensions).emplace(std::move(key), child);
+        return child;
+    }
+
+    for (const auto &[glob, child] : nodes[parent].globs)
+    {
+        if (glob == segment)
+        {
+            return child;
+        }
+    }
+    const std::uint32_t child = newNode();
+    nodes[parent].globs.emplace_back(std::string{segment}, child);
+    return child;
+}
+
+void GlobMatcher::enter(std::uint32_t node, std::vector<std::uint32_t> &states) const
+{
+    // A "**" child also matches zero components, so it becomes active together with its parent.
+    states.push_back(node);
+    if (nodes[node].doubleStar != noNode)
+    {
+        states.push_back(nodes[node].doubleStar);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A set of gitignore-style patterns compiled into one automaton over path components.
+//
+// Patterns follow .gitignore: `*`, `?` and `[...]` match within one component, `**` matches any number of
+// components, a trailing `/` restricts the pattern to directories, and a pattern without an inner `/` matches
+// at any depth. Each pattern carries a tag bit; one pass over a path reports the tags of every pattern that
+// matches the path or one of its parent directories.
+class GlobMatcher
+{
+public:
+    struct Result
+    {
+        // Tags of patterns matching the path itself or a directory above it.
+        std::uint8_t matched = 0;
+        // Tags of patterns that could still match an entry below the path.
+        std::uint8_t pending = 0;
+    };
+
+    static bool isPattern(std::string_view text);
+
+    // `tag` is a bit index below 8. Returns false for patterns that match nothing, such as an empty string.
+    bool add(std::string_view pattern, unsigned tag);
+    bool empty() const;
+
+    // `relativePath` is relative to the directory the patterns are anchored at ('\\' also separates on Windows).
+    Result match(std::string_view relativePath, bool isDirectory) const;
+
+private:
+    static constexpr std::uint32_t noNode = 0xFFFFFFFFU;
+
+    struct ComponentHash
+    {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view text) const noexcept
+        {
+            return std::hash<std::string_view>{}(text);
+        }
+    };
+
+    using ChildMap = std::unordered_map<std::string, std::uint32_t, ComponentHash, std::equal_to<>>;
+
+    struct Node
+    {
+        ChildMap literals;
+        // "*.ext" segments, indexed by ".ext" so thousands of them cost one lookup.
+        ChildMap extensions;
+        std::vector<std::pair<std::string, std::uint32_t>> globs;
+        std::uint32_t doubleStar = noNode;
+        bool isDoubleStar = false;
+        std::uint8_t accept = 0;
+        std::uint8_t acceptDirectory = 0;
+        std::uint8_t below = 0;
+    };
+
+    std::uint32_t addChild(std::uint32_t parent, std::string_view segment);
+    void enter(std::uint32_t node, std::vector<std::uint32_t> &states) const;
+
+private:
+    std::vector<Node> nodes = std::vector<Node>(1);
+};
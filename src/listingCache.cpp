@@ -0,0 +1,344 @@
+#include "./listingCache.hpp"
+#include <utility>
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+    // Any of these on a watched directory can change which children it has, or their sizes.
+    constexpr std::uint32_t watchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE
+                                        | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+} // namespace
+
+ListingCache::ListingCache(std::size_t budgetBytes)
+    : budgetBytes(budgetBytes)
+{
+#ifdef __linux__
+    if (budgetBytes == 0)
+    {
+        return;
+    }
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+    {
+        return;
+    }
+
+    if (pipe2(wakeFds, O_CLOEXEC) != 0)
+    {
+        close(inotifyFd);
+        inotifyFd = -1;
+        return;
+    }
+
+    watcher = std::thread([this]() {
+        watchLoop();
+    });
+#endif
+}
+
+ListingCache::~ListingCache()
+{
+#ifdef __linux__
+    if (watcher.joinable())
+    {
+        const char stop = 0;
+        [[maybe_unused]] const ssize_t written = write(wakeFds[1], &stop, 1);
+        watcher.join();
+    }
+
+    for (int &fd : wakeFds)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    if (inotifyFd >= 0)
+    {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+#endif
+}
+
+std::shared_ptr<const ListingCache::Entries> ListingCache::get(const std::filesystem::path &directory,
+                                                               const Util::File::EntryStat &directoryStat,
+                                                               const Loader &load)
+{
+    if (budgetBytes == 0)
+    {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return std::make_shared<const Entries>(load(directory));
+    }
+
+    const std::string key = directory.string();
+    std::uint64_t watchId = 0;
+    std::uint64_t epoch = 0;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (auto it = items.find(key); it != items.end())
+        {
+            Item &item = it->second;
+            // The mtime comparison is the only check on platforms without inotify, and still catches
+            // changes that raced with adding the watch.
+            if (item.mtimeSeconds == directoryStat.mtimeSeconds && item.mtimeNanoseconds == directoryStat.mtimeNanoseconds
+                && item.inode == directoryStat.inode)
+            {
+                lru.splice(lru.begin(), lru, item.lruPosition);
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return item.entries;
+            }
+
+            invalidateLocked(key);
+        }
+
+        Watch &watch = watchLocked(key);
+        ++watch.loaders;
+        watchId = watch.id;
+        epoch = watch.epoch;
+    }
+
+    misses.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<const Entries> entries;
+    try
+    {
+        entries = std::make_shared<const Entries>(load(directory));
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        finishLoadLocked(key, watchId);
+        throw;
+    }
+    const std::size_t bytes = estimateBytes(key, *entries);
+
+    std::lock_guard<std::mutex> guard(mutex);
+    auto watchIt = watches.find(key);
+    if (watchIt == watches.end() || watchIt->second.id != watchId || watchIt->second.epoch != epoch || bytes > budgetBytes || items.count(key))
+    {
+        // Changed while loading, too large to keep, or another request won the race.
+        finishLoadLocked(key, watchId);
+        return entries;
+    }
+
+    lru.push_front(key);
+    items.emplace(key, Item{entries, directoryStat.mtimeSeconds, directoryStat.mtimeNanoseconds, directoryStat.inode, bytes, lru.begin()});
+    cachedBytes += bytes;
+    finishLoadLocked(key, watchId);
+    evictLocked();
+    return entries;
+}
+
+ListingCache::Stats ListingCache::stats() const
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    return Stats{hits.load(std::memory_order_relaxed),
+                 misses.load(std::memory_order_relaxed),
+                 invalidations.load(std::memory_order_relaxed),
+                 evictions.load(std::memory_order_relaxed),
+                 items.size(),
+                 cachedBytes,
+                 budgetBytes,
+                 watcher.joinable()};
+}
+
+std::size_t ListingCache::estimateBytes(const std::string &key, const Entries &entries)
+{
+    // Rough footprint: the node overheads of both containers plus every heap block owned by the entries.
+    constexpr std::size_t nodeOverhead = 64U;
+    std::size_t bytes = sizeof(Item) + sizeof(Entries) + 2 * (key.capacity() + nodeOverhead);
+    bytes += entries.capacity() * sizeof(Entry);
+    for (const auto &entry : entries)
+    {
+        bytes += entry.name.capacity();
+    }
+    return bytes;
+}
+
+void ListingCache::invalidateLocked(const std::string &key)
+{
+    if (auto it = watches.find(key); it != watches.end())
+    {
+        it->second.epoch = ++lastEpoch;
+    }
+
+    if (auto it = items.find(key); it != items.end())
+    {
+        cachedBytes -= it->second.bytes;
+        lru.erase(it->second.lruPosition);
+        items.erase(it);
+        invalidations.fetch_add(1, std::memory_order_relaxed);
+    }
+    releaseWatchLocked(key);
+}
+
+void ListingCache::evictLocked()
+{
+    while (cachedBytes > budgetBytes && !lru.empty())
+    {
+        const std::string key = lru.back();
+        auto it = items.find(key);
+        cachedBytes -= it->second.bytes;
+        lru.pop_back();
+        items.erase(it);
+        releaseWatchLocked(key);
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+ListingCache::Watch &ListingCache::watchLocked(const std::string &key)
+{
+    if (auto it = watches.find(key); it != watches.end())
+    {
+        return it->second;
+    }
+
+    int descriptor = -1;
+#ifdef __linux__
+    if (inotifyFd >= 0)
+    {
+        // Failure (e.g. fs.inotify.max_user_watches exhausted) leaves the entry on mtime validation only.
+        descriptor = inotify_add_watch(inotifyFd, key.c_str(), watchMask);
+        if (descriptor >= 0)
+        {
+            watchedPaths[descriptor] = key;
+        }
+    }
+#endif
+
+    const std::uint64_t id = ++lastEpoch;
+    return watches.emplace(key, Watch{descriptor, id, id, 0}).first->second;
+}
+
+void ListingCache::finishLoadLocked(const std::string &key, std::uint64_t id)
+{
+    auto it = watches.find(key);
+    if (it == watches.end() || it->second.id != id)
+    {
+        // The watch this load started under is gone; its successor does not count this load.
+        return;
+    }
+    --it->second.loaders;
+    releaseWatchLocked(key);
+}
+
+void ListingCache::releaseWatchLocked(const std::string &key)
+{
+    auto it = watches.find(key);
+    if (it != watches.end() && it->second.loaders == 0 && items.find(key) == items.end())
+    {
+        unwatchLocked(key);
+    }
+}
+
+void ListingCache::unwatchLocked(const std::string &key)
+{
+    auto it = watches.find(key);
+    if (it == watches.end())
+    {
+        return;
+    }
+
+#ifdef __linux__
+    if (it->second.descriptor >= 0)
+    {
+        watchedPaths.erase(it->second.descriptor);
+        inotify_rm_watch(inotifyFd, it->second.descriptor);
+    }
+#endif
+    watches.erase(it);
+}
+
+void ListingCache::watchLoop()
+{
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+
+        if (fds[1].revents != 0)
+        {
+            return;
+        }
+
+        const ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> guard(mutex);
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                // Events were dropped, so nothing cached can be trusted any more. Watches go with the
+                // listings, apart from those that loads in progress still check.
+                invalidations.fetch_add(items.size(), std::memory_order_relaxed);
+                items.clear();
+                lru.clear();
+                cachedBytes = 0;
+                for (auto it = watches.begin(); it != watches.end();)
+                {
+                    Watch &watch = it->second;
+                    watch.epoch = ++lastEpoch;
+                    if (watch.loaders > 0)
+                    {
+                        ++it;
+                        continue;
+                    }
+                    if (watch.descriptor >= 0)
+                    {
+                        watchedPaths.erase(watch.descriptor);
+                        inotify_rm_watch(inotifyFd, watch.descriptor);
+                    }
+                    it = watches.erase(it);
+                }
+                continue;
+            }
+
+            auto pathIt = watchedPaths.find(event->wd);
+            if (pathIt == watchedPaths.end())
+            {
+                continue;
+            }
+
+            const std::string key = pathIt->second;
+            if (event->mask & IN_IGNORED)
+            {
+                // The kernel already dropped the watch (directory removed or unmounted).
+                watchedPaths.erase(pathIt);
+                if (auto watchIt = watches.find(key); watchIt != watches.end())
+                {
+                    watchIt->second.descriptor = -1;
+                }
+            }
+            invalidateLocked(key);
+        }
+    }
+#endif
+}
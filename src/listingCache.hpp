@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "utils/file.hpp"
+
+class ListingCache
+{
+public:
+    struct Entry
+    {
+        std::string name;
+        bool isDirectory;
+        std::uintmax_t fileSize;
+        std::int64_t modified;
+    };
+
+    using Entries = std::vector<Entry>;
+    using Loader = std::function<Entries(const std::filesystem::path &directory)>;
+
+    struct Stats
+    {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t invalidations;
+        std::uint64_t evictions;
+        std::size_t cachedDirectories;
+        std::size_t cachedBytes;
+        std::size_t budgetBytes;
+        bool watcherActive;
+    };
+
+    explicit ListingCache(std::size_t budgetBytes);
+    ~ListingCache();
+    ListingCache(const ListingCache &) = delete;
+    ListingCache &operator=(const ListingCache &) = delete;
+
+    // Returns the filtered, sorted entries of `directory`, calling `load` only when no valid copy is cached.
+    // `directoryStat` is the caller's fresh stat of the directory and backs the mtime fallback check.
+    std::shared_ptr<const Entries> get(const std::filesystem::path &directory,
+                                       const Util::File::EntryStat &directoryStat,
+                                       const Loader &load);
+    Stats stats() const;
+
+private:
+    struct Item
+    {
+        std::shared_ptr<const Entries> entries;
+        std::int64_t mtimeSeconds;
+        std::int64_t mtimeNanoseconds;
+        std::uint64_t inode;
+        std::size_t bytes;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    // A directory is watched while it has a cached listing or a load in progress, and no longer.
+    struct Watch
+    {
+        int descriptor;
+        // Identifies this watch among any earlier ones on the same directory.
+        std::uint64_t id;
+        // Changes whenever the directory changes; a load that started under another epoch is not cached.
+        std::uint64_t epoch;
+        unsigned loaders;
+    };
+
+    static std::size_t estimateBytes(const std::string &key, const Entries &entries);
+    void invalidateLocked(const std::string &key);
+    void evictLocked();
+    Watch &watchLocked(const std::string &key);
+    // Ends a load that began under watch `id`, then drops the watch if nothing else needs it.
+    void finishLoadLocked(const std::string &key, std::uint64_t id);
+    // Removes the watch on `key` unless it has a cached listing or a load in progress.
+    void releaseWatchLocked(const std::string &key);
+    void unwatchLocked(const std::string &key);
+    void watchLoop();
+
+private:
+    const std::size_t budgetBytes;
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Item> items;
+    std::list<std::string> lru;
+    std::unordered_map<std::string, Watch> watches;
+    std::unordered_map<int, std::string> watchedPaths;
+    std::uint64_t lastEpoch = 0;
+    std::size_t cachedBytes = 0;
+
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    std::atomic<std::uint64_t> invalidations{0};
+    std::atomic<std::uint64_t> evictions{0};
+
+    int inotifyFd = -1;
+    int wakeFds[2] = {-1, -1};
+    std::thread watcher;
+};
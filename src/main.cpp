@@ -34,6 +34,43 @@ namespace
         }
     }
 
+    bool parseUnsignedOption(const std::string &text, unsigned long long &value)
+    {
+        try
+        {
+            std::size_t parsed = 0;
+            value = std::stoull(text, &parsed, 10);
+            return parsed == text.size() && !text.empty() && text.front() != '-';
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+    }
+
+    // Stores option `name`, counted in `unit`s, in `out` when it was given. A value outside [min, max] or one
+    // `out` cannot hold is reported and leaves `out` unchanged.
+    template <typename T>
+    bool readUnsigned(const boost::program_options::variables_map &variablesMap, const char *name,
+                      unsigned long long min, unsigned long long max, T &out, unsigned long long unit = 1)
+    {
+        if (!variablesMap.count(name))
+        {
+            return true;
+        }
+
+        const std::string text = variablesMap[name].as<std::string>();
+        unsigned long long value = 0;
+        if (!parseUnsignedOption(text, value) || value < min || value > max
+            || value > static_cast<unsigned long long>(std::numeric_limits<T>::max()) / unit)
+        {
+            std::cerr << "Invalid value for option '--" << name << "': " << text << std::endl;
+            return false;
+        }
+        out = static_cast<T>(value * unit);
+        return true;
+    }
+
     void installSignalHandlers(Core &core)
     {
         activeCore = &core;
@@ -58,11 +95,28 @@ int main(int argc, char *argv[])
         ("port", po::value<std::string>()->implicit_value(""), "Server port (default: 13396)")   // port option
         ("password", po::value<std::string>()->implicit_value(""),
          "Enable password; omit value to generate one, or pass a value to set it. Default: no password")                                                             // password option
+        ("session-hours", po::value<std::string>(), "Hours a password sign-in stays valid (default: 168)")                                                         // session-hours option
+        ("session-key", po::value<std::string>(), "File keeping the key that signs sign-ins, created with mode 0600 (default: ~/.local/state/accio/session.key)") // session-key option
         ("enable-upload", po::value<std::string>()->default_value("on")->implicit_value("on"), "Enable upload feature (on/off, default: on)")                        // enable-upload option
         ("allow-exts", po::value<std::vector<std::string>>()->multitoken(), "Allowed file extensions (e.g., --allow-exts .txt .pdf)")                                // allow-exts option
-        ("allow-files", po::value<std::vector<std::string>>()->multitoken(), "Allowed specific files (relative paths, e.g., --allow-files secret.txt sub/notes.md)") // allow-files option
+        ("allow-files", po::value<std::vector<std::string>>()->multitoken(), "Allowed specific files (relative paths or gitignore-style patterns, e.g., --allow-files secret.txt sub/notes.md 'docs/**/*.pdf')") // allow-files option
         ("deny-exts", po::value<std::vector<std::string>>()->multitoken(), "Denied file extensions (e.g., --deny-exts .exe .dll)")                                   // deny-exts option
-        ("deny-files", po::value<std::vector<std::string>>()->multitoken(), "Denied specific files (relative paths, e.g., --deny-files secret.txt tmp/a.bin)")       // deny-files option
+        ("deny-files", po::value<std::vector<std::string>>()->multitoken(), "Denied specific files (relative paths or gitignore-style patterns, e.g., --deny-files secret.txt tmp/a.bin '**/node_modules' '*.tmp')")       // deny-files option
+        ("workers", po::value<std::string>(), "Threads serving connections; each open connection holds one (default: 0, max(8, CPU threads - 1))")               // workers option
+        ("worker-queue", po::value<std::string>(), "Connections that may wait for a free worker before new ones are dropped (default: 0, no limit)")               // worker-queue option
+        ("connections-per-ip", po::value<std::string>(), "Connections one client address may hold; more get 503 (default: 0, no limit)")                            // connections-per-ip option
+        ("keep-alive-max", po::value<std::string>(), "Requests served on one connection before it is closed (default: 100, 1 disables keep-alive)")                  // keep-alive-max option
+        ("keep-alive-timeout", po::value<std::string>(), "Seconds an idle keep-alive connection keeps its worker (default: 5)")                                       // keep-alive-timeout option
+        ("read-timeout", po::value<std::string>(), "Seconds to wait for request data from a client (default: 5)")                                                    // read-timeout option
+        ("write-timeout", po::value<std::string>(), "Seconds to wait for a client to accept response data (default: 5)")                                             // write-timeout option
+        ("listing-cache", po::value<std::string>(), "Memory budget for cached directory listings in MiB (default: 64, 0 disables)")                                   // listing-cache option
+        ("stat-threads", po::value<std::string>(), "Threads collecting file metadata for large listings, for slow network filesystems (default: 1, max: 64)")        // stat-threads option
+        ("natural-sort", "Order names by the value of embedded numbers (file2 before file10)")                                                                       // natural-sort option
+        ("upload-io", po::value<std::string>(), "How uploads are written: cached, writebehind (bounded dirty pages) or direct (O_DIRECT) (default: cached)")         // upload-io option
+        ("dedup", "Store identical uploads once, as reflinked copies; needs btrfs, XFS or another reflink filesystem")                                                 // dedup option
+        ("upload-writers", po::value<std::string>(), "Uploads written at the same time; more wait briefly, then get 503 (default: 8, 0 for no limit)")              // upload-writers option
+        ("upload-pending", po::value<std::string>(), "Announced upload data not yet written, in MiB, across all uploads (default: 0, no limit)")                     // upload-pending option
+        ("upload-reserve", po::value<std::string>(), "Free space in MiB that uploads must leave on the uploads volume (default: 256)")                              // upload-reserve option
         ;
 
     po::positional_options_description positionalOptionsDescription;
@@ -257,10 +311,74 @@ int main(int argc, char *argv[])
             return EXIT_FAILURE;
         }
 
+        ServerTuning tuning;
+        constexpr unsigned long long unlimited = std::numeric_limits<unsigned long long>::max();
+        constexpr unsigned long long mebibyte = 1024ULL * 1024ULL;
+        if (!readUnsigned(variablesMap, "listing-cache", 0, unlimited, tuning.listingCacheBytes, mebibyte)
+            || !readUnsigned(variablesMap, "stat-threads", 1, 64, tuning.statThreads)
+            || !readUnsigned(variablesMap, "session-hours", 1, 24ULL * 366ULL, tuning.sessionHours)
+            || !readUnsigned(variablesMap, "upload-writers", 0, 1024, tuning.uploadWriters)
+            || !readUnsigned(variablesMap, "upload-pending", 0, unlimited, tuning.uploadPendingBytes, mebibyte)
+            || !readUnsigned(variablesMap, "upload-reserve", 0, unlimited, tuning.uploadReserveBytes, mebibyte)
+            || !readUnsigned(variablesMap, "workers", 0, 4096, tuning.workers)
+            || !readUnsigned(variablesMap, "worker-queue", 0, 1000000, tuning.workerQueue)
+            || !readUnsigned(variablesMap, "connections-per-ip", 0, 4096, tuning.connectionsPerIp)
+            || !readUnsigned(variablesMap, "keep-alive-max", 1, 1000000, tuning.keepAliveMax)
+            || !readUnsigned(variablesMap, "keep-alive-timeout", 1, 3600, tuning.keepAliveSeconds)
+            || !readUnsigned(variablesMap, "read-timeout", 1, 3600, tuning.readTimeoutSeconds)
+            || !readUnsigned(variablesMap, "write-timeout", 1, 3600, tuning.writeTimeoutSeconds))
+        {
+            std::cerr << optionsDescription << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (variablesMap.count("session-key"))
+        {
+            tuning.sessionKeyFile = variablesMap["session-key"].as<std::string>();
+            if (tuning.sessionKeyFile.empty())
+            {
+                std::cerr << "Missing value for option '--session-key'" << std::endl;
+                std::cerr << optionsDescription << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            tuning.sessionKeyFile = Util::File::getDefaultSessionKeyPath();
+        }
+
+        tuning.naturalSort = variablesMap.count("natural-sort") > 0;
+
+        if (variablesMap.count("upload-io"))
+        {
+            const std::string uploadIoRaw = variablesMap["upload-io"].as<std::string>();
+            const std::string uploadIoValue = Util::String::toLowerCopy(uploadIoRaw);
+            if (uploadIoValue == "cached")
+            {
+                tuning.uploadWriteMode = Util::FileWriter::Mode::Cached;
+            }
+            else if (uploadIoValue == "writebehind")
+            {
+                tuning.uploadWriteMode = Util::FileWriter::Mode::WriteBehind;
+            }
+            else if (uploadIoValue == "direct")
+            {
+                tuning.uploadWriteMode = Util::FileWriter::Mode::Direct;
+            }
+            else
+            {
+                std::cerr << "Invalid value for '--upload-io': " << uploadIoRaw << " (expected 'cached', 'writebehind' or 'direct')" << std::endl;
+                std::cerr << optionsDescription << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        tuning.dedup = variablesMap.count("dedup") > 0;
+
         Core core;
         installSignalHandlers(core);
         core.start(path, uploadsPath, host, port, uploadsEnabled, password, passwordEnabled,
-                   allowedExtensions, deniedExtensions, allowedFiles, deniedFiles);
+                   allowedExtensions, deniedExtensions, allowedFiles, deniedFiles, tuning);
 
         if (shutdownRequested.load())
         {
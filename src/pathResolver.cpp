@@ -0,0 +1,130 @@
+#include "./pathResolver.hpp"
+#include <system_error>
+#include <utility>
+#if defined(__linux__) && __has_include(<linux/openat2.h>)
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/openat2.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/openat2.h>) && defined(SYS_openat2)
+#define ACCIO_HAVE_OPENAT2 1
+#endif
+
+namespace fs = std::filesystem;
+
+PathResolver::PathResolver(fs::path baseDir)
+    : baseDir(std::move(baseDir))
+{
+#ifdef ACCIO_HAVE_OPENAT2
+    baseFd = ::open(this->baseDir.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    directUsable.store(baseFd >= 0, std::memory_order_relaxed);
+#endif
+}
+
+PathResolver::~PathResolver()
+{
+#ifdef ACCIO_HAVE_OPENAT2
+    if (baseFd >= 0)
+    {
+        ::close(baseFd);
+    }
+#endif
+}
+
+std::tuple<bool, fs::path, Util::File::EntryStat> PathResolver::resolve(const std::string &relativePath)
+{
+    fs::path target = baseDir;
+    if (!relativePath.empty())
+    {
+        target /= fs::path{relativePath};
+    }
+    const fs::path lexicalTarget = target.lexically_normal();
+
+    const auto [outcome, directStat] = resolveDirect(lexicalTarget.lexically_relative(baseDir));
+    if (outcome == Direct::Found)
+    {
+        direct.fetch_add(1, std::memory_order_relaxed);
+        return {true, lexicalTarget, directStat};
+    }
+    if (outcome == Direct::Missing)
+    {
+        missing.fetch_add(1, std::memory_order_relaxed);
+        return {false, {}, {}};
+    }
+
+    canonicalised.fetch_add(1, std::memory_order_relaxed);
+    std::error_code ec;
+    const fs::path canonicalTarget = fs::weakly_canonical(target, ec);
+    if (ec || !Util::File::isWithinBase(canonicalTarget, baseDir))
+    {
+        return {false, {}, {}};
+    }
+
+    const auto [statOk, targetStat] = Util::File::statEntry(canonicalTarget);
+    if (!statOk)
+    {
+        return {false, {}, {}};
+    }
+    return {true, canonicalTarget, targetStat};
+}
+
+std::tuple<PathResolver::Direct, Util::File::EntryStat> PathResolver::resolveDirect(const fs::path &relativePath)
+{
+#ifdef ACCIO_HAVE_OPENAT2
+    // A path leading above the base is left to the canonical walk, which rejects it.
+    if (!directUsable.load(std::memory_order_relaxed) || relativePath.empty() || *relativePath.begin() == "..")
+    {
+        return {Direct::Unresolved, {}};
+    }
+
+    open_how how{};
+    how.flags = O_PATH | O_CLOEXEC;
+    how.resolve = RESOLVE_BENEATH | RESOLVE_NO_SYMLINKS | RESOLVE_NO_MAGICLINKS;
+    const int fd = static_cast<int>(::syscall(SYS_openat2, baseFd, relativePath.c_str(), &how, sizeof(how)));
+    if (fd < 0)
+    {
+        // ENOENT and ENOTDIR come from a symlink-free prefix, so canonicalising could not find the entry
+        // either. ELOOP is a symlink on the way, EXDEV a path out of the base, EAGAIN a concurrent rename;
+        // those and anything else are settled by the canonical walk.
+        const int error = errno;
+        if (error == ENOSYS)
+        {
+            directUsable.store(false, std::memory_order_relaxed);
+        }
+        return {error == ENOENT || error == ENOTDIR ? Direct::Missing : Direct::Unresolved, {}};
+    }
+
+    struct stat info{};
+    const bool statOk = ::fstat(fd, &info) == 0;
+    ::close(fd);
+    if (!statOk)
+    {
+        return {Direct::Unresolved, {}};
+    }
+
+    Util::File::EntryStat result;
+    result.isDirectory = S_ISDIR(info.st_mode);
+    result.isRegularFile = S_ISREG(info.st_mode);
+    result.size = result.isRegularFile ? static_cast<std::uintmax_t>(info.st_size) : 0U;
+    result.mtimeSeconds = static_cast<std::int64_t>(info.st_mtim.tv_sec);
+    result.mtimeNanoseconds = static_cast<std::int64_t>(info.st_mtim.tv_nsec);
+    result.device = static_cast<std::uint64_t>(info.st_dev);
+    result.inode = static_cast<std::uint64_t>(info.st_ino);
+    return {Direct::Found, result};
+#else
+    (void)relativePath;
+    return {Direct::Unresolved, {}};
+#endif
+}
+
+PathResolver::Stats PathResolver::stats() const
+{
+    return Stats{directUsable.load(std::memory_order_relaxed),
+                 direct.load(std::memory_order_relaxed),
+                 canonicalised.load(std::memory_order_relaxed),
+                 missing.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <tuple>
+#include "utils/file.hpp"
+
+// Turns request paths into canonical paths below the base directory. On Linux the base is kept open as an
+// O_PATH descriptor and a path is resolved from it with one openat2 call that refuses symlinks and anything
+// leading out of the base; when that succeeds the lexical path is the canonical one, and the stat comes
+// from the descriptor it returned. Paths through a symlink, and kernels or platforms without openat2, take
+// the weakly_canonical walk instead.
+class PathResolver
+{
+public:
+    struct Stats
+    {
+        bool openat2;
+        std::uint64_t direct;
+        std::uint64_t canonicalised;
+        std::uint64_t missing;
+    };
+
+    // `baseDir` must be canonical.
+    explicit PathResolver(std::filesystem::path baseDir);
+    ~PathResolver();
+    PathResolver(const PathResolver &) = delete;
+    PathResolver &operator=(const PathResolver &) = delete;
+
+    // The canonical path and its stat; fails for a missing entry and for one outside the base.
+    std::tuple<bool, std::filesystem::path, Util::File::EntryStat> resolve(const std::string &relativePath);
+
+    Stats stats() const;
+
+private:
+    enum class Direct
+    {
+        Found,
+        Missing,
+        Unresolved,
+    };
+
+    std::tuple<Direct, Util::File::EntryStat> resolveDirect(const std::filesystem::path &relativePath);
+
+    const std::filesystem::path baseDir;
+    int baseFd = -1;
+    std::atomic<bool> directUsable{false};
+
+    std::atomic<std::uint64_t> direct{0};
+    std::atomic<std::uint64_t> canonicalised{0};
+    std::atomic<std::uint64_t> missing{0};
+};
@@ -0,0 +1,196 @@
+#include "./sessionTokens.hpp"
+#include <charconv>
+#include <fstream>
+#include <random>
+#include <system_error>
+#include "utils/checksum.hpp"
+#include "utils/string.hpp"
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Every guess at the password from a copy of the key file costs this many HMACs.
+    constexpr unsigned verifierIterations = 200000;
+    constexpr std::size_t saltSize = 16;
+
+    std::string randomBytes(std::size_t count)
+    {
+        std::random_device device;
+        std::string bytes;
+        bytes.reserve(count + sizeof(unsigned));
+        while (bytes.size() < count)
+        {
+            const unsigned word = device();
+            bytes.append(reinterpret_cast<const char *>(&word), sizeof(word));
+        }
+        bytes.resize(count);
+        return bytes;
+    }
+
+    // The file is one line holding the key, the salt and the password verifier, each in base64. Gives the
+    // key only if the file is well formed and was written for `password`.
+    std::tuple<bool, std::string> readKeyFile(const fs::path &keyFile, std::string_view password)
+    {
+        std::ifstream in(keyFile, std::ios::binary);
+        std::string keyText;
+        std::string saltText;
+        std::string verifierText;
+        if (!(in >> keyText >> saltText >> verifierText))
+        {
+            return {false, {}};
+        }
+
+        std::string key;
+        std::string salt;
+        std::string verifier;
+        if (!Util::String::decodeBase64(keyText, key) || !Util::String::decodeBase64(saltText, salt)
+            || !Util::String::decodeBase64(verifierText, verifier) || key.size() != SessionTokens::keySize || salt.empty())
+        {
+            return {false, {}};
+        }
+        if (!Util::Checksum::equalConstantTime(verifier, Util::Checksum::pbkdf2Sha256(password, salt, verifierIterations)))
+        {
+            return {false, {}};
+        }
+        return {true, std::move(key)};
+    }
+
+    // Writes a sibling file and renames it over `keyFile`, so a reader never sees half a key.
+    bool writeKeyFile(const fs::path &keyFile, const std::string &contents, std::error_code &ec)
+    {
+        if (keyFile.has_parent_path() && fs::create_directories(keyFile.parent_path(), ec))
+        {
+            fs::permissions(keyFile.parent_path(), fs::perms::owner_all, ec);
+        }
+        if (ec)
+        {
+            return false;
+        }
+
+        fs::path temporary = keyFile;
+        temporary += ".tmp-" + Util::String::generateRandomString(8);
+#ifdef _WIN32
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!(out << contents) || !out.flush())
+            {
+                ec = std::make_error_code(std::errc::io_error);
+            }
+        }
+#else
+        const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0)
+        {
+            ec.assign(errno, std::generic_category());
+            return false;
+        }
+        errno = 0;
+        if (::write(fd, contents.data(), contents.size()) != static_cast<ssize_t>(contents.size()) || ::fsync(fd) != 0)
+        {
+            ec.assign(errno != 0 ? errno : EIO, std::generic_category());
+        }
+        ::close(fd);
+#endif
+        if (!ec)
+        {
+            fs::rename(temporary, keyFile, ec);
+        }
+        if (ec)
+        {
+            std::error_code ignored;
+            fs::remove(temporary, ignored);
+            return false;
+        }
+        return true;
+    }
+} // namespace
+
+std::tuple<bool, std::string, std::string> SessionTokens::loadKey(const fs::path &keyFile, std::string_view password)
+{
+    if (auto [ok, key] = readKeyFile(keyFile, password); ok)
+    {
+        return {true, std::move(key), {}};
+    }
+
+    // No file, a damaged one or one written for another password: start over with a new key.
+    std::string key = generateKey();
+    const std::string salt = randomBytes(saltSize);
+    const std::string contents = Util::String::encodeBase64(key) + " " + Util::String::encodeBase64(salt) + " "
+                                 + Util::String::encodeBase64(Util::Checksum::pbkdf2Sha256(password, salt, verifierIterations)) + "\n";
+    std::error_code ec;
+    if (!writeKeyFile(keyFile, contents, ec))
+    {
+        return {false, {}, ec.message()};
+    }
+    return {true, std::move(key), {}};
+}
+
+std::string SessionTokens::generateKey()
+{
+    return randomBytes(keySize);
+}
+
+SessionTokens::SessionTokens(std::string key, std::chrono::seconds lifetime)
+    : key(std::move(key)),
+      tokenLifetime(lifetime)
+{
+}
+
+std::chrono::seconds SessionTokens::lifetime() const
+{
+    return tokenLifetime;
+}
+
+std::string SessionTokens::issue() const
+{
+    const std::string expires = std::to_string(now() + tokenLifetime.count());
+    return expires + "." + sign("session", expires, {});
+}
+
+bool SessionTokens::verify(std::string_view token) const
+{
+    const auto dot = token.find('.');
+    if (dot == std::string_view::npos)
+    {
+        return false;
+    }
+    const std::string_view expires = token.substr(0, dot);
+    return verifyExpiry(expires) && Util::Checksum::equalConstantTime(token.substr(dot + 1), sign("session", expires, {}));
+}
+
+std::string SessionTokens::signPath(std::string_view path, std::chrono::seconds validFor) const
+{
+    const std::string expires = std::to_string(now() + validFor.count());
+    return "expires=" + expires + "&signature=" + sign("path", expires, path);
+}
+
+bool SessionTokens::verifyPath(std::string_view path, std::string_view expires, std::string_view signature) const
+{
+    return verifyExpiry(expires) && Util::Checksum::equalConstantTime(signature, sign("path", expires, path));
+}
+
+std::string SessionTokens::sign(std::string_view purpose, std::string_view expires, std::string_view subject) const
+{
+    std::string message;
+    message.reserve(purpose.size() + expires.size() + subject.size() + 2);
+    message.append(purpose).append(1, '\n').append(expires).append(1, '\n').append(subject);
+    return Util::String::encodeHex(Util::Checksum::hmacSha256(key, message));
+}
+
+bool SessionTokens::verifyExpiry(std::string_view expires) const
+{
+    std::int64_t value = 0;
+    const auto [end, error] = std::from_chars(expires.data(), expires.data() + expires.size(), value);
+    return error == std::errc{} && end == expires.data() + expires.size() && !expires.starts_with('-') && value > now();
+}
+
+std::int64_t SessionTokens::now()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
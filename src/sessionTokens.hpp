@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+// Credentials that the server can check without remembering anything: a token names its expiry time and
+// carries an HMAC-SHA256 of it under a random key. The key is kept in a file readable only by its owner, so
+// any thread, any process sharing the file and any later run can verify a token. A token says nothing about
+// the password, and changing the password replaces the key, which revokes every token.
+//
+// Session tokens ("<expiry>.<hex mac>") travel in a cookie or an `Authorization: Bearer` header. Signed
+// URLs bind one path to an expiry through `expires` and `signature` query parameters, so scripts and
+// shared links can fetch a file for a limited time without a session.
+class SessionTokens
+{
+public:
+    static constexpr std::size_t keySize = 32;
+
+    // Reads the key from `keyFile`, or writes a new random one there with mode 0600. The file also holds a
+    // salted PBKDF2 verifier of the password, so a start with another password replaces the key. Fails only
+    // when the file can be neither used nor written.
+    static std::tuple<bool, std::string, std::string> loadKey(const std::filesystem::path &keyFile, std::string_view password);
+    // A fresh random key, for a server that has nowhere to keep one.
+    static std::string generateKey();
+
+    SessionTokens(std::string key, std::chrono::seconds lifetime);
+
+    std::chrono::seconds lifetime() const;
+    std::string issue() const;
+    bool verify(std::string_view token) const;
+
+    // The query string ("expires=...&signature=...") that grants access to `path` for `validFor`.
+    std::string signPath(std::string_view path, std::chrono::seconds validFor) const;
+    bool verifyPath(std::string_view path, std::string_view expires, std::string_view signature) const;
+
+private:
+    // Purposes keep a session token from passing as a path signature and the other way round.
+    std::string sign(std::string_view purpose, std::string_view expires, std::string_view subject) const;
+    bool verifyExpiry(std::string_view expires) const;
+    static std::int64_t now();
+
+    const std::string key;
+    const std::chrono::seconds tokenLifetime;
+};
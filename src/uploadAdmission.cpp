@@ -0,0 +1,165 @@
+#include "./uploadAdmission.hpp"
+#include <algorithm>
+#include <system_error>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+UploadAdmission::Ticket::~Ticket()
+{
+    if (owner != nullptr)
+    {
+        owner->release(pending, holdsSlot);
+    }
+}
+
+UploadAdmission::Ticket::Ticket(Ticket &&other) noexcept
+    : owner(std::exchange(other.owner, nullptr)),
+      pending(std::exchange(other.pending, 0)),
+      unsettled(std::exchange(other.unsettled, 0)),
+      holdsSlot(std::exchange(other.holdsSlot, false))
+{
+}
+
+UploadAdmission::Ticket &UploadAdmission::Ticket::operator=(Ticket &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (owner != nullptr)
+        {
+            owner->release(pending, holdsSlot);
+        }
+        owner = std::exchange(other.owner, nullptr);
+        pending = std::exchange(other.pending, 0);
+        unsettled = std::exchange(other.unsettled, 0);
+        holdsSlot = std::exchange(other.holdsSlot, false);
+    }
+    return *this;
+}
+
+void UploadAdmission::Ticket::allocated(std::uint64_t bytes)
+{
+    bytes = std::min(bytes, pending - unsettled);
+    if (owner == nullptr || bytes == 0)
+    {
+        return;
+    }
+    unsettled += bytes;
+    if (unsettled >= settleBytes || unsettled == pending)
+    {
+        owner->settle(unsettled);
+        pending -= unsettled;
+        unsettled = 0;
+    }
+}
+
+UploadAdmission::UploadAdmission(const fs::path &uploadsDir, Limits limits)
+    : uploadsDir(uploadsDir),
+      limits(limits)
+{
+}
+
+std::tuple<UploadAdmission::Outcome, UploadAdmission::Ticket> UploadAdmission::admit(std::uint64_t expectedBytes)
+{
+    std::unique_lock<std::mutex> guard(mutex);
+    const auto hasRoom = [this, expectedBytes]() {
+        const bool slotFree = limits.maxWriters == 0 || writers < limits.maxWriters;
+        const bool bytesFree = limits.maxPendingBytes == 0 || pendingBytes == 0 || pendingBytes + expectedBytes <= limits.maxPendingBytes;
+        return slotFree && bytesFree;
+    };
+
+    // Space that is missing now will not appear by waiting, since admitted uploads only ever take more.
+    if (!hasSpaceLocked(expectedBytes))
+    {
+        ++rejectedNoSpace;
+        return {Outcome::NoSpace, Ticket{}};
+    }
+
+    if (!hasRoom())
+    {
+        const unsigned maxWaiting = std::max(limits.maxWriters, 1U);
+        bool admittedInTime = false;
+        if (waiting < maxWaiting)
+        {
+            ++waiting;
+            admittedInTime = slotFreed.wait_for(guard, queueWait, hasRoom);
+            --waiting;
+        }
+        if (!admittedInTime)
+        {
+            ++rejectedBusy;
+            return {Outcome::Busy, Ticket{}};
+        }
+        if (!hasSpaceLocked(expectedBytes))
+        {
+            ++rejectedNoSpace;
+            return {Outcome::NoSpace, Ticket{}};
+        }
+    }
+
+    ++writers;
+    ++admitted;
+    pendingBytes += expectedBytes;
+    Ticket ticket;
+    ticket.owner = this;
+    ticket.pending = expectedBytes;
+    ticket.holdsSlot = true;
+    return {Outcome::Admitted, std::move(ticket)};
+}
+
+std::tuple<bool, UploadAdmission::Ticket> UploadAdmission::reserve(std::uint64_t bytes)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!hasSpaceLocked(bytes))
+    {
+        ++rejectedNoSpace;
+        return {false, Ticket{}};
+    }
+
+    pendingBytes += bytes;
+    Ticket ticket;
+    ticket.owner = this;
+    ticket.pending = bytes;
+    return {true, std::move(ticket)};
+}
+
+UploadAdmission::Stats UploadAdmission::stats() const
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    return Stats{writers, pendingBytes, admitted, rejectedBusy, rejectedNoSpace};
+}
+
+bool UploadAdmission::hasSpaceLocked(std::uint64_t bytes) const
+{
+    // One statvfs per admission. Should it fail, the writes themselves still report a full disk.
+    std::error_code ec;
+    const fs::space_info space = fs::space(uploadsDir, ec);
+    if (ec)
+    {
+        return true;
+    }
+    const std::uint64_t committed = pendingBytes + limits.reserveBytes;
+    return space.available >= committed && space.available - committed >= bytes;
+}
+
+void UploadAdmission::release(std::uint64_t pending, bool holdsSlot)
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (holdsSlot)
+        {
+            --writers;
+        }
+        pendingBytes -= pending;
+    }
+    slotFreed.notify_all();
+}
+
+void UploadAdmission::settle(std::uint64_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        pendingBytes -= bytes;
+    }
+    slotFreed.notify_all();
+}
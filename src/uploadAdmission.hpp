@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <tuple>
+
+// Admission control for uploads. Every request that writes upload data holds a ticket: one of a limited
+// number of writer slots plus a reservation for the bytes it announced. A request is let in only while the
+// free space of the uploads volume, less what admitted uploads have announced but not yet written, covers
+// its own size and a configured reserve. When all slots are taken a request waits briefly for one and is
+// then turned away with 503, so an upload storm cannot tie up every worker thread or the whole disk.
+class UploadAdmission
+{
+public:
+    struct Limits
+    {
+        // Concurrent writers; 0 leaves them unlimited.
+        unsigned maxWriters;
+        // Announced bytes not yet written, across all writers; 0 leaves them unlimited. A single upload
+        // larger than this is still admitted when it is the only one.
+        std::uint64_t maxPendingBytes;
+        // Free space that uploads must leave on the volume.
+        std::uint64_t reserveBytes;
+    };
+
+    enum class Outcome
+    {
+        Admitted,
+        Busy,
+        NoSpace
+    };
+
+    struct Stats
+    {
+        unsigned writers;
+        std::uint64_t pendingBytes;
+        std::uint64_t admitted;
+        std::uint64_t rejectedBusy;
+        std::uint64_t rejectedNoSpace;
+    };
+
+    // Releases its slot, if it holds one, and whatever of its reservation is still pending when destroyed.
+    class Ticket
+    {
+    public:
+        Ticket() = default;
+        ~Ticket();
+        Ticket(Ticket &&other) noexcept;
+        Ticket &operator=(Ticket &&other) noexcept;
+        Ticket(const Ticket &) = delete;
+        Ticket &operator=(const Ticket &) = delete;
+
+        // `bytes` of the reservation now take space on disk, where the free space already accounts for them.
+        void allocated(std::uint64_t bytes);
+
+    private:
+        friend class UploadAdmission;
+
+        UploadAdmission *owner = nullptr;
+        std::uint64_t pending = 0;
+        // Allocated bytes not yet taken off `pending`; they are settled in batches to keep the lock cold.
+        std::uint64_t unsettled = 0;
+        bool holdsSlot = false;
+    };
+
+    // How long clients are asked to wait before trying again.
+    static constexpr std::chrono::seconds busyRetryAfter{2};
+    static constexpr std::chrono::seconds noSpaceRetryAfter{60};
+
+    UploadAdmission(const std::filesystem::path &uploadsDir, Limits limits);
+    UploadAdmission(const UploadAdmission &) = delete;
+    UploadAdmission &operator=(const UploadAdmission &) = delete;
+
+    // `expectedBytes` is 0 when the size is unknown; the reserve must still be free then.
+    std::tuple<Outcome, Ticket> admit(std::uint64_t expectedBytes);
+    // Holds `bytes` against the free space without taking a writer slot, for callers that allocate a whole
+    // file at once: the ticket keeps them reserved until it is dropped, which should follow the allocation.
+    std::tuple<bool, Ticket> reserve(std::uint64_t bytes);
+    Stats stats() const;
+
+private:
+    // A full writer table is waited on for this long, by at most as many requests as there are slots.
+    static constexpr std::chrono::milliseconds queueWait{2000};
+    static constexpr std::uint64_t settleBytes = 4ULL * 1024ULL * 1024ULL;
+
+    bool hasSpaceLocked(std::uint64_t bytes) const;
+    void release(std::uint64_t pending, bool holdsSlot);
+    void settle(std::uint64_t bytes);
+
+    const std::filesystem::path uploadsDir;
+    const Limits limits;
+    mutable std::mutex mutex;
+    std::condition_variable slotFreed;
+    unsigned writers = 0;
+    unsigned waiting = 0;
+    std::uint64_t pendingBytes = 0;
+    std::uint64_t admitted = 0;
+    std::uint64_t rejectedBusy = 0;
+    std::uint64_t rejectedNoSpace = 0;
+};
@@ -0,0 +1,89 @@
+#include "./uploadNames.hpp"
+#include <algorithm>
+#include <charconv>
+#include <system_error>
+#include "utils/file.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Splits "<stem>_<n><extension>" into the name it was numbered after and n.
+    bool parseNumberedName(const std::string &fileName, std::string &original, std::uint64_t &suffix)
+    {
+        const fs::path path{fileName};
+        const std::string stem = path.stem().string();
+        const std::size_t separator = stem.rfind('_');
+        if (separator == std::string::npos || separator + 1 == stem.size())
+        {
+            return false;
+        }
+
+        const char *first = stem.data() + separator + 1;
+        const char *last = stem.data() + stem.size();
+        const auto [end, error] = std::from_chars(first, last, suffix);
+        if (error != std::errc{} || end != last)
+        {
+            return false;
+        }
+
+        original = stem.substr(0, separator) + path.extension().string();
+        return true;
+    }
+} // namespace
+
+UploadNames::UploadNames(const fs::path &uploadsDir)
+    : uploadsDir(uploadsDir)
+{
+}
+
+std::tuple<bool, fs::path, std::string> UploadNames::commit(const fs::path &staged, const std::string &sanitized)
+{
+    // Most uploads carry a new name, which costs the move alone.
+    fs::path destination = uploadsDir / sanitized;
+    std::error_code ec;
+    if (Util::File::renameNoReplace(staged, destination, ec))
+    {
+        return {true, destination, {}};
+    }
+
+    const fs::path base{sanitized};
+    const std::string stem = base.stem().string();
+    const std::string extension = base.extension().string();
+    while (ec == std::errc::file_exists)
+    {
+        destination = uploadsDir / (stem + "_" + std::to_string(nextSuffix(sanitized)) + extension);
+        if (Util::File::renameNoReplace(staged, destination, ec))
+        {
+            return {true, destination, {}};
+        }
+    }
+    return {false, {}, ec.message()};
+}
+
+std::uint64_t UploadNames::nextSuffix(const std::string &sanitized)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!indexed)
+    {
+        indexLocked();
+    }
+    return ++highestSuffix[sanitized];
+}
+
+void UploadNames::indexLocked()
+{
+    // Errors only leave the index incomplete; moves still never replace a file, they just try more numbers.
+    indexed = true;
+    std::error_code ec;
+    for (fs::directory_iterator it(uploadsDir, ec), end; !ec && it != end; it.increment(ec))
+    {
+        std::string original;
+        std::uint64_t suffix = 0;
+        if (parseNumberedName(it->path().filename().string(), original, suffix))
+        {
+            auto &highest = highestSuffix[original];
+            highest = std::max(highest, suffix);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+// Gives finished uploads their final name in the uploads directory. A name already taken gets the next
+// "<stem>_<n><extension>" after the highest one known, so the cost of a collision does not grow with the
+// number of duplicates: the directory is read once, on the first collision, and a counter per name is
+// kept from then on. Every move refuses to replace an existing file, so concurrent uploads and files
+// created behind the server's back only make a move try the following number.
+class UploadNames
+{
+public:
+    explicit UploadNames(const std::filesystem::path &uploadsDir);
+    UploadNames(const UploadNames &) = delete;
+    UploadNames &operator=(const UploadNames &) = delete;
+
+    // Moves `staged` into the uploads directory under `sanitized` or a numbered variant of it.
+    std::tuple<bool, std::filesystem::path, std::string> commit(const std::filesystem::path &staged, const std::string &sanitized);
+
+private:
+    std::uint64_t nextSuffix(const std::string &sanitized);
+    void indexLocked();
+
+    const std::filesystem::path uploadsDir;
+    std::mutex mutex;
+    bool indexed = false;
+    // Highest suffix in use per original name, keyed like "IMG_0001.jpg".
+    std::unordered_map<std::string, std::uint64_t> highestSuffix;
+};
@@ -0,0 +1,544 @@
+#include "./uploadSessions.hpp"
+#include <algorithm>
+#include <system_error>
+#include <utility>
+#include "utils/checksum.hpp"
+#include "utils/string.hpp"
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr std::size_t sessionIdLength = 32U;
+    // The body arrives in pieces of a few KiB; they are gathered into writes of this size.
+    constexpr std::size_t coalesceBytes = 1024U * 1024U;
+
+    std::chrono::steady_clock::rep now()
+    {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+} // namespace
+
+UploadSessions::Session::~Session()
+{
+#ifdef _WIN32
+    if (file.is_open())
+    {
+        file.close();
+    }
+#else
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+#endif
+    if (!finished && !partialPath.empty())
+    {
+        std::error_code ec;
+        fs::remove(partialPath, ec);
+    }
+}
+
+UploadSessions::UploadSessions(std::shared_ptr<UploadNames> names, std::shared_ptr<UploadStore> store, const fs::path &stagingDir,
+                               std::uint64_t chunkSize, std::chrono::seconds idleTimeout)
+    : names(std::move(names)),
+      store(std::move(store)),
+      stagingDir(stagingDir),
+      chunkSize(chunkSize),
+      idleTimeout(idleTimeout)
+{
+}
+
+UploadSessions::~UploadSessions()
+{
+    // Sessions cannot outlive the process, so their partial files go with them.
+    std::lock_guard<std::mutex> guard(mutex);
+    sessions.clear();
+}
+
+std::tuple<UploadSessions::Outcome, std::string, std::string> UploadSessions::create(const std::string &fileName, std::uint64_t length,
+                                                                                     std::optional<std::uint32_t> checksum)
+{
+    if (length == 0)
+    {
+        return {Outcome::Invalid, {}, "Upload-Length must be positive"};
+    }
+
+    std::string id;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        expireIdleLocked();
+        do
+        {
+            id = Util::String::generateRandomString(sessionIdLength);
+        } while (sessions.find(id) != sessions.end());
+    }
+
+    auto session = std::make_shared<Session>();
+    session->fileName = fileName;
+    session->length = length;
+    session->received.assign(static_cast<std::size_t>((length + chunkSize - 1) / chunkSize), false);
+    session->chunkChecksums.assign(session->received.size(), 0);
+    session->writing.assign(session->received.size(), false);
+    session->expectedChecksum = checksum;
+    session->lastActivity.store(now(), std::memory_order_relaxed);
+
+    // The partial file is named after the session, so parallel sessions never share one.
+    const fs::path partialPath = stagingDir / (id + ".part");
+#ifdef _WIN32
+    {
+        std::ofstream create(partialPath, std::ios::binary);
+        if (!create)
+        {
+            return {Outcome::Failed, {}, "Failed to create upload"};
+        }
+    }
+    session->partialPath = partialPath;
+
+    std::error_code ec;
+    fs::resize_file(partialPath, length, ec);
+    if (ec)
+    {
+        return {Outcome::InsufficientStorage, {}, "Insufficient storage"};
+    }
+
+    session->file.open(partialPath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!session->file)
+    {
+        return {Outcome::Failed, {}, "Failed to create upload"};
+    }
+#else
+    session->fd = ::open(partialPath.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (session->fd < 0)
+    {
+        return {Outcome::Failed, {}, "Failed to create upload"};
+    }
+    session->partialPath = partialPath;
+
+    // Reserving the whole file up front keeps it contiguous while chunks arrive out of order, and turns
+    // a full disk into an error now rather than after most of the data was sent. As in Util::FileWriter,
+    // fallocate(2) is used because posix_fallocate(3) would write the file once where it is unsupported.
+    int allocateError = EOPNOTSUPP;
+#if defined(__linux__)
+    allocateError = ::fallocate(session->fd, 0, 0, static_cast<off_t>(length)) == 0 ? 0 : errno;
+#endif
+    if (allocateError == ENOSPC || allocateError == EDQUOT || allocateError == EFBIG)
+    {
+        return {Outcome::InsufficientStorage, {}, "Insufficient storage"};
+    }
+    if (allocateError != 0 && ::ftruncate(session->fd, static_cast<off_t>(length)) != 0)
+    {
+        return {errno == EFBIG ? Outcome::InsufficientStorage : Outcome::Failed, {}, "Failed to create upload"};
+    }
+    session->preallocated = allocateError == 0;
+#endif
+
+    std::lock_guard<std::mutex> guard(mutex);
+    sessions.emplace(id, std::move(session));
+    return {Outcome::Ok, id, {}};
+}
+
+std::tuple<UploadSessions::Outcome, UploadSessions::Status> UploadSessions::status(const std::string &id)
+{
+    const std::shared_ptr<Session> session = find(id);
+    if (!session)
+    {
+        return {Outcome::NotFound, Status{}};
+    }
+
+    std::lock_guard<std::mutex> guard(session->mutex);
+    return {Outcome::Ok, describe(*session)};
+}
+
+std::tuple<UploadSessions::Outcome, UploadSessions::Status, std::string> UploadSessions::writeChunk(const std::string &id,
+                                                                                                    std::uint64_t offset,
+                                                                                                    std::uint64_t length,
+                                                                                                    std::optional<std::uint32_t> checksum,
+                                                                                                    const Reader &read)
+{
+    const std::shared_ptr<Session> session = find(id);
+    if (!session)
+    {
+        return {Outcome::NotFound, Status{}, "Upload not found"};
+    }
+
+    if (offset % chunkSize != 0 || offset >= session->length)
+    {
+        return {Outcome::Invalid, Status{}, "Upload-Offset must be a chunk boundary inside the file"};
+    }
+    const std::uint64_t expected = std::min(chunkSize, session->length - offset);
+    if (length != expected)
+    {
+        return {Outcome::Invalid, Status{}, "Chunk must be " + std::to_string(expected) + " bytes"};
+    }
+
+    // The chunk stops counting as received before any of its bytes are overwritten, so the file cannot be
+    // finished, or hashed past it, until this write has been checked and recorded.
+    const std::size_t index = static_cast<std::size_t>(offset / chunkSize);
+    {
+        std::unique_lock<std::mutex> hashGuard(session->hashMutex, std::defer_lock);
+        if (store)
+        {
+            hashGuard.lock();
+        }
+        std::lock_guard<std::mutex> guard(session->mutex);
+        if (session->finished)
+        {
+            // The response that completed the file may have been lost; a retry learns the outcome here.
+            return {Outcome::Ok, describe(*session), {}};
+        }
+        if (session->finishing)
+        {
+            return {Outcome::Busy, Status{}, "Upload is being completed"};
+        }
+        if (session->writing[index])
+        {
+            return {Outcome::Busy, Status{}, "Chunk is already being written"};
+        }
+        session->writing[index] = true;
+        if (session->received[index])
+        {
+            session->received[index] = false;
+            --session->receivedCount;
+        }
+        if (index < session->hashedChunks)
+        {
+            session->contentHash = Util::Checksum::Sha256{};
+            session->hashedChunks = 0;
+        }
+    }
+
+    std::uint64_t received = 0;
+    std::uint64_t written = 0;
+    Util::Checksum::Crc32c crc;
+    bool writeFailed = false;
+    std::vector<char> pending;
+    pending.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(expected, coalesceBytes)));
+    const auto flushPending = [&]() {
+        if (!pending.empty() && !writeAt(*session, offset + written, pending.data(), pending.size()))
+        {
+            writeFailed = true;
+            return false;
+        }
+        written += pending.size();
+        pending.clear();
+        return true;
+    };
+
+    bool readOk = read([&](const char *data, std::size_t dataLength) {
+        if (dataLength > expected - received)
+        {
+            return false;
+        }
+        pending.insert(pending.end(), data, data + dataLength);
+        crc.update(data, dataLength);
+        received += dataLength;
+        return pending.size() < coalesceBytes || flushPending();
+    });
+    readOk = flushPending() && readOk;
+    session->lastActivity.store(now(), std::memory_order_relaxed);
+
+    // A chunk that failed any check stays missing and has to be sent again.
+    Outcome failure = Outcome::Ok;
+    std::string failureMessage;
+    if (writeFailed)
+    {
+        failure = Outcome::Failed;
+        failureMessage = "Failed to save file";
+    }
+    else if (!readOk || written != expected)
+    {
+        failure = Outcome::Invalid;
+        failureMessage = "Incomplete chunk";
+    }
+    else if (checksum && *checksum != crc.value())
+    {
+        failure = Outcome::ChecksumMismatch;
+        failureMessage = "Checksum mismatch";
+    }
+
+    bool completing = false;
+    Status result;
+    {
+        std::lock_guard<std::mutex> guard(session->mutex);
+        session->writing[index] = false;
+        if (failure != Outcome::Ok)
+        {
+            return {failure, Status{}, failureMessage};
+        }
+        session->chunkChecksums[index] = crc.value();
+        session->received[index] = true;
+        ++session->receivedCount;
+        if (session->receivedCount == session->received.size() && !session->finished && !session->finishing)
+        {
+            session->finishing = true;
+            completing = true;
+        }
+        result = describe(*session);
+    }
+
+    if (store)
+    {
+        hashReceived(*session, completing);
+    }
+    if (!completing)
+    {
+        return {Outcome::Ok, result, {}};
+    }
+    return finish(id, *session);
+}
+
+std::tuple<UploadSessions::Outcome, UploadSessions::Status, std::string> UploadSessions::finish(const std::string &id, Session &session)
+{
+    // Every chunk is in, so the hash has caught up with the whole file.
+    bool useStore = false;
+    if (store)
+    {
+        std::lock_guard<std::mutex> hashGuard(session.hashMutex);
+        if (!session.hashFailed && session.contentDigest.empty())
+        {
+            session.contentDigest = session.contentHash.finish();
+        }
+        useStore = !session.hashFailed;
+    }
+
+    bool discard = false;
+    Status result;
+    {
+        std::lock_guard<std::mutex> guard(session.mutex);
+        std::uint32_t fileChecksum = session.chunkChecksums[0];
+        for (std::size_t i = 1; i < session.chunkChecksums.size(); ++i)
+        {
+            const std::uint64_t chunkLength = std::min(chunkSize, session.length - i * chunkSize);
+            fileChecksum = Util::Checksum::combineCrc32c(fileChecksum, session.chunkChecksums[i], chunkLength);
+        }
+
+        // Every chunk arrived intact by its own account, so there is no telling which one is wrong.
+        discard = session.expectedChecksum && *session.expectedChecksum != fileChecksum;
+        if (!discard)
+        {
+#ifdef _WIN32
+            // Open files cannot be renamed here; every writer holds `mutex`, so closing is safe.
+            session.file.close();
+#endif
+            Util::Checksum::storeCrc32c(session.partialPath, fileChecksum);
+            auto [committed, destination, commitError] = useStore
+                                                             ? store->commit(session.partialPath, session.fileName, session.contentDigest, session.length)
+                                                             : names->commit(session.partialPath, session.fileName);
+            if (!committed)
+            {
+#ifdef _WIN32
+                session.file.open(session.partialPath, std::ios::binary | std::ios::in | std::ios::out);
+#endif
+                session.finishing = false;
+                return {Outcome::Failed, Status{}, commitError.empty() ? "Failed to save file" : commitError};
+            }
+
+            session.finished = true;
+            session.fileName = destination.filename().string();
+            session.fileChecksum = fileChecksum;
+#ifndef _WIN32
+            ::close(session.fd);
+            session.fd = -1;
+#endif
+        }
+        result = describe(session);
+    }
+
+    // A finished session stays until it expires, so clients can still ask for the saved name.
+    if (discard)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        sessions.erase(id);
+        return {Outcome::ChecksumMismatch, Status{}, "Checksum mismatch; the upload was discarded"};
+    }
+    return {Outcome::Ok, result, {}};
+}
+
+void UploadSessions::hashReceived(Session &session, bool wait)
+{
+    std::unique_lock<std::mutex> hashGuard(session.hashMutex, std::defer_lock);
+    if (wait)
+    {
+        hashGuard.lock();
+    }
+    else if (!hashGuard.try_lock())
+    {
+        return;
+    }
+
+    // Chunks are read back rather than hashed as they stream in, since they arrive out of order; they were
+    // just written, so the reads come from the page cache.
+    std::vector<char> buffer;
+    while (!session.hashFailed)
+    {
+        {
+            std::lock_guard<std::mutex> guard(session.mutex);
+            if (session.hashedChunks == session.received.size() || !session.received[session.hashedChunks])
+            {
+                return;
+            }
+        }
+
+        const std::uint64_t offset = static_cast<std::uint64_t>(session.hashedChunks) * chunkSize;
+        const std::uint64_t length = std::min(chunkSize, session.length - offset);
+        buffer.resize(static_cast<std::size_t>(std::min<std::uint64_t>(length, coalesceBytes)));
+        for (std::uint64_t done = 0; done < length;)
+        {
+            const auto piece = static_cast<std::size_t>(std::min<std::uint64_t>(buffer.size(), length - done));
+            if (!readAt(session, offset + done, buffer.data(), piece))
+            {
+                // The upload is then saved without deduplication.
+                session.hashFailed = true;
+                return;
+            }
+            session.contentHash.update(buffer.data(), piece);
+            done += piece;
+        }
+        ++session.hashedChunks;
+    }
+}
+
+bool UploadSessions::remove(const std::string &id)
+{
+    // A chunk still being written keeps the session alive; the last reference removes the partial file.
+    std::lock_guard<std::mutex> guard(mutex);
+    return sessions.erase(id) > 0;
+}
+
+bool UploadSessions::isPreallocated(const std::string &id)
+{
+    const std::shared_ptr<Session> session = find(id);
+    return session && session->preallocated;
+}
+
+std::shared_ptr<UploadSessions::Session> UploadSessions::find(const std::string &id)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    const auto it = sessions.find(id);
+    if (it == sessions.end())
+    {
+        return nullptr;
+    }
+    it->second->lastActivity.store(now(), std::memory_order_relaxed);
+    return it->second;
+}
+
+UploadSessions::Status UploadSessions::describe(const Session &session) const
+{
+    Status status;
+    status.length = session.length;
+    status.chunkSize = chunkSize;
+    status.complete = session.finished;
+    status.fileName = session.finished ? session.fileName : std::string{};
+    status.checksum = session.finished ? session.fileChecksum : 0;
+
+    const std::size_t count = session.received.size();
+    std::size_t prefix = 0;
+    while (prefix < count && session.received[prefix])
+    {
+        ++prefix;
+    }
+    status.offset = std::min(session.length, static_cast<std::uint64_t>(prefix) * chunkSize);
+
+    for (std::size_t first = 0; first < count;)
+    {
+        if (!session.received[first])
+        {
+            ++first;
+            continue;
+        }
+        std::size_t last = first;
+        while (last + 1 < count && session.received[last + 1])
+        {
+            ++last;
+        }
+        if (!status.receivedChunks.empty())
+        {
+            status.receivedChunks.push_back(',');
+        }
+        status.receivedChunks += std::to_string(first);
+        if (last != first)
+        {
+            status.receivedChunks += "-" + std::to_string(last);
+        }
+        first = last + 1;
+    }
+    return status;
+}
+
+void UploadSessions::expireIdleLocked()
+{
+    const auto cutoff = now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(idleTimeout).count();
+    for (auto it = sessions.begin(); it != sessions.end();)
+    {
+        if (it->second->lastActivity.load(std::memory_order_relaxed) < cutoff)
+        {
+            it = sessions.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+bool UploadSessions::writeAt(Session &session, std::uint64_t offset, const char *data, std::size_t length)
+{
+#ifdef _WIN32
+    std::lock_guard<std::mutex> guard(session.mutex);
+    session.file.seekp(static_cast<std::streamoff>(offset));
+    session.file.write(data, static_cast<std::streamsize>(length));
+    return static_cast<bool>(session.file);
+#else
+    while (length > 0)
+    {
+        const ssize_t written = ::pwrite(session.fd, data, length, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        length -= static_cast<std::size_t>(written);
+        offset += static_cast<std::uint64_t>(written);
+    }
+    return true;
+#endif
+}
+
+bool UploadSessions::readAt(Session &session, std::uint64_t offset, char *data, std::size_t length)
+{
+#ifdef _WIN32
+    std::lock_guard<std::mutex> guard(session.mutex);
+    session.file.seekg(static_cast<std::streamoff>(offset));
+    session.file.read(data, static_cast<std::streamsize>(length));
+    return static_cast<bool>(session.file);
+#else
+    while (length > 0)
+    {
+        const ssize_t result = ::pread(session.fd, data, length, static_cast<off_t>(offset));
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return false;
+        }
+        data += result;
+        length -= static_cast<std::size_t>(result);
+        offset += static_cast<std::uint64_t>(result);
+    }
+    return true;
+#endif
+}
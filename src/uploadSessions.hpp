@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "./uploadNames.hpp"
+#include "./uploadStore.hpp"
+#include "utils/checksum.hpp"
+
+// Resumable uploads in the spirit of tus: a client creates a session for a file of known length, sends it
+// in fixed-size chunks at their offsets (in any order and in parallel), and can ask which chunks arrived
+// after a disconnect. Chunks are written into a preallocated file in the staging directory, which is moved
+// to its final name in the uploads directory once every chunk is in. Sessions live in memory and expire
+// when left idle; a finished one is kept until then to report the name the file was saved under. With a
+// store (--dedup), the received prefix of each file is also hashed with SHA-256 as it grows, so the content
+// can be looked up once the last chunk is in.
+class UploadSessions
+{
+public:
+    enum class Outcome
+    {
+        Ok,
+        NotFound,
+        Invalid,
+        InsufficientStorage,
+        ChecksumMismatch,
+        // The chunk is being written by another request, or the file is being completed.
+        Busy,
+        Failed
+    };
+
+    struct Status
+    {
+        std::uint64_t length = 0;
+        std::uint64_t chunkSize = 0;
+        // End of the prefix that has fully arrived, as tus reports it.
+        std::uint64_t offset = 0;
+        // Indices of received chunks as ranges, such as "0-3,5".
+        std::string receivedChunks;
+        bool complete = false;
+        // Final file name and CRC-32C of the whole file once complete.
+        std::string fileName;
+        std::uint32_t checksum = 0;
+    };
+
+    using Receiver = std::function<bool(const char *data, std::size_t length)>;
+    using Reader = std::function<bool(const Receiver &receive)>;
+
+    // `store` may be null, which saves every upload under its own name.
+    UploadSessions(std::shared_ptr<UploadNames> names, std::shared_ptr<UploadStore> store, const std::filesystem::path &stagingDir,
+                   std::uint64_t chunkSize, std::chrono::seconds idleTimeout);
+    ~UploadSessions();
+    UploadSessions(const UploadSessions &) = delete;
+    UploadSessions &operator=(const UploadSessions &) = delete;
+
+    // `fileName` must already be sanitized. With `checksum` set, the finished file must have that CRC-32C or
+    // the upload is discarded. Returns the new session id, or an error message.
+    std::tuple<Outcome, std::string, std::string> create(const std::string &fileName, std::uint64_t length, std::optional<std::uint32_t> checksum);
+    std::tuple<Outcome, Status> status(const std::string &id);
+    // Streams the chunk starting at `offset` from `read`; `length` is the request body size and must be the
+    // full chunk. A chunk sent again counts as missing from the moment its bytes start to be overwritten
+    // until they have arrived in full and, with `checksum`, matched its CRC-32C; a resend that fails leaves
+    // the chunk to be sent once more. One request at a time may write a chunk.
+    std::tuple<Outcome, Status, std::string> writeChunk(const std::string &id, std::uint64_t offset, std::uint64_t length,
+                                                        std::optional<std::uint32_t> checksum, const Reader &read);
+    bool remove(const std::string &id);
+    // Whether the session's file has its whole length allocated on disk. Chunks of a file that could not
+    // be preallocated take space as they arrive, so their bytes must be admitted one request at a time.
+    bool isPreallocated(const std::string &id);
+
+private:
+    struct Session
+    {
+        ~Session();
+
+        std::string fileName;
+        std::filesystem::path partialPath;
+        std::uint64_t length = 0;
+        std::vector<bool> received;
+        // CRC-32C of each received chunk, joined into the file's once all are in.
+        std::vector<std::uint32_t> chunkChecksums;
+        // Chunks a request is currently writing.
+        std::vector<bool> writing;
+        std::optional<std::uint32_t> expectedChecksum;
+        std::uint32_t fileChecksum = 0;
+        // Set while one request moves the finished file into place.
+        bool finishing = false;
+        std::size_t receivedCount = 0;
+        bool finished = false;
+        // Set once, before the session is published.
+        bool preallocated = false;
+        // steady_clock ticks; read by the expiry sweep without taking `mutex`.
+        std::atomic<std::chrono::steady_clock::rep> lastActivity{0};
+        std::mutex mutex;
+        // SHA-256 of the first `hashedChunks` chunks, advanced as gaps close. Guarded by `hashMutex`, which
+        // is taken before `mutex` when both are needed.
+        Util::Checksum::Sha256 contentHash;
+        std::size_t hashedChunks = 0;
+        bool hashFailed = false;
+        std::string contentDigest;
+        std::mutex hashMutex;
+#ifdef _WIN32
+        // Guarded by `mutex`; positioned writes need a seek on this platform.
+        std::fstream file;
+#else
+        int fd = -1;
+#endif
+    };
+
+    std::shared_ptr<Session> find(const std::string &id);
+    std::tuple<Outcome, Status, std::string> finish(const std::string &id, Session &session);
+    // Feeds chunks that now continue the hashed prefix into the content hash. Unless `wait` is set, it
+    // leaves the work to a request that is already doing it.
+    void hashReceived(Session &session, bool wait);
+    Status describe(const Session &session) const;
+    void expireIdleLocked();
+    bool writeAt(Session &session, std::uint64_t offset, const char *data, std::size_t length);
+    bool readAt(Session &session, std::uint64_t offset, char *data, std::size_t length);
+
+private:
+    const std::shared_ptr<UploadNames> names;
+    const std::shared_ptr<UploadStore> store;
+    const std::filesystem::path stagingDir;
+    const std::uint64_t chunkSize;
+    const std::chrono::seconds idleTimeout;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<Session>> sessions;
+};
@@ -0,0 +1,176 @@
+#include "./uploadStore.hpp"
+#include <system_error>
+#include "utils/checksum.hpp"
+#include "utils/file.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+std::tuple<bool, fs::path, std::string> UploadStore::prepareDirectory(const fs::path &uploadsDir)
+{
+    const fs::path storeDir = uploadsDir / ".accio-store";
+    std::error_code ec;
+    fs::create_directories(storeDir, ec);
+    if (ec || !fs::is_directory(storeDir, ec))
+    {
+        return {false, {}, ec ? ec.message() : "path exists and is not a directory"};
+    }
+
+    for (const auto &entry : fs::directory_iterator{storeDir, ec})
+    {
+        std::error_code entryEc;
+        fs::remove_all(entry.path(), entryEc);
+    }
+    if (ec)
+    {
+        return {false, {}, ec.message()};
+    }
+
+    const fs::path canonical = fs::weakly_canonical(storeDir, ec);
+    if (ec)
+    {
+        return {false, {}, ec.message()};
+    }
+    return {true, canonical, {}};
+}
+
+UploadStore::UploadStore(std::shared_ptr<UploadNames> names, const fs::path &storeDir, const fs::path &stagingDir)
+    : names(std::move(names)),
+      storeDir(storeDir),
+      stagingDir(stagingDir)
+{
+}
+
+std::tuple<bool, fs::path, std::string> UploadStore::commit(const fs::path &staged, const std::string &sanitized, const std::string &digest,
+                                                            std::uint64_t length)
+{
+    auto shared = shareStored(sanitized, digest, length);
+    if (std::get<0>(shared))
+    {
+        std::error_code removeEc;
+        fs::remove(staged, removeEc);
+        duplicates.fetch_add(1, std::memory_order_relaxed);
+        bytesSaved.fetch_add(length, std::memory_order_relaxed);
+        return shared;
+    }
+
+    // New content, or stored content that could not be shared: the upload is kept and a private copy of
+    // it becomes the store entry.
+    storeObject(staged, digest);
+    return names->commit(staged, sanitized);
+}
+
+std::tuple<bool, fs::path, std::string> UploadStore::commitKnown(const std::string &sanitized, const std::string &digest, std::uint64_t length)
+{
+    auto shared = shareStored(sanitized, digest, length);
+    if (std::get<0>(shared))
+    {
+        earlyFinishes.fetch_add(1, std::memory_order_relaxed);
+        bytesSaved.fetch_add(length, std::memory_order_relaxed);
+    }
+    return shared;
+}
+
+UploadStore::Stats UploadStore::stats() const
+{
+    return Stats{stored.load(std::memory_order_relaxed), duplicates.load(std::memory_order_relaxed),
+                 earlyFinishes.load(std::memory_order_relaxed), bytesSaved.load(std::memory_order_relaxed)};
+}
+
+fs::path UploadStore::objectPath(const std::string &digest) const
+{
+    return storeDir / Util::String::encodeHex(digest);
+}
+
+std::tuple<bool, fs::path, std::string> UploadStore::shareStored(const std::string &sanitized, const std::string &digest, std::uint64_t length)
+{
+    Util::File::Fingerprint recorded;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        const auto it = objects.find(digest);
+        if (it == objects.end())
+        {
+            return {false, {}, {}};
+        }
+        recorded = it->second;
+    }
+    if (recorded.size != length)
+    {
+        return {false, {}, {}};
+    }
+
+    const fs::path object = objectPath(digest);
+    const auto [found, current] = Util::File::fingerprintFile(object);
+    if (!found || current != recorded)
+    {
+        discardObject(digest, recorded);
+        return {false, {}, {}};
+    }
+
+    const fs::path copy = Util::File::makeStagingPath(stagingDir);
+    std::error_code ec;
+    if (!Util::File::cloneFile(object, copy, ec))
+    {
+        return {false, {}, {}};
+    }
+    // A write that slipped in between the check and the clone shows in the times as well.
+    if (const auto [stillFound, after] = Util::File::fingerprintFile(object); !stillFound || after != recorded)
+    {
+        fs::remove(copy, ec);
+        discardObject(digest, recorded);
+        return {false, {}, {}};
+    }
+
+    Util::Checksum::copyCrc32c(object, copy);
+    auto committed = names->commit(copy, sanitized);
+    if (!std::get<0>(committed))
+    {
+        std::error_code removeEc;
+        fs::remove(copy, removeEc);
+    }
+    return committed;
+}
+
+void UploadStore::storeObject(const fs::path &staged, const std::string &digest)
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (objects.count(digest) != 0)
+        {
+            return;
+        }
+    }
+
+    // Fails when a concurrent upload of the same content got there first, or without reflinks.
+    const fs::path object = objectPath(digest);
+    std::error_code ec;
+    if (!Util::File::cloneFile(staged, object, ec))
+    {
+        return;
+    }
+    Util::Checksum::copyCrc32c(staged, object);
+    fs::permissions(object, fs::perms::owner_read, ec);
+    const auto [ok, fingerprint] = Util::File::fingerprintFile(object);
+    if (ec || !ok)
+    {
+        fs::remove(object, ec);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex);
+    objects.emplace(digest, fingerprint);
+    stored.fetch_add(1, std::memory_order_relaxed);
+}
+
+void UploadStore::discardObject(const std::string &digest, const Util::File::Fingerprint &fingerprint)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    const auto it = objects.find(digest);
+    if (it == objects.end() || it->second != fingerprint)
+    {
+        return;
+    }
+    objects.erase(it);
+    std::error_code ec;
+    fs::remove(objectPath(digest), ec);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include "./uploadNames.hpp"
+#include "utils/file.hpp"
+
+// Content-addressed storage behind --dedup. The first upload of each distinct content is reflinked into a
+// hidden directory under the hex SHA-256 of that content, as a private read-only object whose size, inode
+// and change times are recorded. A later upload of the same content is dropped and the object is reflinked
+// under the requested name instead, so identical uploads share their blocks while every visible file stays
+// a separate inode: editing one in place cannot reach the object or the other copies. An object that no
+// longer matches its record is discarded instead of shared. Without reflinks nothing is stored.
+class UploadStore
+{
+public:
+    struct Stats
+    {
+        std::uint64_t stored;
+        std::uint64_t duplicates;
+        std::uint64_t earlyFinishes;
+        std::uint64_t bytesSaved;
+    };
+
+    // Creates the store directory in `uploadsDir` and empties it. Objects from an earlier run have no record
+    // to be checked against, and one whose uploads were all deleted would hold its blocks for good.
+    static std::tuple<bool, std::filesystem::path, std::string> prepareDirectory(const std::filesystem::path &uploadsDir);
+
+    UploadStore(std::shared_ptr<UploadNames> names, const std::filesystem::path &storeDir, const std::filesystem::path &stagingDir);
+    UploadStore(const UploadStore &) = delete;
+    UploadStore &operator=(const UploadStore &) = delete;
+
+    // Moves a completed upload of `length` bytes with SHA-256 `digest` into place, sharing stored content
+    // when there is a match.
+    std::tuple<bool, std::filesystem::path, std::string> commit(const std::filesystem::path &staged, const std::string &sanitized,
+                                                                 const std::string &digest, std::uint64_t length);
+    // Saves stored content under `sanitized` without its data being sent, for a client that declared the
+    // digest up front. Fails with an empty message when no such content is stored.
+    std::tuple<bool, std::filesystem::path, std::string> commitKnown(const std::string &sanitized, const std::string &digest, std::uint64_t length);
+    Stats stats() const;
+
+private:
+    std::filesystem::path objectPath(const std::string &digest) const;
+    std::tuple<bool, std::filesystem::path, std::string> shareStored(const std::string &sanitized, const std::string &digest, std::uint64_t length);
+    void storeObject(const std::filesystem::path &staged, const std::string &digest);
+    // Forgets the object for `digest` and deletes it, unless it has been stored again since `fingerprint`.
+    void discardObject(const std::string &digest, const Util::File::Fingerprint &fingerprint);
+
+    const std::shared_ptr<UploadNames> names;
+    const std::filesystem::path storeDir;
+    const std::filesystem::path stagingDir;
+
+    std::mutex mutex;
+    // The fingerprint each object had when it was stored, by digest.
+    std::unordered_map<std::string, Util::File::Fingerprint> objects;
+
+    std::atomic<std::uint64_t> stored{0};
+    std::atomic<std::uint64_t> duplicates{0};
+    std::atomic<std::uint64_t> earlyFinishes{0};
+    std::atomic<std::uint64_t> bytesSaved{0};
+};
@@ -0,0 +1,514 @@
+#include "./checksum.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include "./string.hpp"
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define ACCIO_CRC32C_SSE42 1
+#define ACCIO_SHA256_SHANI 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define ACCIO_CRC32C_ARM 1
+#endif
+#ifdef __linux__
+#include <sys/xattr.h>
+#endif
+
+namespace Util::Checksum
+{
+    namespace
+    {
+        // Bit-reversed Castagnoli polynomial.
+        constexpr std::uint32_t polynomial = 0x82F63B78U;
+
+        // Slicing-by-8 tables: table[k][b] is the CRC of byte b followed by k zero bytes.
+        constexpr std::array<std::array<std::uint32_t, 256>, 8> makeTables()
+        {
+            std::array<std::array<std::uint32_t, 256>, 8> tables{};
+            for (std::uint32_t byte = 0; byte < 256; ++byte)
+            {
+                std::uint32_t crc = byte;
+                for (int bit = 0; bit < 8; ++bit)
+                {
+                    crc = (crc & 1U) != 0 ? (crc >> 1) ^ polynomial : crc >> 1;
+                }
+                tables[0][byte] = crc;
+            }
+            for (std::size_t k = 1; k < tables.size(); ++k)
+            {
+                for (std::uint32_t byte = 0; byte < 256; ++byte)
+                {
+                    const std::uint32_t previous = tables[k - 1][byte];
+                    tables[k][byte] = (previous >> 8) ^ tables[0][previous & 0xFFU];
+                }
+            }
+            return tables;
+        }
+
+        constexpr auto tables = makeTables();
+
+        std::uint32_t updateTable(std::uint32_t crc, const unsigned char *data, std::size_t length)
+        {
+            while (length >= 8)
+            {
+                std::uint32_t low = 0;
+                std::uint32_t high = 0;
+                std::memcpy(&low, data, 4);
+                std::memcpy(&high, data + 4, 4);
+                if constexpr (std::endian::native == std::endian::big)
+                {
+                    low = std::byteswap(low);
+                    high = std::byteswap(high);
+                }
+                low ^= crc;
+                crc = tables[7][low & 0xFFU] ^ tables[6][(low >> 8) & 0xFFU] ^ tables[5][(low >> 16) & 0xFFU] ^ tables[4][low >> 24]
+                      ^ tables[3][high & 0xFFU] ^ tables[2][(high >> 8) & 0xFFU] ^ tables[1][(high >> 16) & 0xFFU] ^ tables[0][high >> 24];
+                data += 8;
+                length -= 8;
+            }
+            while (length-- > 0)
+            {
+                crc = (crc >> 8) ^ tables[0][(crc ^ *data++) & 0xFFU];
+            }
+            return crc;
+        }
+
+#if defined(ACCIO_CRC32C_SSE42)
+        __attribute__((target("sse4.2"))) std::uint32_t updateHardware(std::uint32_t crc, const unsigned char *data, std::size_t length)
+        {
+            std::uint64_t crc64 = crc;
+            while (length >= 8)
+            {
+                std::uint64_t word = 0;
+                std::memcpy(&word, data, 8);
+                crc64 = _mm_crc32_u64(crc64, word);
+                data += 8;
+                length -= 8;
+            }
+            crc = static_cast<std::uint32_t>(crc64);
+            while (length-- > 0)
+            {
+                crc = _mm_crc32_u8(crc, *data++);
+            }
+            return crc;
+        }
+
+        const bool hardwareAvailable = __builtin_cpu_supports("sse4.2");
+#elif defined(ACCIO_CRC32C_ARM)
+        std::uint32_t updateHardware(std::uint32_t crc, const unsigned char *data, std::size_t length)
+        {
+            while (length >= 8)
+            {
+                std::uint64_t word = 0;
+                std::memcpy(&word, data, 8);
+                crc = __crc32cd(crc, word);
+                data += 8;
+                length -= 8;
+            }
+            while (length-- > 0)
+            {
+                crc = __crc32cb(crc, *data++);
+            }
+            return crc;
+        }
+
+        constexpr bool hardwareAvailable = true;
+#endif
+
+        // Multiplication modulo the polynomial, in the bit-reversed representation zlib's crc32_combine uses.
+        std::uint32_t multiplyModulo(std::uint32_t a, std::uint32_t b)
+        {
+            std::uint32_t mask = 1U << 31;
+            std::uint32_t product = 0;
+            while (mask != 0)
+            {
+                if ((a & mask) != 0)
+                {
+                    product ^= b;
+                }
+                b = (b & 1U) != 0 ? (b >> 1) ^ polynomial : b >> 1;
+                mask >>= 1;
+            }
+            return product;
+        }
+
+        // x^(2^k) modulo the polynomial for k = 0..31; powers repeat after that for this purpose.
+        constexpr std::size_t powerTableSize = 32;
+        const std::array<std::uint32_t, powerTableSize> powersOfTwo = [] {
+            std::array<std::uint32_t, powerTableSize> powers{};
+            std::uint32_t power = 1U << 30;
+            for (auto &entry : powers)
+            {
+                entry = power;
+                power = multiplyModulo(power, power);
+            }
+            return powers;
+        }();
+
+        // x^(8 * bytes) modulo the polynomial: the factor that shifts a CRC past `bytes` zero bytes.
+        std::uint32_t shiftFactor(std::uint64_t bytes)
+        {
+            std::uint32_t factor = 1U << 31;
+            std::size_t k = 3;
+            while (bytes != 0)
+            {
+                if ((bytes & 1U) != 0)
+                {
+                    factor = multiplyModulo(powersOfTwo[k % powerTableSize], factor);
+                }
+                bytes >>= 1;
+                ++k;
+            }
+            return factor;
+        }
+
+        constexpr std::string_view algorithmPrefix = "crc32c ";
+
+        constexpr std::array<std::uint32_t, 64> sha256RoundConstants = {
+            0x428a2f98U, 0x71374491U, 0xb5c0fbcfU, 0xe9b5dba5U, 0x3956c25bU, 0x59f111f1U, 0x923f82a4U, 0xab1c5ed5U,
+            0xd807aa98U, 0x12835b01U, 0x243185beU, 0x550c7dc3U, 0x72be5d74U, 0x80deb1feU, 0x9bdc06a7U, 0xc19bf174U,
+            0xe49b69c1U, 0xefbe4786U, 0x0fc19dc6U, 0x240ca1ccU, 0x2de92c6fU, 0x4a7484aaU, 0x5cb0a9dcU, 0x76f988daU,
+            0x983e5152U, 0xa831c66dU, 0xb00327c8U, 0xbf597fc7U, 0xc6e00bf3U, 0xd5a79147U, 0x06ca6351U, 0x14292967U,
+            0x27b70a85U, 0x2e1b2138U, 0x4d2c6dfcU, 0x53380d13U, 0x650a7354U, 0x766a0abbU, 0x81c2c92eU, 0x92722c85U,
+            0xa2bfe8a1U, 0xa81a664bU, 0xc24b8b70U, 0xc76c51a3U, 0xd192e819U, 0xd6990624U, 0xf40e3585U, 0x106aa070U,
+            0x19a4c116U, 0x1e376c08U, 0x2748774cU, 0x34b0bcb5U, 0x391c0cb3U, 0x4ed8aa4aU, 0x5b9cca4fU, 0x682e6ff3U,
+            0x748f82eeU, 0x78a5636fU, 0x84c87814U, 0x8cc70208U, 0x90befffaU, 0xa4506cebU, 0xbef9a3f7U, 0xc67178f2U};
+
+        constexpr std::string_view sha256Prefix = "sha-256=:";
+
+        void compressSha256Portable(std::uint32_t *state, const unsigned char *data, std::size_t blocks)
+        {
+            for (; blocks > 0; --blocks, data += 64)
+            {
+                std::array<std::uint32_t, 64> w;
+                for (std::size_t i = 0; i < 16; ++i)
+                {
+                    w[i] = (static_cast<std::uint32_t>(data[4 * i]) << 24) | (static_cast<std::uint32_t>(data[4 * i + 1]) << 16)
+                           | (static_cast<std::uint32_t>(data[4 * i + 2]) << 8) | static_cast<std::uint32_t>(data[4 * i + 3]);
+                }
+                for (std::size_t i = 16; i < 64; ++i)
+                {
+                    const std::uint32_t s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                    const std::uint32_t s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+                }
+
+                std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+                std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+                for (std::size_t i = 0; i < 64; ++i)
+                {
+                    const std::uint32_t t1 = h + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) + ((e & f) ^ (~e & g))
+                                             + sha256RoundConstants[i] + w[i];
+                    const std::uint32_t t2 = (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                    h = g;
+                    g = f;
+                    f = e;
+                    e = d + t1;
+                    d = c;
+                    c = b;
+                    b = a;
+                    a = t1 + t2;
+                }
+                state[0] += a;
+                state[1] += b;
+                state[2] += c;
+                state[3] += d;
+                state[4] += e;
+                state[5] += f;
+                state[6] += g;
+                state[7] += h;
+            }
+        }
+
+#if defined(ACCIO_SHA256_SHANI)
+        // Each sha256rnds2 performs two rounds on state split as ABEF/CDGH; sha256msg1/2 extend the schedule.
+        __attribute__((target("sha,sse4.1"))) void compressSha256Extensions(std::uint32_t *state, const unsigned char *data, std::size_t blocks)
+        {
+            const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+            __m128i swapped = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state)), 0xB1);
+            __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state + 4)), 0x1B);
+            __m128i state0 = _mm_alignr_epi8(swapped, state1, 8);
+            state1 = _mm_blend_epi16(state1, swapped, 0xF0);
+
+            for (; blocks > 0; --blocks, data += 64)
+            {
+                const __m128i savedState0 = state0;
+                const __m128i savedState1 = state1;
+                __m128i words[4];
+                for (int i = 0; i < 4; ++i)
+                {
+                    words[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * i)), byteSwap);
+                }
+                for (int i = 0; i < 16; ++i)
+                {
+                    if (i >= 4)
+                    {
+                        __m128i next = _mm_sha256msg1_epu32(words[i & 3], words[(i + 1) & 3]);
+                        next = _mm_add_epi32(next, _mm_alignr_epi8(words[(i + 3) & 3], words[(i + 2) & 3], 4));
+                        words[i & 3] = _mm_sha256msg2_epu32(next, words[(i + 3) & 3]);
+                    }
+                    __m128i message = _mm_add_epi32(words[i & 3], _mm_loadu_si128(reinterpret_cast<const __m128i *>(sha256RoundConstants.data() + 4 * i)));
+                    state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+                    message = _mm_shuffle_epi32(message, 0x0E);
+                    state0 = _mm_sha256rnds2_epu32(state0, state1, message);
+                }
+                state0 = _mm_add_epi32(state0, savedState0);
+                state1 = _mm_add_epi32(state1, savedState1);
+            }
+
+            swapped = _mm_shuffle_epi32(state0, 0x1B);
+            state1 = _mm_shuffle_epi32(state1, 0xB1);
+            state0 = _mm_blend_epi16(swapped, state1, 0xF0);
+            state1 = _mm_alignr_epi8(state1, swapped, 8);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(state), state0);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(state + 4), state1);
+        }
+
+        const bool shaExtensionsAvailable = __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+#endif
+
+        void compressSha256(std::uint32_t *state, const unsigned char *data, std::size_t blocks)
+        {
+#if defined(ACCIO_SHA256_SHANI)
+            if (shaExtensionsAvailable)
+            {
+                compressSha256Extensions(state, data, blocks);
+                return;
+            }
+#endif
+            compressSha256Portable(state, data, blocks);
+        }
+    } // namespace
+
+    void Crc32c::update(const char *data, std::size_t length)
+    {
+        const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+#if defined(ACCIO_CRC32C_SSE42) || defined(ACCIO_CRC32C_ARM)
+        if (hardwareAvailable)
+        {
+            state = updateHardware(state, bytes, length);
+            return;
+        }
+#endif
+        state = updateTable(state, bytes, length);
+    }
+
+    std::uint32_t Crc32c::value() const
+    {
+        return state ^ 0xFFFFFFFFU;
+    }
+
+    Sha256::Sha256()
+        : state{0x6a09e667U, 0xbb67ae85U, 0x3c6ef372U, 0xa54ff53aU, 0x510e527fU, 0x9b05688cU, 0x1f83d9abU, 0x5be0cd19U}
+    {
+    }
+
+    void Sha256::update(const char *data, std::size_t length)
+    {
+        const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+        totalLength += length;
+        if (pendingLength > 0)
+        {
+            const std::size_t toCopy = std::min(length, blockSize - pendingLength);
+            std::memcpy(pending.data() + pendingLength, bytes, toCopy);
+            pendingLength += toCopy;
+            bytes += toCopy;
+            length -= toCopy;
+            if (pendingLength < blockSize)
+            {
+                return;
+            }
+            compressSha256(state.data(), pending.data(), 1);
+            pendingLength = 0;
+        }
+
+        const std::size_t blocks = length / blockSize;
+        compressSha256(state.data(), bytes, blocks);
+        bytes += blocks * blockSize;
+        length -= blocks * blockSize;
+
+        std::memcpy(pending.data(), bytes, length);
+        pendingLength = length;
+    }
+
+    std::string Sha256::finish()
+    {
+        const std::uint64_t totalBits = totalLength * 8;
+        pending[pendingLength++] = 0x80;
+        if (pendingLength > blockSize - 8)
+        {
+            std::fill(pending.begin() + static_cast<std::ptrdiff_t>(pendingLength), pending.end(), 0);
+            compressSha256(state.data(), pending.data(), 1);
+            pendingLength = 0;
+        }
+        std::fill(pending.begin() + static_cast<std::ptrdiff_t>(pendingLength), pending.end() - 8, 0);
+        for (std::size_t i = 0; i < 8; ++i)
+        {
+            pending[blockSize - 1 - i] = static_cast<unsigned char>(totalBits >> (8 * i));
+        }
+        compressSha256(state.data(), pending.data(), 1);
+
+        std::string digest(digestSize, '\0');
+        for (std::size_t i = 0; i < state.size(); ++i)
+        {
+            digest[4 * i] = static_cast<char>(state[i] >> 24);
+            digest[4 * i + 1] = static_cast<char>(state[i] >> 16);
+            digest[4 * i + 2] = static_cast<char>(state[i] >> 8);
+            digest[4 * i + 3] = static_cast<char>(state[i]);
+        }
+        return digest;
+    }
+
+    std::string hmacSha256(std::string_view key, std::string_view message)
+    {
+        constexpr std::size_t blockSize = 64;
+        std::string block(key);
+        if (block.size() > blockSize)
+        {
+            Sha256 keyHash;
+            keyHash.update(block.data(), block.size());
+            block = keyHash.finish();
+        }
+        block.resize(blockSize, '\0');
+
+        std::string innerPad = block;
+        std::string outerPad = block;
+        for (std::size_t i = 0; i < blockSize; ++i)
+        {
+            innerPad[i] = static_cast<char>(innerPad[i] ^ 0x36);
+            outerPad[i] = static_cast<char>(outerPad[i] ^ 0x5C);
+        }
+
+        Sha256 inner;
+        inner.update(innerPad.data(), innerPad.size());
+        inner.update(message.data(), message.size());
+        const std::string innerDigest = inner.finish();
+
+        Sha256 outer;
+        outer.update(outerPad.data(), outerPad.size());
+        outer.update(innerDigest.data(), innerDigest.size());
+        return outer.finish();
+    }
+
+    std::string pbkdf2Sha256(std::string_view password, std::string_view salt, unsigned iterations)
+    {
+        std::string block(salt);
+        block.append("\0\0\0\1", 4);
+        std::string round = hmacSha256(password, block);
+        std::string result = round;
+        for (unsigned i = 1; i < iterations; ++i)
+        {
+            round = hmacSha256(password, round);
+            for (std::size_t j = 0; j < result.size(); ++j)
+            {
+                result[j] = static_cast<char>(result[j] ^ round[j]);
+            }
+        }
+        return result;
+    }
+
+    bool equalConstantTime(std::string_view lhs, std::string_view rhs)
+    {
+        if (lhs.size() != rhs.size())
+        {
+            return false;
+        }
+        unsigned char difference = 0;
+        for (std::size_t i = 0; i < lhs.size(); ++i)
+        {
+            difference |= static_cast<unsigned char>(lhs[i] ^ rhs[i]);
+        }
+        return difference == 0;
+    }
+
+    std::uint32_t combineCrc32c(std::uint32_t first, std::uint32_t second, std::uint64_t secondLength)
+    {
+        return multiplyModulo(shiftFactor(secondLength), first) ^ second;
+    }
+
+    std::string formatCrc32c(std::uint32_t crc)
+    {
+        const char digest[] = {static_cast<char>(crc >> 24), static_cast<char>(crc >> 16), static_cast<char>(crc >> 8), static_cast<char>(crc)};
+        return std::string{algorithmPrefix} + Util::String::encodeBase64(std::string_view{digest, sizeof(digest)});
+    }
+
+    std::tuple<bool, std::uint32_t> parseCrc32c(std::string_view header)
+    {
+        while (!header.empty() && (header.back() == ' ' || header.back() == '\t'))
+        {
+            header.remove_suffix(1);
+        }
+        std::string digest;
+        if (header.substr(0, algorithmPrefix.size()) != algorithmPrefix
+            || !Util::String::decodeBase64(header.substr(algorithmPrefix.size()), digest) || digest.size() != 4)
+        {
+            return {false, 0};
+        }
+
+        std::uint32_t crc = 0;
+        for (const char byte : digest)
+        {
+            crc = (crc << 8) | static_cast<unsigned char>(byte);
+        }
+        return {true, crc};
+    }
+
+    std::string formatSha256(std::string_view digest)
+    {
+        return std::string{sha256Prefix} + Util::String::encodeBase64(digest) + ":";
+    }
+
+    std::tuple<bool, std::string> parseSha256(std::string_view header)
+    {
+        while (!header.empty())
+        {
+            const std::size_t comma = header.find(',');
+            std::string_view member = header.substr(0, comma);
+            header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+
+            while (!member.empty() && (member.front() == ' ' || member.front() == '\t'))
+            {
+                member.remove_prefix(1);
+            }
+            while (!member.empty() && (member.back() == ' ' || member.back() == '\t'))
+            {
+                member.remove_suffix(1);
+            }
+            if (member.size() <= sha256Prefix.size() || member.substr(0, sha256Prefix.size()) != sha256Prefix || member.back() != ':')
+            {
+                continue;
+            }
+
+            std::string digest;
+            const std::string_view encoded = member.substr(sha256Prefix.size(), member.size() - sha256Prefix.size() - 1);
+            if (Util::String::decodeBase64(encoded, digest) && digest.size() == Sha256::digestSize)
+            {
+                return {true, std::move(digest)};
+            }
+            return {false, {}};
+        }
+        return {false, {}};
+    }
+
+    void storeCrc32c([[maybe_unused]] const std::filesystem::path &path, [[maybe_unused]] std::uint32_t crc)
+    {
+#ifdef __linux__
+        const std::string value = formatCrc32c(crc);
+        ::setxattr(path.c_str(), "user.accio.crc32c", value.data(), value.size(), 0);
+#endif
+    }
+
+    void copyCrc32c([[maybe_unused]] const std::filesystem::path &from, [[maybe_unused]] const std::filesystem::path &to)
+    {
+#ifdef __linux__
+        char value[64];
+        const ssize_t length = ::getxattr(from.c_str(), "user.accio.crc32c", value, sizeof(value));
+        if (length > 0)
+        {
+            ::setxattr(to.c_str(), "user.accio.crc32c", value, static_cast<std::size_t>(length), 0);
+        }
+#endif
+    }
+} // namespace Util::Checksum
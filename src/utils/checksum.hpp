@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+namespace Util::Checksum
+{
+    // CRC-32C (Castagnoli), computed with the SSE4.2 or ARMv8 CRC instructions when the CPU has them and
+    // with a table otherwise. It is cheap enough to run on every upload as the data streams through.
+    class Crc32c
+    {
+    public:
+        void update(const char *data, std::size_t length);
+        std::uint32_t value() const;
+
+    private:
+        std::uint32_t state = 0xFFFFFFFFU;
+    };
+
+    // SHA-256, using the x86 SHA extensions when the CPU has them. It names upload content for
+    // deduplication, where a CRC's easy collisions could merge different files.
+    class Sha256
+    {
+    public:
+        static constexpr std::size_t digestSize = 32;
+
+        Sha256();
+        void update(const char *data, std::size_t length);
+        // The 32 digest bytes. The object must not be updated afterwards.
+        std::string finish();
+
+    private:
+        static constexpr std::size_t blockSize = 64;
+
+        std::array<std::uint32_t, 8> state;
+        std::array<unsigned char, blockSize> pending{};
+        std::size_t pendingLength = 0;
+        std::uint64_t totalLength = 0;
+    };
+
+    // HMAC-SHA256 (RFC 2104) of `message` under `key`; the 32 raw bytes.
+    std::string hmacSha256(std::string_view key, std::string_view message);
+    // PBKDF2-HMAC-SHA256 (RFC 8018) of `password`; the first 32-byte block, which is all a key or verifier
+    // of this size needs. `iterations` sets how slow each guess at the password is.
+    std::string pbkdf2Sha256(std::string_view password, std::string_view salt, unsigned iterations);
+    // Compares secrets in time that depends only on their length, so a mismatch does not reveal how many
+    // leading bytes were right.
+    bool equalConstantTime(std::string_view lhs, std::string_view rhs);
+
+    // CRC of two pieces joined, from their separate CRCs, so chunks hashed out of order still yield the
+    // CRC of the whole file. Costs O(log secondLength), independent of the data.
+    std::uint32_t combineCrc32c(std::uint32_t first, std::uint32_t second, std::uint64_t secondLength);
+
+    // The `Upload-Checksum` header as tus defines it: the algorithm name, a space and the base64 digest,
+    // such as "crc32c 4waSgw==". crc32c is the only algorithm accepted.
+    std::string formatCrc32c(std::uint32_t crc);
+    std::tuple<bool, std::uint32_t> parseCrc32c(std::string_view header);
+
+    // The `Repr-Digest` header of RFC 9530 for a SHA-256 digest: "sha-256=:<base64>:". Parsing picks the
+    // sha-256 member out of a header that may list several algorithms.
+    std::string formatSha256(std::string_view digest);
+    std::tuple<bool, std::string> parseSha256(std::string_view header);
+
+    // Keeps the digest with the file in the "user.accio.crc32c" extended attribute. Filesystems without
+    // extended attributes, and platforms other than Linux, simply go without.
+    void storeCrc32c(const std::filesystem::path &path, std::uint32_t crc);
+    // Carries the stored digest over to a reflinked copy, which does not inherit extended attributes.
+    void copyCrc32c(const std::filesystem::path &from, const std::filesystem::path &to);
+} // namespace Util::Checksum
@@ -0,0 +1,438 @@
+#include "./compression.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <vector>
+#ifdef ACCIO_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef ACCIO_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef ACCIO_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Util::Compression
+{
+    namespace
+    {
+        constexpr std::size_t outputBlockSize = 16U * 1024U;
+        // zlib counts input in 32-bit units; larger writes are fed in slices.
+        constexpr std::size_t maxInputSlice = 1U << 30;
+
+        // Levels favour latency: responses are compressed while the client waits for them.
+        constexpr int gzipLevel = 6;
+        constexpr int brotliQuality = 5;
+        constexpr int zstdLevel = 3;
+
+        enum class Mode
+        {
+            Process,
+            Flush,
+            Finish
+        };
+
+        bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs)
+        {
+            return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+                       return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+                   });
+        }
+
+        std::string_view trim(std::string_view text)
+        {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+            {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+
+        // Parses a qvalue ("0", "0.5", "1.000") into thousandths; malformed values count as 0.
+        int parseQuality(std::string_view text)
+        {
+            text = trim(text);
+            if (text.empty() || (text[0] != '0' && text[0] != '1'))
+            {
+                return 0;
+            }
+
+            int quality = (text[0] - '0') * 1000;
+            if (text.size() > 1)
+            {
+                if (text[1] != '.' || text.size() > 5)
+                {
+                    return 0;
+                }
+                int scale = 100;
+                for (std::size_t i = 2; i < text.size(); ++i, scale /= 10)
+                {
+                    if (!std::isdigit(static_cast<unsigned char>(text[i])))
+                    {
+                        return 0;
+                    }
+                    quality += (text[i] - '0') * scale;
+                }
+            }
+            return std::min(quality, 1000);
+        }
+    } // namespace
+
+    std::string_view encodingToken(Encoding encoding)
+    {
+        switch (encoding)
+        {
+        case Encoding::Zstd:
+            return "zstd";
+        case Encoding::Brotli:
+            return "br";
+        case Encoding::Gzip:
+            return "gzip";
+        case Encoding::Deflate:
+            return "deflate";
+        case Encoding::Identity:
+            break;
+        }
+        return "identity";
+    }
+
+    std::span<const Encoding> availableEncodings()
+    {
+        static const std::vector<Encoding> encodings = []() {
+            std::vector<Encoding> result;
+#ifdef ACCIO_HAVE_ZSTD
+            result.push_back(Encoding::Zstd);
+#endif
+#ifdef ACCIO_HAVE_BROTLI
+            result.push_back(Encoding::Brotli);
+#endif
+#ifdef ACCIO_HAVE_ZLIB
+            result.push_back(Encoding::Gzip);
+            result.push_back(Encoding::Deflate);
+#endif
+            return result;
+        }();
+        return encodings;
+    }
+
+    Encoding negotiate(std::string_view acceptEncoding, std::span<const Encoding> offered)
+    {
+        struct Preference
+        {
+            std::string_view coding;
+            int quality;
+        };
+
+        std::vector<Preference> preferences;
+        int wildcardQuality = -1;
+        while (!acceptEncoding.empty())
+        {
+            const std::size_t comma = acceptEncoding.find(',');
+            std::string_view item = acceptEncoding.substr(0, comma);
+            acceptEncoding = comma == std::string_view::npos ? std::string_view{} : acceptEncoding.substr(comma + 1);
+
+            int quality = 1000;
+            const std::size_t semicolon = item.find(';');
+            if (semicolon != std::string_view::npos)
+            {
+                const std::string_view parameter = trim(item.substr(semicolon + 1));
+                if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=')
+                {
+                    quality = parseQuality(parameter.substr(2));
+                }
+                item = item.substr(0, semicolon);
+            }
+
+            item = trim(item);
+            if (item == "*")
+            {
+                wildcardQuality = quality;
+            }
+            else if (!item.empty())
+            {
+                preferences.push_back(Preference{item, quality});
+            }
+        }
+
+        Encoding best = Encoding::Identity;
+        int bestQuality = 0;
+        for (const Encoding encoding : offered)
+        {
+            const std::string_view token = encodingToken(encoding);
+            int quality = wildcardQuality;
+            for (const auto &preference : preferences)
+            {
+                if (equalsIgnoreCase(preference.coding, token) || (encoding == Encoding::Gzip && equalsIgnoreCase(preference.coding, "x-gzip")))
+                {
+                    quality = preference.quality;
+                    break;
+                }
+            }
+
+            if (quality > bestQuality)
+            {
+                best = encoding;
+                bestQuality = quality;
+            }
+        }
+        return best;
+    }
+
+    std::tuple<bool, std::string> compress(Encoding encoding, std::string_view data)
+    {
+        Encoder encoder;
+        if (!encoder.open(encoding))
+        {
+            return {false, std::string{}};
+        }
+
+        std::string output;
+        output.reserve(data.size() / 3 + 64U);
+        const auto append = [&output](const char *chunk, std::size_t length) {
+            output.append(chunk, length);
+            return true;
+        };
+
+        if (!encoder.write(data.data(), data.size(), false, append) || !encoder.finish(append))
+        {
+            return {false, std::string{}};
+        }
+        return {true, std::move(output)};
+    }
+
+    struct Encoder::State
+    {
+        Encoding encoding = Encoding::Identity;
+        std::unique_ptr<char[]> buffer;
+#ifdef ACCIO_HAVE_ZLIB
+        z_stream zlib{};
+        bool zlibActive = false;
+#endif
+#ifdef ACCIO_HAVE_BROTLI
+        BrotliEncoderState *brotli = nullptr;
+#endif
+#ifdef ACCIO_HAVE_ZSTD
+        ZSTD_CCtx *zstd = nullptr;
+#endif
+
+        ~State()
+        {
+#ifdef ACCIO_HAVE_ZLIB
+            if (zlibActive)
+            {
+                deflateEnd(&zlib);
+            }
+#endif
+#ifdef ACCIO_HAVE_BROTLI
+            if (brotli != nullptr)
+            {
+                BrotliEncoderDestroyInstance(brotli);
+            }
+#endif
+#ifdef ACCIO_HAVE_ZSTD
+            if (zstd != nullptr)
+            {
+                ZSTD_freeCCtx(zstd);
+            }
+#endif
+        }
+
+        // Parameters go unused in builds without any codec.
+        bool run([[maybe_unused]] const char *data, [[maybe_unused]] std::size_t length, [[maybe_unused]] Mode mode, [[maybe_unused]] const Writer &write)
+        {
+            [[maybe_unused]] char *out = buffer.get();
+            switch (encoding)
+            {
+#ifdef ACCIO_HAVE_ZLIB
+            case Encoding::Gzip:
+            case Encoding::Deflate:
+            {
+                zlib.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+                zlib.avail_in = static_cast<uInt>(length);
+                const int flush = mode == Mode::Finish ? Z_FINISH : (mode == Mode::Flush ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+                while (true)
+                {
+                    zlib.next_out = reinterpret_cast<Bytef *>(out);
+                    zlib.avail_out = static_cast<uInt>(outputBlockSize);
+                    const int result = deflate(&zlib, flush);
+                    if (result == Z_STREAM_ERROR)
+                    {
+                        return false;
+                    }
+
+                    const std::size_t produced = outputBlockSize - zlib.avail_out;
+                    if (produced > 0 && !write(out, produced))
+                    {
+                        return false;
+                    }
+
+                    if (mode == Mode::Finish ? result == Z_STREAM_END : zlib.avail_out != 0)
+                    {
+                        return true;
+                    }
+                }
+            }
+#endif
+#ifdef ACCIO_HAVE_BROTLI
+            case Encoding::Brotli:
+            {
+                const auto *nextIn = reinterpret_cast<const std::uint8_t *>(data);
+                std::size_t availableIn = length;
+                const BrotliEncoderOperation operation =
+                    mode == Mode::Finish ? BROTLI_OPERATION_FINISH : (mode == Mode::Flush ? BROTLI_OPERATION_FLUSH : BROTLI_OPERATION_PROCESS);
+                while (true)
+                {
+                    auto *nextOut = reinterpret_cast<std::uint8_t *>(out);
+                    std::size_t availableOut = outputBlockSize;
+                    if (!BrotliEncoderCompressStream(brotli, operation, &availableIn, &nextIn, &availableOut, &nextOut, nullptr))
+                    {
+                        return false;
+                    }
+
+                    const std::size_t produced = outputBlockSize - availableOut;
+                    if (produced > 0 && !write(out, produced))
+                    {
+                        return false;
+                    }
+
+                    if (availableIn == 0 && !BrotliEncoderHasMoreOutput(brotli)
+                        && (mode != Mode::Finish || BrotliEncoderIsFinished(brotli)))
+                    {
+                        return true;
+                    }
+                }
+            }
+#endif
+#ifdef ACCIO_HAVE_ZSTD
+            case Encoding::Zstd:
+            {
+                ZSTD_inBuffer input{data, length, 0};
+                const ZSTD_EndDirective directive = mode == Mode::Finish ? ZSTD_e_end : (mode == Mode::Flush ? ZSTD_e_flush : ZSTD_e_continue);
+                while (true)
+                {
+                    ZSTD_outBuffer output{out, outputBlockSize, 0};
+                    const std::size_t remaining = ZSTD_compressStream2(zstd, &output, &input, directive);
+                    if (ZSTD_isError(remaining))
+                    {
+                        return false;
+                    }
+
+                    if (output.pos > 0 && !write(out, output.pos))
+                    {
+                        return false;
+                    }
+
+                    if (mode == Mode::Process ? input.pos == input.size : remaining == 0)
+                    {
+                        return true;
+                    }
+                }
+            }
+#endif
+            default:
+                break;
+            }
+            return false;
+        }
+    };
+
+    Encoder::Encoder() = default;
+
+    Encoder::~Encoder() = default;
+
+    bool Encoder::open(Encoding encoding)
+    {
+        state.reset();
+        if (std::find(availableEncodings().begin(), availableEncodings().end(), encoding) == availableEncodings().end())
+        {
+            return false;
+        }
+
+        auto opened = std::make_unique<State>();
+        opened->encoding = encoding;
+        switch (encoding)
+        {
+#ifdef ACCIO_HAVE_ZLIB
+        case Encoding::Gzip:
+        case Encoding::Deflate:
+        {
+            // 16 + MAX_WBITS selects the gzip wrapper; plain MAX_WBITS is the zlib format HTTP calls "deflate".
+            const int windowBits = encoding == Encoding::Gzip ? 16 + MAX_WBITS : MAX_WBITS;
+            if (deflateInit2(&opened->zlib, gzipLevel, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                return false;
+            }
+            opened->zlibActive = true;
+            break;
+        }
+#endif
+#ifdef ACCIO_HAVE_BROTLI
+        case Encoding::Brotli:
+            opened->brotli = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+            if (opened->brotli == nullptr)
+            {
+                return false;
+            }
+            BrotliEncoderSetParameter(opened->brotli, BROTLI_PARAM_QUALITY, brotliQuality);
+            BrotliEncoderSetParameter(opened->brotli, BROTLI_PARAM_MODE, BROTLI_MODE_TEXT);
+            break;
+#endif
+#ifdef ACCIO_HAVE_ZSTD
+        case Encoding::Zstd:
+            opened->zstd = ZSTD_createCCtx();
+            if (opened->zstd == nullptr || ZSTD_isError(ZSTD_CCtx_setParameter(opened->zstd, ZSTD_c_compressionLevel, zstdLevel)))
+            {
+                return false;
+            }
+            break;
+#endif
+        default:
+            return false;
+        }
+
+        opened->buffer = std::make_unique<char[]>(outputBlockSize);
+        state = std::move(opened);
+        return true;
+    }
+
+    bool Encoder::isOpen() const
+    {
+        return state != nullptr;
+    }
+
+    bool Encoder::write(const char *data, std::size_t length, bool flush, const Writer &write)
+    {
+        if (!state)
+        {
+            return false;
+        }
+
+        while (length > maxInputSlice)
+        {
+            if (!state->run(data, maxInputSlice, Mode::Process, write))
+            {
+                return false;
+            }
+            data += maxInputSlice;
+            length -= maxInputSlice;
+        }
+        return state->run(data, length, flush ? Mode::Flush : Mode::Process, write);
+    }
+
+    bool Encoder::finish(const Writer &write)
+    {
+        if (!state)
+        {
+            return false;
+        }
+
+        const bool finished = state->run(nullptr, 0, Mode::Finish, write);
+        state.reset();
+        return finished;
+    }
+} // namespace Util::Compression
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+namespace Util::Compression
+{
+    enum class Encoding
+    {
+        Identity,
+        Zstd,
+        Brotli,
+        Gzip,
+        Deflate
+    };
+
+    // The content-coding token used in Accept-Encoding and Content-Encoding.
+    std::string_view encodingToken(Encoding encoding);
+
+    // Encodings this build can produce at run time, most preferred first.
+    std::span<const Encoding> availableEncodings();
+
+    // Picks the encoding from `offered` with the highest q-value in `acceptEncoding`, breaking ties by the
+    // order of `offered`. Returns Identity when the client accepts none of them.
+    Encoding negotiate(std::string_view acceptEncoding, std::span<const Encoding> offered);
+
+    std::tuple<bool, std::string> compress(Encoding encoding, std::string_view data);
+
+    // Incremental compressor for streamed responses.
+    class Encoder
+    {
+    public:
+        using Writer = std::function<bool(const char *data, std::size_t length)>;
+
+        Encoder();
+        ~Encoder();
+        Encoder(const Encoder &) = delete;
+        Encoder &operator=(const Encoder &) = delete;
+
+        bool open(Encoding encoding);
+        bool isOpen() const;
+
+        // Compresses `data` and hands any finished output to `write`. With `flush` set, everything
+        // written so far is made decodable by the client before returning.
+        bool write(const char *data, std::size_t length, bool flush, const Writer &write);
+        bool finish(const Writer &write);
+
+    private:
+        struct State;
+        std::unique_ptr<State> state;
+    };
+} // namespace Util::Compression
@@ -0,0 +1,278 @@
+#include "./directoryScanner.hpp"
+#include "./file.hpp"
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Util
+{
+#ifdef __linux__
+    namespace
+    {
+        // Layout of struct linux_dirent64, which glibc does not export.
+        constexpr std::size_t direntReclenOffset = 16U;
+        constexpr std::size_t direntTypeOffset = 18U;
+        constexpr std::size_t direntNameOffset = 19U;
+        constexpr std::size_t direntBufferSize = 32U * 1024U;
+
+        std::atomic<bool> statxUnsupported{false};
+
+        void applyMode(DirectoryScanner::Entry &entry, mode_t mode, std::uintmax_t size, std::int64_t mtimeSeconds)
+        {
+            entry.isDirectory = S_ISDIR(mode);
+            entry.isRegularFile = S_ISREG(mode);
+            entry.size = entry.isRegularFile ? size : 0;
+            entry.mtimeSeconds = mtimeSeconds;
+            entry.hasMetadata = true;
+        }
+
+        // One statx (or fstatat on kernels without it) relative to the directory descriptor. Returns the
+        // raw mode so callers can tell symlinks apart when `follow` is false.
+        bool statAt(int directoryFd, const char *name, bool follow, DirectoryScanner::Entry &entry, mode_t &mode)
+        {
+#ifdef STATX_BASIC_STATS
+            if (!statxUnsupported.load(std::memory_order_relaxed))
+            {
+                struct statx info{};
+                const int flags = follow ? 0 : AT_SYMLINK_NOFOLLOW;
+                if (::statx(directoryFd, name, flags, STATX_TYPE | STATX_SIZE | STATX_MTIME, &info) == 0)
+                {
+                    mode = info.stx_mode;
+                    applyMode(entry, info.stx_mode, static_cast<std::uintmax_t>(info.stx_size), static_cast<std::int64_t>(info.stx_mtime.tv_sec));
+                    return true;
+                }
+                if (errno != ENOSYS)
+                {
+                    return false;
+                }
+                statxUnsupported.store(true, std::memory_order_relaxed);
+            }
+#endif
+            struct stat info{};
+            if (::fstatat(directoryFd, name, &info, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+            {
+                return false;
+            }
+            mode = info.st_mode;
+            applyMode(entry, info.st_mode, static_cast<std::uintmax_t>(info.st_size), static_cast<std::int64_t>(info.st_mtime));
+            return true;
+        }
+    } // namespace
+#endif
+
+    DirectoryScanner::~DirectoryScanner()
+    {
+        close();
+    }
+
+    bool DirectoryScanner::open(const std::filesystem::path &directory)
+    {
+        close();
+        path = directory;
+
+#ifdef __linux__
+        fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        alignas(8) char buffer[direntBufferSize];
+        while (true)
+        {
+            const long readBytes = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+            if (readBytes < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (readBytes < 0)
+            {
+                close();
+                return false;
+            }
+            if (readBytes == 0)
+            {
+                break;
+            }
+
+            unsigned short recordLength = 0;
+            for (long offset = 0; offset < readBytes; offset += recordLength)
+            {
+                const char *record = buffer + offset;
+                std::memcpy(&recordLength, record + direntReclenOffset, sizeof(recordLength));
+                const unsigned char type = static_cast<unsigned char>(record[direntTypeOffset]);
+                const char *name = record + direntNameOffset;
+                if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0)
+                {
+                    continue;
+                }
+
+                Entry entry;
+                entry.name = name;
+                mode_t mode = 0;
+                switch (type)
+                {
+                case DT_DIR:
+                    entry.isDirectory = true;
+                    break;
+                case DT_REG:
+                    entry.isRegularFile = true;
+                    break;
+                case DT_LNK:
+                    // The listing shows what the link points at; a dangling link keeps empty metadata.
+                    entry.isSymlink = true;
+                    entry.hasMetadata = true;
+                    statAt(fd, name, true, entry, mode);
+                    break;
+                case DT_UNKNOWN:
+                    if (statAt(fd, name, false, entry, mode) && S_ISLNK(mode))
+                    {
+                        entry = Entry{};
+                        entry.name = name;
+                        entry.isSymlink = true;
+                        entry.hasMetadata = true;
+                        statAt(fd, name, true, entry, mode);
+                    }
+                    break;
+                default:
+                    break;
+                }
+                items.push_back(std::move(entry));
+            }
+        }
+#else
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it{directory, ec}, end; !ec && it != end; it.increment(ec))
+        {
+            Entry entry;
+            entry.name = it->path().filename().string();
+            std::error_code typeEc;
+            entry.isSymlink = it->is_symlink(typeEc);
+            entry.isDirectory = it->is_directory(typeEc);
+            entry.isRegularFile = it->is_regular_file(typeEc);
+            items.push_back(std::move(entry));
+        }
+        if (ec)
+        {
+            close();
+            return false;
+        }
+#endif
+
+        opened = true;
+        return true;
+    }
+
+    void DirectoryScanner::close()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+#endif
+        items.clear();
+        opened = false;
+    }
+
+    bool DirectoryScanner::isOpen() const
+    {
+        return opened;
+    }
+
+    std::vector<DirectoryScanner::Entry> &DirectoryScanner::entries()
+    {
+        return items;
+    }
+
+    void DirectoryScanner::collectMetadata(unsigned threads)
+    {
+        const std::size_t count = items.size();
+        const std::size_t workers = std::min<std::size_t>(threads, count / entriesPerThread);
+        if (workers <= 1)
+        {
+            collectRange(0, count);
+            return;
+        }
+
+        // Workers claim small batches so one slow stat does not hold up a whole share of the directory.
+        constexpr std::size_t batchSize = 64U;
+        std::atomic<std::size_t> nextIndex{0};
+        const auto work = [this, count, &nextIndex]() {
+            while (true)
+            {
+                const std::size_t begin = nextIndex.fetch_add(batchSize, std::memory_order_relaxed);
+                if (begin >= count)
+                {
+                    return;
+                }
+                collectRange(begin, std::min(count, begin + batchSize));
+            }
+        };
+
+        std::vector<std::thread> helpers;
+        helpers.reserve(workers - 1);
+        for (std::size_t i = 1; i < workers; ++i)
+        {
+            try
+            {
+                helpers.emplace_back(work);
+            }
+            catch (const std::system_error &)
+            {
+                // The calling thread finishes whatever the missing helpers would have taken.
+                break;
+            }
+        }
+        work();
+        for (std::thread &helper : helpers)
+        {
+            helper.join();
+        }
+    }
+
+    void DirectoryScanner::collectRange(std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            Entry &entry = items[i];
+            if (entry.hasMetadata)
+            {
+                continue;
+            }
+
+#ifdef __linux__
+            mode_t mode = 0;
+            statAt(fd, entry.name.c_str(), true, entry, mode);
+#else
+            const std::filesystem::path entryPath = path / entry.name;
+            std::error_code ec;
+            if (entry.isRegularFile)
+            {
+                entry.size = std::filesystem::file_size(entryPath, ec);
+                if (ec)
+                {
+                    entry.size = 0;
+                }
+            }
+            const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(entryPath, ec);
+            if (!ec)
+            {
+                entry.mtimeSeconds = Util::File::toUnixNanoseconds(writeTime) / 1000000000LL;
+            }
+            entry.hasMetadata = true;
+#endif
+        }
+    }
+} // namespace Util
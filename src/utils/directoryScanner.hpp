@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Util
+{
+    // Reads a directory for a listing with as few syscalls as the platform allows. On Linux the names and
+    // types come from getdents64 batches and d_type, and collectMetadata() then issues one statx per entry
+    // for size and mtime; elsewhere it falls back to std::filesystem.
+    class DirectoryScanner
+    {
+    public:
+        struct Entry
+        {
+            std::string name;
+            // Types of symlinks are those of their targets; a dangling symlink is neither.
+            bool isDirectory = false;
+            bool isRegularFile = false;
+            bool isSymlink = false;
+            bool hasMetadata = false;
+            std::uintmax_t size = 0;
+            std::int64_t mtimeSeconds = 0;
+        };
+
+        DirectoryScanner() = default;
+        ~DirectoryScanner();
+        DirectoryScanner(const DirectoryScanner &) = delete;
+        DirectoryScanner &operator=(const DirectoryScanner &) = delete;
+
+        // Reads every name and type of `directory`. Symlinks and entries whose type the filesystem does
+        // not report are stat'ed right away, so their metadata is already complete.
+        bool open(const std::filesystem::path &directory);
+        void close();
+        bool isOpen() const;
+
+        // Callers may remove entries they will not list before collecting metadata for the rest.
+        std::vector<Entry> &entries();
+
+        // Fills size and mtime of entries that lack them, spread over up to `threads` threads when the
+        // directory is large enough for that to pay off on high-latency filesystems.
+        void collectMetadata(unsigned threads);
+
+    private:
+        static constexpr std::size_t entriesPerThread = 256U;
+
+        void collectRange(std::size_t begin, std::size_t end);
+
+        std::filesystem::path path;
+        std::vector<Entry> items;
+        bool opened = false;
+#ifdef __linux__
+        int fd = -1;
+#endif
+    };
+} // namespace Util
@@ -9,10 +9,23 @@
 #include <algorithm>
 #include <cstdlib>
 #include <stdexcept>
+#include <chrono>
+#include <system_error>
+#include "./string.hpp"
 #ifdef _WIN32
 #include <shlobj.h>
 #include <knownfolders.h>
 #include <windows.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
 #endif
 
 namespace Util::File
@@ -276,32 +289,6 @@ namespace Util::File
         return {true, sanitized};
     }
 
-    std::tuple<bool, fs::path, std::string> chooseUploadDestination(const fs::path &uploadsDir, const std::string &sanitized)
-    {
-        fs::path base = uploadsDir / sanitized;
-        fs::path destination = base;
-        std::error_code ec;
-        std::size_t suffix = 1;
-        while (fs::exists(destination, ec))
-        {
-            if (ec)
-            {
-                return {false, {}, ec.message()};
-            }
-
-            const std::string stem = base.stem().string();
-            const std::string extension = base.extension().string();
-            destination = uploadsDir / (stem + "_" + std::to_string(suffix) + extension);
-            ++suffix;
-        }
-        if (ec)
-        {
-            return {false, {}, ec.message()};
-        }
-
-        return {true, destination, {}};
-    }
-
     bool isWithinBase(const fs::path &candidate, const fs::path &base)
     {
         std::error_code ec;
@@ -398,6 +385,26 @@ namespace Util::File
         return baseDir / "accio";
     }
 
+    fs::path getDefaultSessionKeyPath()
+    {
+#ifdef _WIN32
+        if (const char *localAppData = std::getenv("LOCALAPPDATA"); localAppData && *localAppData != '\0')
+        {
+            return fs::path{localAppData} / "accio" / "session.key";
+        }
+#else
+        if (const char *stateHome = std::getenv("XDG_STATE_HOME"); stateHome && *stateHome == '/')
+        {
+            return fs::path{stateHome} / "accio" / "session.key";
+        }
+#endif
+        if (const fs::path home = getHomeDirectory(); !home.empty())
+        {
+            return home / ".local" / "state" / "accio" / "session.key";
+        }
+        return {};
+    }
+
     std::tuple<bool, fs::path, std::string> resolveUploadsDirectory(const fs::path &candidateInput)
     {
         if (candidateInput.empty())
@@ -449,6 +456,158 @@ namespace Util::File
         return {true, canonical, {}};
     }
 
+    std::tuple<bool, fs::path, std::string> prepareStagingDirectory(const fs::path &uploadsDir)
+    {
+        const fs::path stagingDir = uploadsDir / ".accio-staging";
+        std::error_code ec;
+        fs::create_directories(stagingDir, ec);
+        if (ec || !fs::is_directory(stagingDir, ec))
+        {
+            return {false, {}, ec ? ec.message() : "path exists and is not a directory"};
+        }
+
+        for (const auto &leftover : fs::directory_iterator{stagingDir, ec})
+        {
+            std::error_code removeEc;
+            fs::remove_all(leftover.path(), removeEc);
+        }
+        if (ec)
+        {
+            return {false, {}, ec.message()};
+        }
+
+        const fs::path canonical = fs::weakly_canonical(stagingDir, ec);
+        if (ec)
+        {
+            return {false, {}, ec.message()};
+        }
+        return {true, canonical, {}};
+    }
+
+    fs::path makeStagingPath(const fs::path &stagingDir)
+    {
+        // 24 random characters make a collision with another upload practically impossible.
+        return stagingDir / (Util::String::generateRandomString(24U) + ".part");
+    }
+
+    bool renameNoReplace(const fs::path &from, const fs::path &to, std::error_code &ec)
+    {
+        ec.clear();
+#ifdef _WIN32
+        // Without MOVEFILE_REPLACE_EXISTING the move fails when the target exists.
+        if (MoveFileExW(from.c_str(), to.c_str(), 0))
+        {
+            return true;
+        }
+        ec = std::error_code{static_cast<int>(GetLastError()), std::system_category()};
+        return false;
+#else
+#if defined(__linux__) && defined(RENAME_NOREPLACE)
+        if (::renameat2(AT_FDCWD, from.c_str(), AT_FDCWD, to.c_str(), RENAME_NOREPLACE) == 0)
+        {
+            return true;
+        }
+        if (errno != EINVAL && errno != ENOSYS)
+        {
+            ec = std::error_code{errno, std::generic_category()};
+            return false;
+        }
+#endif
+        // Filesystems without renameat2: link(2) refuses existing targets just as atomically.
+        if (::link(from.c_str(), to.c_str()) == 0)
+        {
+            ::unlink(from.c_str());
+            return true;
+        }
+        if (errno != EPERM && errno != ENOTSUP && errno != EOPNOTSUPP)
+        {
+            ec = std::error_code{errno, std::generic_category()};
+            return false;
+        }
+
+        // Last resort for filesystems without hard links; only this path can race.
+        if (fs::exists(to, ec) || ec)
+        {
+            if (!ec)
+            {
+                ec = std::make_error_code(std::errc::file_exists);
+            }
+            return false;
+        }
+        fs::rename(from, to, ec);
+        return !ec;
+#endif
+    }
+
+    bool cloneFile(const fs::path &from, const fs::path &to, std::error_code &ec)
+    {
+        ec.clear();
+#if defined(__linux__) && defined(FICLONE)
+        const int source = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+        if (source < 0)
+        {
+            ec = std::error_code{errno, std::generic_category()};
+            return false;
+        }
+        const int target = ::open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (target < 0)
+        {
+            ec = std::error_code{errno, std::generic_category()};
+            ::close(source);
+            return false;
+        }
+        if (::ioctl(target, FICLONE, source) != 0)
+        {
+            ec = std::error_code{errno, std::generic_category()};
+            ::unlink(to.c_str());
+        }
+        ::close(target);
+        ::close(source);
+        return !ec;
+#else
+        (void)from;
+        (void)to;
+        ec = std::make_error_code(std::errc::operation_not_supported);
+        return false;
+#endif
+    }
+
+    bool supportsCloning(const fs::path &dir)
+    {
+        const fs::path probe = dir / (".accio-clone-" + Util::String::generateRandomString(12));
+        fs::path clone = probe;
+        clone += ".clone";
+        std::error_code ec;
+        {
+            std::ofstream{probe, std::ios::binary} << 'x';
+        }
+        const bool cloned = cloneFile(probe, clone, ec);
+        fs::remove(clone, ec);
+        fs::remove(probe, ec);
+        return cloned;
+    }
+
+    std::tuple<bool, Fingerprint> fingerprintFile(const fs::path &path)
+    {
+#ifdef __linux__
+        struct stat info{};
+        if (::lstat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            return {false, {}};
+        }
+        Fingerprint result;
+        result.size = static_cast<std::uintmax_t>(info.st_size);
+        result.device = static_cast<std::uint64_t>(info.st_dev);
+        result.inode = static_cast<std::uint64_t>(info.st_ino);
+        result.mtimeNanoseconds = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+        result.ctimeNanoseconds = static_cast<std::int64_t>(info.st_ctim.tv_sec) * 1000000000LL + info.st_ctim.tv_nsec;
+        return {true, result};
+#else
+        (void)path;
+        return {false, {}};
+#endif
+    }
+
     std::string formatFileSize(std::uintmax_t bytes)
     {
         constexpr std::uintmax_t KB = 1024;
@@ -504,4 +663,64 @@ namespace Util::File
         }
         return false;
     }
+
+    std::int64_t toUnixNanoseconds(fs::file_time_type time)
+    {
+        const auto sinceEpoch = std::chrono::file_clock::to_sys(time).time_since_epoch();
+        return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count());
+    }
+
+    std::tuple<bool, EntryStat> statEntry(const fs::path &path)
+    {
+        EntryStat result;
+#ifdef _WIN32
+        std::error_code ec;
+        const fs::file_status status = fs::status(path, ec);
+        if (ec || !fs::exists(status))
+        {
+            return {false, {}};
+        }
+
+        result.isDirectory = fs::is_directory(status);
+        result.isRegularFile = fs::is_regular_file(status);
+        if (result.isRegularFile)
+        {
+            result.size = fs::file_size(path, ec);
+            if (ec)
+            {
+                return {false, {}};
+            }
+        }
+
+        const fs::file_time_type writeTime = fs::last_write_time(path, ec);
+        if (ec)
+        {
+            return {false, {}};
+        }
+
+        const std::int64_t nanoseconds = toUnixNanoseconds(writeTime);
+        result.mtimeSeconds = nanoseconds / 1000000000LL;
+        result.mtimeNanoseconds = nanoseconds % 1000000000LL;
+#else
+        struct stat info{};
+        if (::stat(path.c_str(), &info) != 0)
+        {
+            return {false, {}};
+        }
+
+        result.isDirectory = S_ISDIR(info.st_mode);
+        result.isRegularFile = S_ISREG(info.st_mode);
+        result.size = result.isRegularFile ? static_cast<std::uintmax_t>(info.st_size) : 0U;
+#ifdef __APPLE__
+        result.mtimeSeconds = static_cast<std::int64_t>(info.st_mtimespec.tv_sec);
+        result.mtimeNanoseconds = static_cast<std::int64_t>(info.st_mtimespec.tv_nsec);
+#else
+        result.mtimeSeconds = static_cast<std::int64_t>(info.st_mtim.tv_sec);
+        result.mtimeNanoseconds = static_cast<std::int64_t>(info.st_mtim.tv_nsec);
+#endif
+        result.device = static_cast<std::uint64_t>(info.st_dev);
+        result.inode = static_cast<std::uint64_t>(info.st_ino);
+#endif
+        return {true, result};
+    }
 } // namespace Util::File
@@ -11,6 +11,17 @@ namespace Util::File
 {
     namespace fs = std::filesystem;
 
+    struct EntryStat
+    {
+        bool isDirectory = false;
+        bool isRegularFile = false;
+        std::uintmax_t size = 0;
+        std::int64_t mtimeSeconds = 0;
+        std::int64_t mtimeNanoseconds = 0;
+        std::uint64_t device = 0;
+        std::uint64_t inode = 0;
+    };
+
     std::string normalizeRelativePath(const std::string &path);
 
     bool containsParentTraversal(const std::string &path);
@@ -19,8 +30,6 @@ namespace Util::File
 
     std::tuple<bool, std::string> sanitizeUploadFilename(const std::string &input);
 
-    std::tuple<bool, fs::path, std::string> chooseUploadDestination(const fs::path &uploadsDir, const std::string &sanitized);
-
     bool isWithinBase(const fs::path &candidate, const fs::path &base);
 
     std::string buildHrefForPath(const std::string &relativePath);
@@ -29,9 +38,51 @@ namespace Util::File
 
     fs::path getDefaultUploadsDirectory(const fs::path &baseDir);
 
+    // Where the session signing key is kept unless --session-key names a file: $XDG_STATE_HOME/accio or
+    // ~/.local/state/accio, and %LOCALAPPDATA%\accio on Windows. Empty when there is no home directory.
+    fs::path getDefaultSessionKeyPath();
+
     std::tuple<bool, fs::path, std::string> resolveUploadsDirectory(const fs::path &candidateInput);
 
+    // Uploads are written under a hidden directory inside the uploads directory and moved into place once
+    // complete. Whatever a previous run left there is removed, since no upload survives a restart.
+    std::tuple<bool, fs::path, std::string> prepareStagingDirectory(const fs::path &uploadsDir);
+
+    // A fresh, unused name for a file in the staging directory.
+    fs::path makeStagingPath(const fs::path &stagingDir);
+
+    // Moves `from` to `to` unless `to` exists; fails with std::errc::file_exists then, without a window
+    // in which another writer could slip in between the check and the move.
+    bool renameNoReplace(const fs::path &from, const fs::path &to, std::error_code &ec);
+
+    // Creates `to` as a reflink (FICLONE) of `from`: an independent file that shares the data blocks until
+    // either one is written. Fails with std::errc::operation_not_supported where the filesystem or the
+    // platform has no reflinks; there is deliberately no fallback that would make the two one inode.
+    bool cloneFile(const fs::path &from, const fs::path &to, std::error_code &ec);
+
+    // Whether cloneFile works in `dir`, tried on a scratch file there.
+    bool supportsCloning(const fs::path &dir);
+
+    // Size, identity and change times of a regular file, enough to tell that it was written, touched,
+    // chmodded or replaced since. Linux only; elsewhere it always fails.
+    struct Fingerprint
+    {
+        std::uintmax_t size = 0;
+        std::uint64_t device = 0;
+        std::uint64_t inode = 0;
+        std::int64_t mtimeNanoseconds = 0;
+        std::int64_t ctimeNanoseconds = 0;
+
+        bool operator==(const Fingerprint &) const = default;
+    };
+
+    std::tuple<bool, Fingerprint> fingerprintFile(const fs::path &path);
+
     std::string formatFileSize(std::uintmax_t bytes);
 
     bool hasAbsolutePaths(const std::vector<std::string> &items);
+
+    std::int64_t toUnixNanoseconds(fs::file_time_type time);
+
+    std::tuple<bool, EntryStat> statEntry(const fs::path &path);
 } // namespace Util::File
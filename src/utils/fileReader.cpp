@@ -0,0 +1,158 @@
+#include "./fileReader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+#include <system_error>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Util
+{
+    FileReader::~FileReader()
+    {
+        close();
+    }
+
+    bool FileReader::open(const std::filesystem::path &path)
+    {
+        close();
+
+#ifdef _WIN32
+        std::error_code ec;
+        const std::uintmax_t size = std::filesystem::file_size(path, ec);
+        if (ec)
+        {
+            return false;
+        }
+
+        fileStream.open(path, std::ios::binary);
+        if (!fileStream.is_open())
+        {
+            return false;
+        }
+
+        fileSize = size;
+        streamPosition = 0;
+#else
+        int flags = O_RDONLY;
+#ifdef O_CLOEXEC
+        flags |= O_CLOEXEC;
+#endif
+        fd = ::open(path.c_str(), flags);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            close();
+            return false;
+        }
+
+        fileSize = static_cast<std::uintmax_t>(info.st_size);
+#if defined(POSIX_FADV_SEQUENTIAL)
+        // Downloads are read front to back; let the kernel use a larger readahead window.
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#endif
+
+        return true;
+    }
+
+    void FileReader::close()
+    {
+#ifdef _WIN32
+        if (fileStream.is_open())
+        {
+            fileStream.close();
+        }
+#else
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+#endif
+        fileSize = 0;
+    }
+
+    bool FileReader::isOpen() const
+    {
+#ifdef _WIN32
+        return fileStream.is_open();
+#else
+        return fd >= 0;
+#endif
+    }
+
+    std::uintmax_t FileReader::size() const
+    {
+        return fileSize;
+    }
+
+    bool FileReader::stream(std::uintmax_t offset, std::uintmax_t length, const Writer &write)
+    {
+        if (!isOpen() || offset > fileSize || length > fileSize - offset)
+        {
+            return false;
+        }
+
+        if (!buffer)
+        {
+            buffer = std::make_unique<char[]>(blockSize);
+        }
+
+#ifdef _WIN32
+        if (streamPosition != offset)
+        {
+            fileStream.clear();
+            fileStream.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+            if (!fileStream.good())
+            {
+                return false;
+            }
+            streamPosition = offset;
+        }
+#endif
+
+        std::uintmax_t remaining = length;
+        while (remaining > 0)
+        {
+            const std::size_t toRead = static_cast<std::size_t>(std::min<std::uintmax_t>(remaining, blockSize));
+#ifdef _WIN32
+            fileStream.read(buffer.get(), static_cast<std::streamsize>(toRead));
+            const std::streamsize readBytes = fileStream.gcount();
+            if (readBytes <= 0)
+            {
+                return false;
+            }
+            streamPosition += static_cast<std::uintmax_t>(readBytes);
+#else
+            const ssize_t readBytes = ::pread(fd, buffer.get(), toRead, static_cast<off_t>(offset));
+            if (readBytes < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (readBytes <= 0)
+            {
+                return false;
+            }
+#endif
+
+            if (!write(buffer.get(), static_cast<std::size_t>(readBytes)))
+            {
+                return false;
+            }
+
+            offset += static_cast<std::uintmax_t>(readBytes);
+            remaining -= static_cast<std::uintmax_t>(readBytes);
+        }
+
+        return true;
+    }
+} // namespace Util
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+
+namespace Util
+{
+    class FileReader
+    {
+    public:
+        using Writer = std::function<bool(const char *data, std::size_t length)>;
+
+        FileReader() = default;
+        ~FileReader();
+        FileReader(const FileReader &) = delete;
+        FileReader &operator=(const FileReader &) = delete;
+
+        bool open(const std::filesystem::path &path);
+        void close();
+        bool isOpen() const;
+        std::uintmax_t size() const;
+
+        // Reads [offset, offset + length) and hands each block to `write`, reusing a single buffer
+        // for the lifetime of the reader. Returns false on short reads or when `write` refuses data.
+        bool stream(std::uintmax_t offset, std::uintmax_t length, const Writer &write);
+
+    private:
+        static constexpr std::size_t blockSize = 256U * 1024U;
+
+        std::uintmax_t fileSize = 0;
+        std::unique_ptr<char[]> buffer;
+#ifdef _WIN32
+        std::ifstream fileStream;
+        std::uintmax_t streamPosition = 0;
+#else
+        int fd = -1;
+#endif
+    };
+} // namespace Util
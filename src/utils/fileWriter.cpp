@@ -0,0 +1,264 @@
+#include "./fileWriter.hpp"
+#include <algorithm>
+#include <cstring>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Util
+{
+    FileWriter::~FileWriter()
+    {
+        close();
+    }
+
+    bool FileWriter::open(const std::filesystem::path &path, [[maybe_unused]] std::uintmax_t expectedSize, Mode writeMode)
+    {
+        close();
+        failed = false;
+        noSpace = false;
+        written = 0;
+        reserved = 0;
+        settled = 0;
+        mode = writeMode;
+        direct = false;
+
+#ifdef _WIN32
+        fileStream.open(path, std::ios::binary | std::ios::trunc);
+        if (!fileStream.is_open())
+        {
+            return false;
+        }
+#else
+        int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_CLOEXEC
+        flags |= O_CLOEXEC;
+#endif
+#ifdef O_DIRECT
+        if (mode == Mode::Direct)
+        {
+            fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+            direct = fd >= 0;
+        }
+#endif
+        // Filesystems such as tmpfs refuse O_DIRECT; the upload then goes through the page cache.
+        if (fd < 0)
+        {
+            fd = ::open(path.c_str(), flags, 0644);
+        }
+        if (fd < 0)
+        {
+            recordFailure(errno);
+            return false;
+        }
+
+#ifdef __linux__
+        // fallocate(2) rather than posix_fallocate(3): where the filesystem cannot reserve space, glibc's
+        // fallback writes every block once, which would double the I/O of the upload.
+        if (expectedSize > 0)
+        {
+            if (::fallocate(fd, 0, 0, static_cast<off_t>(expectedSize)) == 0)
+            {
+                reserved = expectedSize;
+            }
+            else if (errno == ENOSPC || errno == EDQUOT || errno == EFBIG)
+            {
+                recordFailure(errno);
+                close();
+                return false;
+            }
+        }
+#endif
+#endif
+
+        if (!buffer)
+        {
+            buffer.reset(static_cast<char *>(::operator new(blockSize, std::align_val_t{bufferAlignment})));
+        }
+        return true;
+    }
+
+    bool FileWriter::write(const char *data, std::size_t length)
+    {
+        if (!isOpen() || failed)
+        {
+            return false;
+        }
+
+        while (length > 0)
+        {
+            // A whole block arriving at once skips the copy, unless O_DIRECT needs it in the aligned buffer.
+            if (buffered == 0 && length >= blockSize && !direct)
+            {
+                const std::size_t toWrite = length - length % blockSize;
+                if (!writeOut(data, toWrite))
+                {
+                    return false;
+                }
+                data += toWrite;
+                length -= toWrite;
+                continue;
+            }
+
+            const std::size_t toCopy = std::min(length, blockSize - buffered);
+            std::memcpy(buffer.get() + buffered, data, toCopy);
+            buffered += toCopy;
+            data += toCopy;
+            length -= toCopy;
+            if (buffered == blockSize && !flush())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool FileWriter::close()
+    {
+        if (!isOpen())
+        {
+            return !failed;
+        }
+
+#if !defined(_WIN32) && defined(O_DIRECT)
+        // Only whole blocks satisfy O_DIRECT's alignment; the tail goes through the page cache.
+        if (direct && buffered % bufferAlignment != 0)
+        {
+            const int flags = ::fcntl(fd, F_GETFL);
+            if (flags == -1 || ::fcntl(fd, F_SETFL, flags & ~O_DIRECT) == -1)
+            {
+                recordFailure(errno);
+            }
+            direct = false;
+        }
+#endif
+        flush();
+
+#ifdef _WIN32
+        fileStream.close();
+        if (fileStream.fail())
+        {
+            failed = true;
+        }
+#else
+        if (!failed && reserved > written && ::ftruncate(fd, static_cast<off_t>(written)) != 0)
+        {
+            recordFailure(errno);
+        }
+        if (::close(fd) != 0)
+        {
+            recordFailure(errno);
+        }
+        fd = -1;
+#endif
+        buffered = 0;
+        return !failed;
+    }
+
+    bool FileWriter::isOpen() const
+    {
+#ifdef _WIN32
+        return fileStream.is_open();
+#else
+        return fd >= 0;
+#endif
+    }
+
+    std::uintmax_t FileWriter::size() const
+    {
+        return written + buffered;
+    }
+
+    std::uintmax_t FileWriter::reservedSize() const
+    {
+        return reserved;
+    }
+
+    bool FileWriter::outOfSpace() const
+    {
+        return noSpace;
+    }
+
+    bool FileWriter::flush()
+    {
+        if (buffered == 0)
+        {
+            return !failed;
+        }
+        const bool ok = writeOut(buffer.get(), buffered);
+        buffered = 0;
+        return ok;
+    }
+
+    bool FileWriter::writeOut(const char *data, std::size_t length)
+    {
+        if (failed)
+        {
+            return false;
+        }
+
+#ifdef _WIN32
+        fileStream.write(data, static_cast<std::streamsize>(length));
+        if (!fileStream)
+        {
+            failed = true;
+            return false;
+        }
+        written += length;
+#else
+        const std::uintmax_t start = written;
+        while (length > 0)
+        {
+            const ssize_t result = ::pwrite(fd, data, length, static_cast<off_t>(written));
+            if (result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (result <= 0)
+            {
+                recordFailure(result < 0 ? errno : ENOSPC);
+                return false;
+            }
+            data += result;
+            length -= static_cast<std::size_t>(result);
+            written += static_cast<std::uintmax_t>(result);
+        }
+        writeBehind(start);
+#endif
+        return true;
+    }
+
+    void FileWriter::recordFailure([[maybe_unused]] int error)
+    {
+        failed = true;
+#ifndef _WIN32
+        noSpace = error == ENOSPC || error == EDQUOT || error == EFBIG;
+#endif
+    }
+
+    void FileWriter::writeBehind([[maybe_unused]] std::uintmax_t start)
+    {
+#ifdef __linux__
+        if (mode != Mode::WriteBehind)
+        {
+            return;
+        }
+
+        // Queue what was just written, then wait for the window before it and drop those pages. The
+        // disk stays busy with one window while the next is filled, and dirty memory stays bounded.
+        ::sync_file_range(fd, static_cast<off_t>(start), static_cast<off_t>(written - start), SYNC_FILE_RANGE_WRITE);
+        if (written - settled >= 2 * writeBehindWindow)
+        {
+            const std::uintmax_t settleEnd = written - writeBehindWindow;
+            const auto offset = static_cast<off_t>(settled);
+            const auto length = static_cast<off_t>(settleEnd - settled);
+            ::sync_file_range(fd, offset, length, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            ::posix_fadvise(fd, offset, length, POSIX_FADV_DONTNEED);
+            settled = settleEnd;
+        }
+#endif
+    }
+} // namespace Util
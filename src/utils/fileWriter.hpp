@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <new>
+
+namespace Util
+{
+    // Collects small writes into one large aligned block and hands full blocks to the file descriptor in
+    // a single pwrite, so bodies delivered in small pieces do not cost a syscall each. A known final size is
+    // reserved up front so the file is laid out in few extents even while other uploads grow next to it.
+    class FileWriter
+    {
+    public:
+        // How written data leaves the page cache (Linux only; elsewhere every mode behaves like Cached).
+        enum class Mode
+        {
+            // Leave writeback to the kernel.
+            Cached,
+            // Start writeback as each block is written and drop pages once they reached the disk, so a
+            // large upload keeps only a few MiB of dirty pages.
+            WriteBehind,
+            // Bypass the page cache with O_DIRECT where the filesystem supports it.
+            Direct
+        };
+
+        FileWriter() = default;
+        ~FileWriter();
+        FileWriter(const FileWriter &) = delete;
+        FileWriter &operator=(const FileWriter &) = delete;
+
+        // Creates or truncates `path`. `expectedSize` (0 if unknown) is reserved before the first write;
+        // close() trims any reservation the data did not fill.
+        bool open(const std::filesystem::path &path, std::uintmax_t expectedSize = 0, Mode mode = Mode::Cached);
+        bool write(const char *data, std::size_t length);
+        // Writes out what is still buffered; false if this or any earlier write failed.
+        bool close();
+        bool isOpen() const;
+        std::uintmax_t size() const;
+        // Space set aside by open(), which the filesystem already counts as used.
+        std::uintmax_t reservedSize() const;
+        // Whether the last failure was the disk or a quota being full.
+        bool outOfSpace() const;
+
+    private:
+        static constexpr std::size_t blockSize = 1024U * 1024U;
+        static constexpr std::size_t bufferAlignment = 4096U;
+        // Write-behind keeps about this much data in flight before waiting for it and dropping its pages.
+        static constexpr std::uintmax_t writeBehindWindow = 8U * 1024U * 1024U;
+
+        struct BufferDelete
+        {
+            void operator()(char *buffer) const
+            {
+                ::operator delete(buffer, std::align_val_t{bufferAlignment});
+            }
+        };
+
+        bool flush();
+        bool writeOut(const char *data, std::size_t length);
+        void recordFailure(int error);
+        // `start` is where the data just written begins.
+        void writeBehind(std::uintmax_t start);
+
+        std::unique_ptr<char, BufferDelete> buffer;
+        std::size_t buffered = 0;
+        std::uintmax_t written = 0;
+        std::uintmax_t reserved = 0;
+        std::uintmax_t settled = 0;
+        Mode mode = Mode::Cached;
+        bool direct = false;
+        bool failed = false;
+        bool noSpace = false;
+#ifdef _WIN32
+        std::ofstream fileStream;
+#else
+        int fd = -1;
+#endif
+    };
+} // namespace Util
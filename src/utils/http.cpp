@@ -0,0 +1,320 @@
+#include "./http.hpp"
+#include <array>
+#include <cstdio>
+#include <cctype>
+
+namespace Util::Http
+{
+    namespace
+    {
+        constexpr std::array<const char *, 7> dayNames{"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        constexpr std::array<const char *, 12> monthNames{"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                                          "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+        // Howard Hinnant's days_from_civil / civil_from_days, valid for the proleptic Gregorian calendar.
+        std::int64_t daysFromCivil(std::int64_t year, unsigned month, unsigned day)
+        {
+            year -= month <= 2 ? 1 : 0;
+            const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+            const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+            const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+            return era * 146097 + static_cast<std::int64_t>(dayOfEra) - 719468;
+        }
+
+        void civilFromDays(std::int64_t days, std::int64_t &year, unsigned &month, unsigned &day)
+        {
+            days += 719468;
+            const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+            const unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+            const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+            const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+            const unsigned monthPrime = (5 * dayOfYear + 2) / 153;
+            day = dayOfYear - (153 * monthPrime + 2) / 5 + 1;
+            month = monthPrime < 10 ? monthPrime + 3 : monthPrime - 9;
+            year = static_cast<std::int64_t>(yearOfEra) + era * 400 + (month <= 2 ? 1 : 0);
+        }
+
+        class Cursor
+        {
+        public:
+            explicit Cursor(std::string_view text) : text(text)
+            {
+            }
+
+            void skipSpaces()
+            {
+                while (pos < text.size() && text[pos] == ' ')
+                {
+                    ++pos;
+                }
+            }
+
+            bool consume(char expected)
+            {
+                if (pos < text.size() && text[pos] == expected)
+                {
+                    ++pos;
+                    return true;
+                }
+                return false;
+            }
+
+            bool readNumber(std::size_t minDigits, std::size_t maxDigits, int &value)
+            {
+                std::size_t digits = 0;
+                value = 0;
+                while (pos < text.size() && digits < maxDigits && std::isdigit(static_cast<unsigned char>(text[pos])))
+                {
+                    value = value * 10 + (text[pos] - '0');
+                    ++pos;
+                    ++digits;
+                }
+                return digits >= minDigits;
+            }
+
+            bool readMonth(unsigned &month)
+            {
+                if (text.size() - pos < 3)
+                {
+                    return false;
+                }
+
+                const std::string_view token = text.substr(pos, 3);
+                for (std::size_t i = 0; i < monthNames.size(); ++i)
+                {
+                    if (token == monthNames[i])
+                    {
+                        month = static_cast<unsigned>(i + 1);
+                        pos += 3;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool readTime(int &hour, int &minute, int &second)
+            {
+                return readNumber(2, 2, hour) && consume(':') && readNumber(2, 2, minute) && consume(':') && readNumber(2, 2, second);
+            }
+
+            bool skipWord()
+            {
+                const std::size_t start = pos;
+                while (pos < text.size() && std::isalpha(static_cast<unsigned char>(text[pos])))
+                {
+                    ++pos;
+                }
+                return pos > start;
+            }
+
+            bool consumeWord(std::string_view word)
+            {
+                if (text.substr(pos, word.size()) == word)
+                {
+                    pos += word.size();
+                    return true;
+                }
+                return false;
+            }
+
+            bool atEnd()
+            {
+                skipSpaces();
+                return pos == text.size();
+            }
+
+        private:
+            std::string_view text;
+            std::size_t pos = 0;
+        };
+
+        std::string_view trim(std::string_view text)
+        {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+            {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+    } // namespace
+
+    std::string formatHttpDate(std::int64_t secondsSinceEpoch)
+    {
+        const std::int64_t days = secondsSinceEpoch >= 0 ? secondsSinceEpoch / 86400 : (secondsSinceEpoch - 86399) / 86400;
+        const std::int64_t secondsOfDay = secondsSinceEpoch - days * 86400;
+
+        std::int64_t year = 0;
+        unsigned month = 0;
+        unsigned day = 0;
+        civilFromDays(days, year, month, day);
+        const std::int64_t weekday = ((days % 7) + 11) % 7; // 1970-01-01 was a Thursday
+
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%s, %02u %s %04lld %02lld:%02lld:%02lld GMT",
+                      dayNames[static_cast<std::size_t>(weekday)],
+                      day,
+                      monthNames[month - 1],
+                      static_cast<long long>(year),
+                      static_cast<long long>(secondsOfDay / 3600),
+                      static_cast<long long>((secondsOfDay / 60) % 60),
+                      static_cast<long long>(secondsOfDay % 60));
+        return buffer;
+    }
+
+    std::tuple<bool, std::int64_t> parseHttpDate(std::string_view text)
+    {
+        // Accepts the three formats RFC 9110 requires recipients to understand:
+        // IMF-fixdate, obsolete RFC 850 dates and asctime().
+        int day = 0;
+        unsigned month = 0;
+        int year = 0;
+        int hour = 0;
+        int minute = 0;
+        int second = 0;
+
+        Cursor cursor{text};
+        cursor.skipSpaces();
+        if (!cursor.skipWord())
+        {
+            return {false, 0};
+        }
+
+        if (cursor.consume(','))
+        {
+            cursor.skipSpaces();
+            if (!cursor.readNumber(2, 2, day))
+            {
+                return {false, 0};
+            }
+
+            if (cursor.consume('-'))
+            {
+                if (!cursor.readMonth(month) || !cursor.consume('-') || !cursor.readNumber(2, 2, year))
+                {
+                    return {false, 0};
+                }
+                year += year < 70 ? 2000 : 1900;
+            }
+            else
+            {
+                if (!cursor.consume(' ') || !cursor.readMonth(month) || !cursor.consume(' ') || !cursor.readNumber(4, 4, year))
+                {
+                    return {false, 0};
+                }
+            }
+
+            if (!cursor.consume(' ') || !cursor.readTime(hour, minute, second) || !cursor.consume(' ') || !cursor.consumeWord("GMT"))
+            {
+                return {false, 0};
+            }
+        }
+        else
+        {
+            cursor.skipSpaces();
+            if (!cursor.readMonth(month))
+            {
+                return {false, 0};
+            }
+            cursor.skipSpaces();
+            if (!cursor.readNumber(1, 2, day) || !cursor.consume(' ') || !cursor.readTime(hour, minute, second)
+                || !cursor.consume(' ') || !cursor.readNumber(4, 4, year))
+            {
+                return {false, 0};
+            }
+        }
+
+        if (!cursor.atEnd() || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+        {
+            return {false, 0};
+        }
+
+        const std::int64_t days = daysFromCivil(year, month, static_cast<unsigned>(day));
+        return {true, days * 86400 + hour * 3600 + minute * 60 + second};
+    }
+
+    std::string buildEntityTag(const Util::File::EntryStat &stat, bool weak, std::uint64_t generation)
+    {
+        char buffer[128];
+        const unsigned long long mtime = static_cast<unsigned long long>(stat.mtimeSeconds * 1000000000LL + stat.mtimeNanoseconds);
+        if (generation != 0)
+        {
+            std::snprintf(buffer, sizeof(buffer), "%s\"%llx-%llx-%llx-%llx\"",
+                          weak ? "W/" : "",
+                          static_cast<unsigned long long>(stat.inode),
+                          static_cast<unsigned long long>(stat.size),
+                          mtime,
+                          static_cast<unsigned long long>(generation));
+        }
+        else
+        {
+            std::snprintf(buffer, sizeof(buffer), "%s\"%llx-%llx-%llx\"",
+                          weak ? "W/" : "",
+                          static_cast<unsigned long long>(stat.inode),
+                          static_cast<unsigned long long>(stat.size),
+                          mtime);
+        }
+        return buffer;
+    }
+
+    bool isNotModified(std::string_view ifNoneMatch, std::string_view ifModifiedSince, std::string_view entityTag, std::int64_t lastModified)
+    {
+        // If-None-Match takes precedence; when present If-Modified-Since is ignored (RFC 9110 13.2.2).
+        if (!ifNoneMatch.empty())
+        {
+            const std::string_view opaqueTag = entityTag.starts_with("W/") ? entityTag.substr(2) : entityTag;
+            while (!ifNoneMatch.empty())
+            {
+                const std::size_t comma = ifNoneMatch.find(',');
+                std::string_view candidate = ifNoneMatch.substr(0, comma);
+                ifNoneMatch = comma == std::string_view::npos ? std::string_view{} : ifNoneMatch.substr(comma + 1);
+
+                candidate = trim(candidate);
+                if (candidate == "*")
+                {
+                    return true;
+                }
+                if (candidate.starts_with("W/"))
+                {
+                    candidate.remove_prefix(2);
+                }
+                if (candidate == opaqueTag)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        if (!ifModifiedSince.empty())
+        {
+            const auto [dateOk, date] = parseHttpDate(ifModifiedSince);
+            return dateOk && lastModified <= date;
+        }
+
+        return false;
+    }
+
+    bool isIfRangeSatisfied(std::string_view ifRange, std::string_view entityTag, std::int64_t lastModified)
+    {
+        ifRange = trim(ifRange);
+
+        // If-Range requires a strong comparison, so weak validators never match.
+        if (ifRange.starts_with("W/"))
+        {
+            return false;
+        }
+
+        if (ifRange.starts_with("\""))
+        {
+            return !entityTag.starts_with("W/") && ifRange == entityTag;
+        }
+
+        const auto [dateOk, date] = parseHttpDate(ifRange);
+        return dateOk && date == lastModified;
+    }
+} // namespace Util::Http
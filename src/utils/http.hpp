@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <cstdint>
+#include "./file.hpp"
+
+namespace Util::Http
+{
+    std::string formatHttpDate(std::int64_t secondsSinceEpoch);
+
+    std::tuple<bool, std::int64_t> parseHttpDate(std::string_view text);
+
+    std::string buildEntityTag(const Util::File::EntryStat &stat, bool weak, std::uint64_t generation = 0);
+
+    bool isNotModified(std::string_view ifNoneMatch, std::string_view ifModifiedSince, std::string_view entityTag, std::int64_t lastModified);
+
+    bool isIfRangeSatisfied(std::string_view ifRange, std::string_view entityTag, std::int64_t lastModified);
+} // namespace Util::Http
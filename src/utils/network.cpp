@@ -177,4 +177,22 @@ namespace Util::Network
                         addresses.end());
         return addresses;
     }
+
+    std::optional<Address> parseAddress(std::string_view text)
+    {
+        // inet_pton wants a terminated string and rejects the zone suffix of a link-local address.
+        const std::string host{text.substr(0, text.find('%'))};
+        Address address{};
+        if (inet_pton(AF_INET, host.c_str(), address.data() + 12) == 1)
+        {
+            address[10] = 0xFF;
+            address[11] = 0xFF;
+            return address;
+        }
+        if (inet_pton(AF_INET6, host.c_str(), address.data()) == 1)
+        {
+            return address;
+        }
+        return std::nullopt;
+    }
 } // namespace Util::Network
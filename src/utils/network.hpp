@@ -1,10 +1,20 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 namespace Util::Network
 {
+    // An IPv6 address, or an IPv4 address in its IPv4-mapped IPv6 form (::ffff:a.b.c.d).
+    using Address = std::array<std::uint8_t, 16>;
+
     std::vector<std::pair<std::string, int>> collectNetworkAddresses();
+    // Parses a numeric IPv4 or IPv6 address such as a request's remote address. A zone suffix ("%eth0") is
+    // ignored; anything else that is not an address gives nullopt.
+    std::optional<Address> parseAddress(std::string_view text);
 } // namespace Util::Network
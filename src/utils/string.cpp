@@ -2,9 +2,30 @@
 #include <algorithm>
 #include <random>
 #include <cctype>
+#include <cstdint>
 
 namespace Util::String
 {
+    namespace
+    {
+        unsigned char foldAscii(char ch)
+        {
+            const auto byte = static_cast<unsigned char>(ch);
+            return byte >= 'A' && byte <= 'Z' ? static_cast<unsigned char>(byte + ('a' - 'A')) : byte;
+        }
+
+        bool isDigit(char ch)
+        {
+            return ch >= '0' && ch <= '9';
+        }
+
+        int compareBytes(std::string_view lhs, std::string_view rhs)
+        {
+            const int result = lhs.compare(rhs);
+            return result < 0 ? -1 : (result > 0 ? 1 : 0);
+        }
+    } // namespace
+
     std::string toLowerCopy(std::string_view text)
     {
         std::string lower{text.begin(), text.end()};
@@ -31,4 +52,239 @@ namespace Util::String
         }
         return result;
     }
+
+    std::string escapeForJson(std::string_view text)
+    {
+        std::string escaped;
+        escaped.reserve(text.size() + 2);
+        constexpr char hexDigits[] = "0123456789abcdef";
+        for (char ch : text)
+        {
+            switch (ch)
+            {
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            case '\r':
+                escaped += "\\r";
+                break;
+            case '\t':
+                escaped += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20)
+                {
+                    escaped += "\\u00";
+                    escaped.push_back(hexDigits[(ch >> 4) & 0x0F]);
+                    escaped.push_back(hexDigits[ch & 0x0F]);
+                }
+                else
+                {
+                    escaped.push_back(ch);
+                }
+                break;
+            }
+        }
+        return escaped;
+    }
+
+    std::string encodeBase64(std::string_view bytes)
+    {
+        constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string encoded;
+        encoded.reserve((bytes.size() + 2) / 3 * 4);
+        for (std::size_t i = 0; i < bytes.size(); i += 3)
+        {
+            const std::size_t count = std::min<std::size_t>(3, bytes.size() - i);
+            std::uint32_t group = 0;
+            for (std::size_t j = 0; j < 3; ++j)
+            {
+                group = (group << 8) | (j < count ? static_cast<unsigned char>(bytes[i + j]) : 0U);
+            }
+            for (std::size_t j = 0; j < 4; ++j)
+            {
+                encoded.push_back(j <= count ? alphabet[(group >> (18 - 6 * j)) & 0x3FU] : '=');
+            }
+        }
+        return encoded;
+    }
+
+    bool decodeBase64(std::string_view text, std::string &bytes)
+    {
+        bytes.clear();
+        if (text.size() % 4 != 0)
+        {
+            return false;
+        }
+        std::size_t padding = 0;
+        while (padding < 2 && padding < text.size() && text[text.size() - 1 - padding] == '=')
+        {
+            ++padding;
+        }
+
+        std::uint32_t group = 0;
+        for (std::size_t i = 0; i < text.size() - padding; ++i)
+        {
+            const char ch = text[i];
+            int value = -1;
+            if (ch >= 'A' && ch <= 'Z')
+            {
+                value = ch - 'A';
+            }
+            else if (ch >= 'a' && ch <= 'z')
+            {
+                value = ch - 'a' + 26;
+            }
+            else if (ch >= '0' && ch <= '9')
+            {
+                value = ch - '0' + 52;
+            }
+            else if (ch == '+')
+            {
+                value = 62;
+            }
+            else if (ch == '/')
+            {
+                value = 63;
+            }
+            if (value < 0)
+            {
+                return false;
+            }
+            group = (group << 6) | static_cast<std::uint32_t>(value);
+            if (i % 4 == 3)
+            {
+                bytes.push_back(static_cast<char>(group >> 16));
+                bytes.push_back(static_cast<char>(group >> 8));
+                bytes.push_back(static_cast<char>(group));
+                group = 0;
+            }
+        }
+
+        // The last group holds one byte with two padding characters and two bytes with one.
+        if (padding == 2)
+        {
+            bytes.push_back(static_cast<char>(group >> 4));
+            return (group & 0xFU) == 0;
+        }
+        if (padding == 1)
+        {
+            bytes.push_back(static_cast<char>(group >> 10));
+            bytes.push_back(static_cast<char>(group >> 2));
+            return (group & 0x3U) == 0;
+        }
+        return true;
+    }
+
+    std::string encodeHex(std::string_view bytes)
+    {
+        constexpr char hexDigits[] = "0123456789abcdef";
+        std::string encoded;
+        encoded.reserve(bytes.size() * 2);
+        for (const char ch : bytes)
+        {
+            encoded.push_back(hexDigits[(static_cast<unsigned char>(ch) >> 4) & 0x0FU]);
+            encoded.push_back(hexDigits[static_cast<unsigned char>(ch) & 0x0FU]);
+        }
+        return encoded;
+    }
+
+    int compareCaseInsensitive(std::string_view lhs, std::string_view rhs)
+    {
+        const std::size_t common = std::min(lhs.size(), rhs.size());
+        for (std::size_t i = 0; i < common; ++i)
+        {
+            const unsigned char left = foldAscii(lhs[i]);
+            const unsigned char right = foldAscii(rhs[i]);
+            if (left != right)
+            {
+                return left < right ? -1 : 1;
+            }
+        }
+        if (lhs.size() != rhs.size())
+        {
+            return lhs.size() < rhs.size() ? -1 : 1;
+        }
+        return compareBytes(lhs, rhs);
+    }
+
+    int compareNatural(std::string_view lhs, std::string_view rhs)
+    {
+        std::size_t i = 0;
+        std::size_t j = 0;
+        // Among names with equal numbers, fewer leading zeros sorts first ("1" < "01").
+        int zeroTieBreak = 0;
+        while (i < lhs.size() && j < rhs.size())
+        {
+            if (isDigit(lhs[i]) && isDigit(rhs[j]))
+            {
+                const std::size_t leftZerosBegin = i;
+                const std::size_t rightZerosBegin = j;
+                while (i < lhs.size() && lhs[i] == '0')
+                {
+                    ++i;
+                }
+                while (j < rhs.size() && rhs[j] == '0')
+                {
+                    ++j;
+                }
+
+                const std::size_t leftDigitsBegin = i;
+                const std::size_t rightDigitsBegin = j;
+                while (i < lhs.size() && isDigit(lhs[i]))
+                {
+                    ++i;
+                }
+                while (j < rhs.size() && isDigit(rhs[j]))
+                {
+                    ++j;
+                }
+
+                // Without leading zeros, a longer run of digits is a larger number.
+                const std::size_t leftLength = i - leftDigitsBegin;
+                const std::size_t rightLength = j - rightDigitsBegin;
+                if (leftLength != rightLength)
+                {
+                    return leftLength < rightLength ? -1 : 1;
+                }
+                if (const int digits = lhs.substr(leftDigitsBegin, leftLength).compare(rhs.substr(rightDigitsBegin, rightLength)); digits != 0)
+                {
+                    return digits < 0 ? -1 : 1;
+                }
+
+                const std::size_t leftZeros = leftDigitsBegin - leftZerosBegin;
+                const std::size_t rightZeros = rightDigitsBegin - rightZerosBegin;
+                if (zeroTieBreak == 0 && leftZeros != rightZeros)
+                {
+                    zeroTieBreak = leftZeros < rightZeros ? -1 : 1;
+                }
+                continue;
+            }
+
+            const unsigned char left = foldAscii(lhs[i]);
+            const unsigned char right = foldAscii(rhs[j]);
+            if (left != right)
+            {
+                return left < right ? -1 : 1;
+            }
+            ++i;
+            ++j;
+        }
+
+        if (i < lhs.size() || j < rhs.size())
+        {
+            return i < lhs.size() ? 1 : -1;
+        }
+        if (zeroTieBreak != 0)
+        {
+            return zeroTieBreak;
+        }
+        return compareBytes(lhs, rhs);
+    }
 } // namespace Util::String
@@ -8,4 +8,17 @@ namespace Util::String
 {
     std::string toLowerCopy(std::string_view text);
     std::string generateRandomString(std::size_t length);
+    std::string escapeForJson(std::string_view text);
+
+    // Standard base64 with padding, as HTTP digest headers use it.
+    std::string encodeBase64(std::string_view bytes);
+    bool decodeBase64(std::string_view text, std::string &bytes);
+    std::string encodeHex(std::string_view bytes);
+
+    // Three-way comparisons for sorting names without allocating. ASCII letters are folded; other bytes,
+    // including UTF-8 sequences, compare by value, which keeps code point order. Names equal apart from
+    // case are ordered bytewise so the order stays total.
+    int compareCaseInsensitive(std::string_view lhs, std::string_view rhs);
+    // Like compareCaseInsensitive, but runs of digits compare by numeric value ("file2" < "file10").
+    int compareNatural(std::string_view lhs, std::string_view rhs);
 } // namespace Util::String
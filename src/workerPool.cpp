@@ -0,0 +1,144 @@
+#include "./workerPool.hpp"
+#include <algorithm>
+
+namespace
+{
+    // The connection the calling worker is serving.
+    struct Connection
+    {
+        const WorkerPool *pool = nullptr;
+        bool counted = false;
+        Util::Network::Address address{};
+    };
+
+    thread_local Connection currentConnection;
+
+    unsigned resolveWorkers(unsigned workers)
+    {
+        if (workers > 0)
+        {
+            return workers;
+        }
+        const unsigned hardwareThreads = std::thread::hardware_concurrency();
+        return std::max(8U, hardwareThreads > 0 ? hardwareThreads - 1 : 0U);
+    }
+} // namespace
+
+WorkerPool::WorkerPool(Limits limits)
+    : limits{resolveWorkers(limits.workers), limits.queueDepth, limits.connectionsPerAddress}
+{
+    threads.reserve(this->limits.workers);
+    for (unsigned i = 0; i < this->limits.workers; ++i)
+    {
+        threads.emplace_back([this] { run(); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    shutdown();
+}
+
+bool WorkerPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (stopping)
+        {
+            return false;
+        }
+        if (limits.queueDepth > 0 && tasks.size() >= limits.queueDepth)
+        {
+            ++rejectedQueueFull;
+            return false;
+        }
+        tasks.push_back(std::move(task));
+    }
+    taskAdded.notify_one();
+    return true;
+}
+
+void WorkerPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (stopping)
+        {
+            return;
+        }
+        stopping = true;
+    }
+    taskAdded.notify_all();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+bool WorkerPool::admitConnection(std::string_view remoteAddress)
+{
+    Connection &connection = currentConnection;
+    if (limits.connectionsPerAddress == 0 || connection.pool != this || connection.counted)
+    {
+        return true;
+    }
+    const auto address = Util::Network::parseAddress(remoteAddress);
+    if (!address)
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex);
+    unsigned &count = connections[*address];
+    if (count >= limits.connectionsPerAddress)
+    {
+        ++rejectedPerAddress;
+        return false;
+    }
+    ++count;
+    connection.counted = true;
+    connection.address = *address;
+    return true;
+}
+
+WorkerPool::Stats WorkerPool::stats() const
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    return Stats{limits.workers, busy, tasks.size(), served, rejectedQueueFull, rejectedPerAddress};
+}
+
+void WorkerPool::run()
+{
+    Connection &connection = currentConnection;
+    connection.pool = this;
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAdded.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+            {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            ++busy;
+        }
+
+        connection.counted = false;
+        task();
+
+        std::lock_guard<std::mutex> guard(mutex);
+        if (connection.counted)
+        {
+            auto it = connections.find(connection.address);
+            if (it != connections.end() && --it->second == 0)
+            {
+                connections.erase(it);
+            }
+        }
+        --busy;
+        ++served;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "utils/network.hpp"
+
+// The threads that serve HTTP connections. The server hands over each accepted connection as one task,
+// which occupies a worker until the client goes away, so the worker count bounds how many clients are served
+// at once and the queue bounds how many more may wait for a worker; further connections are closed as they
+// arrive. A per-address cap keeps a single client from taking every worker with parallel or slow downloads.
+// It counts a connection only once its first request has been read and reaches the pre-routing handler, so
+// connections still queued, or idle on a worker before sending anything, are bounded by the queue and the
+// read timeout rather than by the cap.
+class WorkerPool
+{
+public:
+    struct Limits
+    {
+        // 0 picks the server library's default, max(8, hardware threads - 1).
+        unsigned workers;
+        // Connections waiting for a worker; 0 leaves the queue unbounded.
+        std::size_t queueDepth;
+        // Connections one client address may hold at once; 0 leaves them unlimited.
+        unsigned connectionsPerAddress;
+    };
+
+    struct Stats
+    {
+        unsigned workers;
+        unsigned busy;
+        std::size_t queued;
+        std::uint64_t served;
+        std::uint64_t rejectedQueueFull;
+        std::uint64_t rejectedPerAddress;
+    };
+
+    explicit WorkerPool(Limits limits);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // False when the queue is full or the pool has shut down; the caller then closes the connection.
+    bool enqueue(std::function<void()> task);
+    // Serves what is already queued, then stops the threads.
+    void shutdown();
+
+    // Called for each request from the worker serving it. The first request of a connection counts the
+    // connection against `remoteAddress`; false means the address already holds its share and the
+    // connection should be answered and closed.
+    bool admitConnection(std::string_view remoteAddress);
+    Stats stats() const;
+
+private:
+    void run();
+
+    const Limits limits;
+    mutable std::mutex mutex;
+    std::condition_variable taskAdded;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+    unsigned busy = 0;
+    std::uint64_t served = 0;
+    std::uint64_t rejectedQueueFull = 0;
+    std::uint64_t rejectedPerAddress = 0;
+    std::map<Util::Network::Address, unsigned> connections;
+};
@@ -0,0 +1,114 @@
+// Cost of one access check with many --deny-files directories. The linear variant is what the server did
+// before AccessRules: an exact lookup, then Util::File::isWithinBase (one fs::relative call) against every
+// denied directory. The trie variant is AccessRules::isAccessible on the same canonical paths.
+//
+// Usage: accessRulesBenchmark [denied directories, default 300]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "accessRules.hpp"
+#include "utils/file.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr int rounds = 5;
+
+    bool isDeniedLinear(const fs::path &canonicalPath, const std::unordered_set<std::string> &deniedFiles, const std::vector<fs::path> &deniedDirs)
+    {
+        if (deniedFiles.count(canonicalPath.string()))
+        {
+            return true;
+        }
+        for (const auto &dir : deniedDirs)
+        {
+            if (Util::File::isWithinBase(canonicalPath, dir))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    double bestNanosecondsPerCheck(const std::vector<fs::path> &paths, std::size_t repeats, const std::function<bool(const fs::path &)> &check)
+    {
+        double best = 1e18;
+        std::size_t accessible = 0;
+        for (int round = 0; round < rounds; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < repeats; ++i)
+            {
+                for (const fs::path &path : paths)
+                {
+                    accessible += check(path) ? 1U : 0U;
+                }
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = std::min(best, seconds * 1e9 / static_cast<double>(repeats * paths.size()));
+        }
+        if (accessible == 0)
+        {
+            std::fprintf(stderr, "every path was denied\n");
+        }
+        return best;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const std::size_t deniedCount = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 300U;
+    if (deniedCount == 0)
+    {
+        std::fprintf(stderr, "usage: %s [denied directories]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    fs::path base = fs::temp_directory_path() / ("accio-rules-" + Util::String::generateRandomString(12));
+    std::vector<std::string> deniedFiles;
+    for (std::size_t i = 0; i < deniedCount; ++i)
+    {
+        const std::string relative = "denied/d" + std::to_string(i);
+        fs::create_directories(base / relative);
+        deniedFiles.push_back(relative);
+    }
+    fs::create_directories(base / "public" / "photos" / "2024");
+    base = fs::canonical(base);
+
+    std::unordered_set<std::string> linearFiles;
+    std::vector<fs::path> linearDirs;
+    for (const std::string &relative : deniedFiles)
+    {
+        linearDirs.push_back(base / relative);
+    }
+
+    const AccessRules rules{base, {}, {}, {}, deniedFiles};
+
+    // Mostly accessible paths, which are the slow case for a linear scan: every rule is tried.
+    const std::vector<fs::path> paths{base / "public" / "photos" / "2024" / "img_0001.jpg", base / "public" / "readme.txt",
+                                      base / "public" / "photos", base / "denied" / "d7" / "secret.txt"};
+
+    const double linear = bestNanosecondsPerCheck(paths, 2, [&](const fs::path &path) {
+        return !isDeniedLinear(path, linearFiles, linearDirs);
+    });
+    const double trie = bestNanosecondsPerCheck(paths, 20000, [&](const fs::path &path) {
+        return rules.isAccessible(path, false);
+    });
+
+    std::error_code ec;
+    fs::remove_all(base, ec);
+
+    std::printf("%zu denied directories, best of %d rounds\n\n", deniedCount, rounds);
+    std::printf("%-28s %14s\n", "rules", "ns/check");
+    std::printf("%-28s %14.0f\n", "linear isWithinBase scan", linear);
+    std::printf("%-28s %14.0f\n", "AccessRules trie", trie);
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "accessRules.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Literal rules are resolved against the filesystem, so each case gets a small tree to point them at:
+    //   docs/readme.md  docs/notes.txt  private/key.pem  private/sub/data.bin  build/app.log  top.TXT
+    struct Tree
+    {
+        fs::path base;
+
+        Tree()
+        {
+            base = fs::temp_directory_path() / ("accio-access-" + Util::String::generateRandomString(12));
+            for (const char *directory : {"docs", "private/sub", "build"})
+            {
+                fs::create_directories(base / directory);
+            }
+            for (const char *file : {"docs/readme.md", "docs/notes.txt", "private/key.pem", "private/sub/data.bin", "build/app.log", "top.TXT"})
+            {
+                std::ofstream{base / file};
+            }
+            base = fs::canonical(base);
+        }
+
+        ~Tree()
+        {
+            std::error_code ec;
+            fs::remove_all(base, ec);
+        }
+
+        AccessRules rules(const std::vector<std::string> &allowedExtensions, const std::vector<std::string> &deniedExtensions,
+                          const std::vector<std::string> &allowedFiles, const std::vector<std::string> &deniedFiles) const
+        {
+            return AccessRules{base, allowedExtensions, deniedExtensions, allowedFiles, deniedFiles};
+        }
+
+        bool file(const AccessRules &rules, const char *relative) const
+        {
+            return rules.isAccessible(base / relative, false);
+        }
+
+        bool directory(const AccessRules &rules, const char *relative) const
+        {
+            return rules.isAccessible(base / relative, true);
+        }
+    };
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(accessRules, Tree)
+
+BOOST_AUTO_TEST_CASE(everythingIsAccessibleWithoutRules)
+{
+    const AccessRules open = rules({}, {}, {}, {});
+    BOOST_TEST(file(open, "private/key.pem"));
+    BOOST_TEST(directory(open, "private"));
+}
+
+BOOST_AUTO_TEST_CASE(deniedDirectoriesCoverTheirSubtree)
+{
+    const AccessRules denied = rules({}, {}, {}, {"private"});
+    BOOST_TEST(!directory(denied, "private"));
+    BOOST_TEST(!file(denied, "private/key.pem"));
+    BOOST_TEST(!file(denied, "private/sub/data.bin"));
+    BOOST_TEST(file(denied, "docs/readme.md"));
+}
+
+BOOST_AUTO_TEST_CASE(deniedFilesAreExact)
+{
+    const AccessRules denied = rules({}, {}, {}, {"docs/notes.txt"});
+    BOOST_TEST(!file(denied, "docs/notes.txt"));
+    BOOST_TEST(file(denied, "docs/readme.md"));
+    BOOST_TEST(directory(denied, "docs"));
+}
+
+BOOST_AUTO_TEST_CASE(extensionsIgnoreCaseAndTheDot)
+{
+    const AccessRules allowed = rules({"txt"}, {}, {}, {});
+    BOOST_TEST(file(allowed, "top.TXT"));
+    BOOST_TEST(file(allowed, "docs/notes.txt"));
+    BOOST_TEST(!file(allowed, "docs/readme.md"));
+    BOOST_TEST(directory(allowed, "private"));
+
+    const AccessRules denied = rules({}, {".LOG"}, {}, {});
+    BOOST_TEST(!file(denied, "build/app.log"));
+    BOOST_TEST(file(denied, "docs/readme.md"));
+}
+
+BOOST_AUTO_TEST_CASE(allowedFilesKeepTheirAncestorsListable)
+{
+    const AccessRules allowed = rules({}, {}, {"docs/readme.md", "private/sub"}, {});
+    BOOST_TEST(file(allowed, "docs/readme.md"));
+    BOOST_TEST(!file(allowed, "docs/notes.txt"));
+    BOOST_TEST(directory(allowed, "docs"));
+    BOOST_TEST(directory(allowed, "private"));
+    BOOST_TEST(!file(allowed, "private/key.pem"));
+    BOOST_TEST(file(allowed, "private/sub/data.bin"));
+    BOOST_TEST(!directory(allowed, "build"));
+}
+
+BOOST_AUTO_TEST_CASE(denyWinsOverAllow)
+{
+    const AccessRules rulesWithBoth = rules({}, {}, {"private"}, {"private/sub"});
+    BOOST_TEST(file(rulesWithBoth, "private/key.pem"));
+    BOOST_TEST(!file(rulesWithBoth, "private/sub/data.bin"));
+}
+
+BOOST_AUTO_TEST_CASE(patternsApplyRelativeToTheBase)
+{
+    const AccessRules denied = rules({}, {}, {}, {"*.pem", "build/"});
+    BOOST_TEST(!file(denied, "private/key.pem"));
+    BOOST_TEST(!directory(denied, "build"));
+    BOOST_TEST(!file(denied, "build/app.log"));
+    BOOST_TEST(file(denied, "docs/readme.md"));
+
+    const AccessRules allowed = rules({}, {}, {"docs/*.md"}, {});
+    BOOST_TEST(file(allowed, "docs/readme.md"));
+    BOOST_TEST(!file(allowed, "docs/notes.txt"));
+    BOOST_TEST(directory(allowed, "docs"));
+    BOOST_TEST(!directory(allowed, "private"));
+}
+
+BOOST_AUTO_TEST_CASE(hiddenPathsAreDeniedRegardlessOfRules)
+{
+    AccessRules allowed = rules({}, {}, {"private"}, {});
+    allowed.hidePath(base / "private" / "sub");
+    BOOST_TEST(file(allowed, "private/key.pem"));
+    BOOST_TEST(!directory(allowed, "private/sub"));
+    BOOST_TEST(!file(allowed, "private/sub/data.bin"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+// Throughput of the upload checksum next to the copy every upload already makes. Util::Checksum::Crc32c
+// uses the CPU's CRC instructions where it has them; the bytewise table CRC is the textbook loop for
+// comparison, and memcpy stands for the copy into the writer's block.
+//
+// Usage: checksumBenchmark [buffer size in MiB, default 64]
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include "utils/checksum.hpp"
+
+namespace
+{
+    constexpr int rounds = 5;
+
+    std::uint32_t crc32cBytewise(const char *data, std::size_t length)
+    {
+        static const std::array<std::uint32_t, 256> table = [] {
+            std::array<std::uint32_t, 256> entries{};
+            for (std::uint32_t byte = 0; byte < 256; ++byte)
+            {
+                std::uint32_t crc = byte;
+                for (int bit = 0; bit < 8; ++bit)
+                {
+                    crc = (crc & 1U) != 0 ? (crc >> 1) ^ 0x82F63B78U : crc >> 1;
+                }
+                entries[byte] = crc;
+            }
+            return entries;
+        }();
+
+        std::uint32_t crc = 0xFFFFFFFFU;
+        for (std::size_t i = 0; i < length; ++i)
+        {
+            crc = (crc >> 8) ^ table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFFU];
+        }
+        return ~crc;
+    }
+
+    double bestGigabytesPerSecond(std::size_t size, const std::function<void()> &run)
+    {
+        double best = 1e18;
+        for (int round = 0; round < rounds; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return static_cast<double>(size) / best / 1e9;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const std::size_t sizeMiB = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 64U;
+    const std::size_t size = sizeMiB * 1024U * 1024U;
+    if (size == 0)
+    {
+        std::fprintf(stderr, "usage: %s [buffer size in MiB]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<char> data(size);
+    std::vector<char> copy(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<char>((i * 131U) ^ (i >> 13));
+    }
+
+    std::uint32_t library = 0;
+    std::uint32_t bytewise = 0;
+    const double libraryRate = bestGigabytesPerSecond(size, [&] {
+        Util::Checksum::Crc32c crc;
+        crc.update(data.data(), data.size());
+        library = crc.value();
+    });
+    const double bytewiseRate = bestGigabytesPerSecond(size, [&] { bytewise = crc32cBytewise(data.data(), data.size()); });
+    const double copyRate = bestGigabytesPerSecond(size, [&] { std::memcpy(copy.data(), data.data(), size); });
+
+    if (library != bytewise)
+    {
+        std::fprintf(stderr, "CRCs differ: %08x and %08x\n", library, bytewise);
+        return EXIT_FAILURE;
+    }
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    const char *hardware = __builtin_cpu_supports("sse4.2") ? "SSE4.2" : "none";
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    const char *hardware = "ARMv8 CRC";
+#else
+    const char *hardware = "none";
+#endif
+
+    std::printf("%zu MiB in memory, best of %d rounds, CRC instructions: %s\n\n", sizeMiB, rounds, hardware);
+    std::printf("%-28s %8s\n", "pass", "GB/s");
+    std::printf("%-28s %8.2f\n", "Checksum::Crc32c", libraryRate);
+    std::printf("%-28s %8.2f\n", "bytewise table CRC-32C", bytewiseRate);
+    std::printf("%-28s %8.2f\n", "memcpy", copyRate);
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <string>
+#include "utils/checksum.hpp"
+#include "utils/string.hpp"
+
+namespace
+{
+    std::uint32_t crc32cOf(std::string_view data)
+    {
+        Util::Checksum::Crc32c crc;
+        crc.update(data.data(), data.size());
+        return crc.value();
+    }
+    std::string sha256Hex(std::string_view data)
+    {
+        Util::Checksum::Sha256 sha;
+        sha.update(data.data(), data.size());
+        return Util::String::encodeHex(sha.finish());
+    }
+    std::string hmacHex(std::string_view key, std::string_view message)
+    {
+        return Util::String::encodeHex(Util::Checksum::hmacSha256(key, message));
+    }
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(checksum)
+
+BOOST_AUTO_TEST_CASE(crc32cCheckValue)
+{
+    BOOST_TEST(crc32cOf("123456789") == 0xE3069283U);
+    BOOST_TEST(crc32cOf("") == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(crc32cIsIndependentOfUpdateSplits)
+{
+    const std::string data(1000, 'x');
+    Util::Checksum::Crc32c crc;
+    for (std::size_t offset = 0; offset < data.size(); offset += 7)
+    {
+        crc.update(data.data() + offset, std::min<std::size_t>(7, data.size() - offset));
+    }
+    BOOST_TEST(crc.value() == crc32cOf(data));
+}
+
+BOOST_AUTO_TEST_CASE(crc32cCombinesPieces)
+{
+    std::string data;
+    for (int i = 0; i < 5000; ++i)
+    {
+        data.push_back(static_cast<char>(i * 31 + 7));
+    }
+
+    for (const std::size_t split : {std::size_t{0}, std::size_t{1}, std::size_t{63}, std::size_t{4096}, data.size()})
+    {
+        const std::string_view first = std::string_view{data}.substr(0, split);
+        const std::string_view second = std::string_view{data}.substr(split);
+        BOOST_TEST(Util::Checksum::combineCrc32c(crc32cOf(first), crc32cOf(second), second.size()) == crc32cOf(data));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(crc32cHeaderRoundTrips)
+{
+    BOOST_TEST(Util::Checksum::formatCrc32c(0xE3069283U) == "crc32c 4waSgw==");
+    const auto [ok, crc] = Util::Checksum::parseCrc32c("crc32c 4waSgw==");
+    BOOST_TEST(ok);
+    BOOST_TEST(crc == 0xE3069283U);
+    BOOST_TEST(!std::get<0>(Util::Checksum::parseCrc32c("sha1 4waSgw==")));
+    BOOST_TEST(!std::get<0>(Util::Checksum::parseCrc32c("crc32c !!")));
+}
+
+BOOST_AUTO_TEST_CASE(sha256KnownAnswers)
+{
+    BOOST_TEST(sha256Hex("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    BOOST_TEST(sha256Hex("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    BOOST_TEST(sha256Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")
+               == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+}
+
+BOOST_AUTO_TEST_CASE(sha256IsIndependentOfUpdateSplits)
+{
+    const std::string block(1000, 'a');
+    Util::Checksum::Sha256 sha;
+    for (int i = 0; i < 1000; ++i)
+    {
+        sha.update(block.data(), block.size());
+    }
+    BOOST_TEST(Util::String::encodeHex(sha.finish()) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+BOOST_AUTO_TEST_CASE(reprDigestRoundTrips)
+{
+    std::string digest;
+    BOOST_REQUIRE(Util::String::decodeBase64("47DEQpj8HBSa+/TImW+5JCeuQeRkm5NMpJWZG3hSuFU=", digest));
+    BOOST_TEST(Util::Checksum::formatSha256(digest) == "sha-256=:47DEQpj8HBSa+/TImW+5JCeuQeRkm5NMpJWZG3hSuFU=:");
+
+    const auto [ok, parsed] = Util::Checksum::parseSha256("md5=:1B2M2Y8AsgTpgAmY7PhCfg==:, sha-256=:47DEQpj8HBSa+/TImW+5JCeuQeRkm5NMpJWZG3hSuFU=:");
+    BOOST_TEST(ok);
+    BOOST_TEST(parsed == digest);
+    BOOST_TEST(!std::get<0>(Util::Checksum::parseSha256("md5=:1B2M2Y8AsgTpgAmY7PhCfg==:")));
+    BOOST_TEST(!std::get<0>(Util::Checksum::parseSha256("sha-256=:AAAA:")));
+}
+
+// RFC 4231 test cases 1 to 4, 6 and 7; case 5 checks truncated output, which is not offered.
+BOOST_AUTO_TEST_CASE(hmacSha256Rfc4231)
+{
+    std::string counting;
+    for (char c = 1; c <= 25; ++c)
+    {
+        counting.push_back(c);
+    }
+    const std::string longKey(131, '\xaa');
+
+    BOOST_TEST(hmacHex(std::string(20, '\x0b'), "Hi There") == "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+    BOOST_TEST(hmacHex("Jefe", "what do ya want for nothing?") == "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+    BOOST_TEST(hmacHex(std::string(20, '\xaa'), std::string(50, '\xdd')) == "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe");
+    BOOST_TEST(hmacHex(counting, std::string(50, '\xcd')) == "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b");
+    BOOST_TEST(hmacHex(longKey, "Test Using Larger Than Block-Size Key - Hash Key First")
+               == "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+    BOOST_TEST(hmacHex(longKey, "This is a test using a larger than block-size key and a larger than block-size data. "
+                                "The key needs to be hashed before being used by the HMAC algorithm.")
+               == "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2");
+}
+
+BOOST_AUTO_TEST_CASE(pbkdf2Sha256KnownAnswers)
+{
+    BOOST_TEST(Util::String::encodeHex(Util::Checksum::pbkdf2Sha256("password", "salt", 1))
+               == "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b");
+    BOOST_TEST(Util::String::encodeHex(Util::Checksum::pbkdf2Sha256("password", "salt", 2))
+               == "ae4d0c95af6b46d32d0adff928f06dd02a303f8ef3c251dfd6e2d85a95474c43");
+    BOOST_TEST(Util::String::encodeHex(Util::Checksum::pbkdf2Sha256("password", "salt", 4096))
+               == "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a");
+}
+
+BOOST_AUTO_TEST_CASE(equalConstantTimeComparesWholeStrings)
+{
+    BOOST_TEST(Util::Checksum::equalConstantTime("secret", "secret"));
+    BOOST_TEST(!Util::Checksum::equalConstantTime("secret", "secreT"));
+    BOOST_TEST(!Util::Checksum::equalConstantTime("secret", "secrets"));
+    BOOST_TEST(Util::Checksum::equalConstantTime("", ""));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#include <boost/test/unit_test.hpp>
+#include <array>
+#include <string>
+#include "utils/compression.hpp"
+#ifdef ACCIO_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using Util::Compression::Encoding;
+
+namespace
+{
+    constexpr std::array<Encoding, 3> offered{Encoding::Brotli, Encoding::Gzip, Encoding::Deflate};
+
+#ifdef ACCIO_HAVE_ZLIB
+    std::string gunzip(const std::string &compressed)
+    {
+        z_stream stream{};
+        BOOST_REQUIRE(inflateInit2(&stream, 16 + MAX_WBITS) == Z_OK);
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+        stream.avail_in = static_cast<uInt>(compressed.size());
+
+        std::string result;
+        char buffer[4096];
+        int status = Z_OK;
+        while (status == Z_OK)
+        {
+            stream.next_out = reinterpret_cast<Bytef *>(buffer);
+            stream.avail_out = sizeof(buffer);
+            status = inflate(&stream, Z_NO_FLUSH);
+            result.append(buffer, sizeof(buffer) - stream.avail_out);
+        }
+        inflateEnd(&stream);
+        BOOST_TEST(status == Z_STREAM_END);
+        return result;
+    }
+#endif
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(compression)
+
+BOOST_AUTO_TEST_CASE(negotiationPrefersTheHighestQValue)
+{
+    BOOST_TEST((Util::Compression::negotiate("gzip;q=0.5, deflate", offered) == Encoding::Deflate));
+    BOOST_TEST((Util::Compression::negotiate("gzip, br", offered) == Encoding::Brotli));
+    BOOST_TEST((Util::Compression::negotiate("GZIP;Q=1", offered) == Encoding::Gzip));
+}
+
+BOOST_AUTO_TEST_CASE(negotiationHonoursWildcardsAndRefusals)
+{
+    BOOST_TEST((Util::Compression::negotiate("*", offered) == Encoding::Brotli));
+    BOOST_TEST((Util::Compression::negotiate("br;q=0, *;q=0.1", offered) == Encoding::Gzip));
+    BOOST_TEST((Util::Compression::negotiate("gzip;q=0", offered) == Encoding::Identity));
+    BOOST_TEST((Util::Compression::negotiate("", offered) == Encoding::Identity));
+    BOOST_TEST((Util::Compression::negotiate("compress", offered) == Encoding::Identity));
+}
+
+#ifdef ACCIO_HAVE_ZLIB
+BOOST_AUTO_TEST_CASE(gzipRoundTrips)
+{
+    const std::string body(5000, 'x');
+    const auto [ok, compressed] = Util::Compression::compress(Encoding::Gzip, body);
+    BOOST_REQUIRE(ok);
+    BOOST_TEST(compressed.size() < body.size());
+    BOOST_TEST(gunzip(compressed) == body);
+}
+
+BOOST_AUTO_TEST_CASE(flushedEncoderOutputIsDecodableMidStream)
+{
+    Util::Compression::Encoder encoder;
+    BOOST_REQUIRE(encoder.open(Encoding::Gzip));
+
+    std::string output;
+    const Util::Compression::Encoder::Writer collect = [&output](const char *data, std::size_t length) {
+        output.append(data, length);
+        return true;
+    };
+
+    BOOST_REQUIRE(encoder.write("<ul>\n", 5, true, collect));
+    const std::size_t afterHead = output.size();
+    BOOST_TEST(afterHead > 0U);
+
+    BOOST_REQUIRE(encoder.write("<li>a</li>\n", 11, true, collect));
+    BOOST_TEST(output.size() > afterHead);
+
+    BOOST_REQUIRE(encoder.finish(collect));
+    BOOST_TEST(gunzip(output) == "<ul>\n<li>a</li>\n");
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
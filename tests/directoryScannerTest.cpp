@@ -0,0 +1,118 @@
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "utils/directoryScanner.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct SampleDirectory
+    {
+        fs::path path;
+
+        SampleDirectory()
+        {
+            path = fs::temp_directory_path() / ("accio-scanner-" + Util::String::generateRandomString(12));
+            fs::create_directories(path / "sub");
+            std::ofstream{path / "five.txt"} << "12345";
+        }
+
+        ~SampleDirectory()
+        {
+            std::error_code ec;
+            fs::remove_all(path, ec);
+        }
+
+        static const Util::DirectoryScanner::Entry *find(Util::DirectoryScanner &scanner, const std::string &name)
+        {
+            const auto &entries = scanner.entries();
+            auto it = std::find_if(entries.begin(), entries.end(), [&](const auto &entry) {
+                return entry.name == name;
+            });
+            return it == entries.end() ? nullptr : &*it;
+        }
+    };
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(directoryScanner, SampleDirectory)
+
+BOOST_AUTO_TEST_CASE(readsNamesTypesAndMetadata)
+{
+    Util::DirectoryScanner scanner;
+    BOOST_REQUIRE(scanner.open(path));
+    BOOST_TEST(scanner.entries().size() == 2U);
+    scanner.collectMetadata(1);
+
+    const auto *file = find(scanner, "five.txt");
+    BOOST_REQUIRE(file);
+    BOOST_TEST(file->isRegularFile);
+    BOOST_TEST(!file->isDirectory);
+    BOOST_TEST(file->hasMetadata);
+    BOOST_TEST(file->size == 5U);
+    BOOST_TEST(file->mtimeSeconds > 0);
+
+    const auto *directory = find(scanner, "sub");
+    BOOST_REQUIRE(directory);
+    BOOST_TEST(directory->isDirectory);
+    BOOST_TEST(!directory->isSymlink);
+}
+
+BOOST_AUTO_TEST_CASE(symlinksTakeTheTypeOfTheirTarget)
+{
+    fs::create_directory_symlink(path / "sub", path / "link-to-sub");
+    fs::create_symlink(path / "missing", path / "dangling");
+
+    Util::DirectoryScanner scanner;
+    BOOST_REQUIRE(scanner.open(path));
+
+    const auto *link = find(scanner, "link-to-sub");
+    BOOST_REQUIRE(link);
+    BOOST_TEST(link->isSymlink);
+    BOOST_TEST(link->isDirectory);
+
+    const auto *dangling = find(scanner, "dangling");
+    BOOST_REQUIRE(dangling);
+    BOOST_TEST(dangling->isSymlink);
+    BOOST_TEST(!dangling->isDirectory);
+    BOOST_TEST(!dangling->isRegularFile);
+}
+
+BOOST_AUTO_TEST_CASE(collectsMetadataOnlyForKeptEntriesAcrossThreads)
+{
+    for (int i = 0; i < 1200; ++i)
+    {
+        const std::string name = std::string{"f"}.append(std::to_string(i));
+        std::ofstream{path / name} << std::string(static_cast<std::size_t>(i % 7), 'x');
+    }
+
+    Util::DirectoryScanner scanner;
+    BOOST_REQUIRE(scanner.open(path));
+    auto &entries = scanner.entries();
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const auto &entry) {
+        return entry.name == "sub";
+    }), entries.end());
+    scanner.collectMetadata(4);
+
+    BOOST_TEST(entries.size() == 1201U);
+    for (const auto &entry : entries)
+    {
+        BOOST_TEST(entry.hasMetadata);
+        if (entry.name != "five.txt")
+        {
+            BOOST_TEST(entry.size == std::stoull(entry.name.substr(1)) % 7U);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(openingAMissingDirectoryFails)
+{
+    Util::DirectoryScanner scanner;
+    BOOST_TEST(!scanner.open(path / "missing"));
+    BOOST_TEST(!scanner.isOpen());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,157 @@
+// Throughput of the download path: the ifstream reader the server used before, which seeks and allocates
+// a 64 KiB vector on every provider call, against Util::FileReader. Both feed a sink that copies each block
+// once, as writing to the socket would. The file is read once beforehand so both run from the page cache.
+//
+// Usage: downloadBenchmark [file size in MiB, default 256]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include "utils/fileReader.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    using Sink = std::function<bool(const char *data, std::size_t length)>;
+
+    constexpr int rounds = 5;
+
+    // The provider body of the previous Core::streamFileResponse.
+    bool streamWithIfstream(const fs::path &path, std::size_t offset, std::size_t length, const Sink &sink)
+    {
+        std::ifstream fileStream(path, std::ios::binary);
+        fileStream.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+        if (!fileStream.good())
+        {
+            return false;
+        }
+
+        static constexpr std::size_t chunkSize = 64U * 1024U;
+        std::vector<char> buffer(chunkSize);
+        std::size_t remaining = length;
+        while (remaining > 0)
+        {
+            const std::size_t toRead = std::min(remaining, buffer.size());
+            fileStream.read(buffer.data(), static_cast<std::streamsize>(toRead));
+            const std::streamsize readBytes = fileStream.gcount();
+            if (readBytes <= 0 || !sink(buffer.data(), static_cast<std::size_t>(readBytes)))
+            {
+                return false;
+            }
+            remaining -= static_cast<std::size_t>(readBytes);
+        }
+        return true;
+    }
+
+    bool streamWithFileReader(const fs::path &path, std::size_t offset, std::size_t length, const Sink &sink)
+    {
+        Util::FileReader reader;
+        return reader.open(path) && reader.stream(offset, length, sink);
+    }
+
+    struct Measurement
+    {
+        double wallSeconds;
+        double cpuSeconds;
+    };
+
+    Measurement measure(const std::function<bool()> &run)
+    {
+        const auto wallStart = std::chrono::steady_clock::now();
+        const std::clock_t cpuStart = std::clock();
+        if (!run())
+        {
+            std::fprintf(stderr, "read failed\n");
+            std::exit(EXIT_FAILURE);
+        }
+        const double cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        return Measurement{wallSeconds, cpuSeconds};
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const std::size_t sizeMiB = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 256U;
+    const std::size_t size = sizeMiB * 1024U * 1024U;
+    if (size == 0)
+    {
+        std::fprintf(stderr, "usage: %s [file size in MiB]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const fs::path path = fs::temp_directory_path() / ("accio-download-" + Util::String::generateRandomString(12));
+    {
+        std::ofstream file(path, std::ios::binary);
+        std::vector<char> block(1024U * 1024U);
+        for (std::size_t i = 0; i < block.size(); ++i)
+        {
+            block[i] = static_cast<char>(i * 131U);
+        }
+        for (std::size_t written = 0; written < size; written += block.size())
+        {
+            file.write(block.data(), static_cast<std::streamsize>(block.size()));
+        }
+    }
+
+    // Stands in for the socket: every byte is copied once more, into a buffer that is reused.
+    std::vector<char> socketBuffer(256U * 1024U);
+    std::size_t delivered = 0;
+    const Sink sink = [&](const char *data, std::size_t length) {
+        for (std::size_t done = 0; done < length;)
+        {
+            const std::size_t piece = std::min(length - done, socketBuffer.size());
+            std::memcpy(socketBuffer.data(), data + done, piece);
+            done += piece;
+        }
+        delivered += length;
+        return true;
+    };
+
+    streamWithFileReader(path, 0, size, sink);
+
+    struct Candidate
+    {
+        const char *name;
+        bool (*stream)(const fs::path &, std::size_t, std::size_t, const Sink &);
+        Measurement best{1e9, 1e9};
+    };
+    Candidate candidates[] = {{"ifstream + vector", streamWithIfstream}, {"FileReader (pread)", streamWithFileReader}};
+
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (Candidate &candidate : candidates)
+        {
+            delivered = 0;
+            const Measurement measurement = measure([&] { return candidate.stream(path, 0, size, sink); });
+            if (delivered != size)
+            {
+                std::fprintf(stderr, "%s delivered %zu of %zu bytes\n", candidate.name, delivered, size);
+                return EXIT_FAILURE;
+            }
+            candidate.best.wallSeconds = std::min(candidate.best.wallSeconds, measurement.wallSeconds);
+            candidate.best.cpuSeconds = std::min(candidate.best.cpuSeconds, measurement.cpuSeconds);
+        }
+    }
+
+    std::error_code ec;
+    fs::remove(path, ec);
+
+    std::printf("%zu MiB from the page cache, best of %d rounds\n\n", sizeMiB, rounds);
+    std::printf("%-20s %12s %14s\n", "reader", "MiB/s", "CPU s per GiB");
+    for (const Candidate &candidate : candidates)
+    {
+        std::printf("%-20s %12.0f %14.3f\n", candidate.name, static_cast<double>(sizeMiB) / candidate.best.wallSeconds,
+                    candidate.best.cpuSeconds * 1024.0 / static_cast<double>(sizeMiB));
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "utils/fileReader.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // A file larger than the reader's block, so slices cross block boundaries.
+    struct SampleFile
+    {
+        fs::path path;
+        std::string content;
+
+        SampleFile()
+        {
+            path = fs::temp_directory_path() / ("accio-reader-" + Util::String::generateRandomString(12));
+            content.resize(600U * 1024U + 17U);
+            for (std::size_t i = 0; i < content.size(); ++i)
+            {
+                content[i] = static_cast<char>((i * 7U) ^ (i >> 9));
+            }
+            std::ofstream{path, std::ios::binary}.write(content.data(), static_cast<std::streamsize>(content.size()));
+        }
+
+        ~SampleFile()
+        {
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+
+        std::string read(Util::FileReader &reader, std::uintmax_t offset, std::uintmax_t length) const
+        {
+            std::string result;
+            const bool ok = reader.stream(offset, length, [&](const char *data, std::size_t size) {
+                result.append(data, size);
+                return true;
+            });
+            BOOST_TEST(ok);
+            return result;
+        }
+    };
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(fileReader, SampleFile)
+
+BOOST_AUTO_TEST_CASE(reportsTheFileSize)
+{
+    Util::FileReader reader;
+    BOOST_REQUIRE(reader.open(path));
+    BOOST_TEST(reader.isOpen());
+    BOOST_TEST(reader.size() == content.size());
+    reader.close();
+    BOOST_TEST(!reader.isOpen());
+}
+
+BOOST_AUTO_TEST_CASE(streamsTheWholeFile)
+{
+    Util::FileReader reader;
+    BOOST_REQUIRE(reader.open(path));
+    BOOST_TEST(read(reader, 0, content.size()) == content);
+}
+
+// What a single-range response and the parts of a multipart/byteranges response ask for: slices at
+// arbitrary offsets, in any order, from one reader.
+BOOST_AUTO_TEST_CASE(servesRangesInAnyOrder)
+{
+    Util::FileReader reader;
+    BOOST_REQUIRE(reader.open(path));
+    const std::pair<std::uintmax_t, std::uintmax_t> ranges[] = {
+        {500000, 100000}, {0, 1}, {content.size() - 17, 17}, {262143, 2}, {100, 300000}, {content.size() - 1, 1}};
+    for (const auto &[offset, length] : ranges)
+    {
+        BOOST_TEST(read(reader, offset, length) == content.substr(offset, length));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(failsOnReadsPastTheEnd)
+{
+    Util::FileReader reader;
+    BOOST_REQUIRE(reader.open(path));
+    const bool ok = reader.stream(content.size() - 10, 20, [](const char *, std::size_t) {
+        return true;
+    });
+    BOOST_TEST(!ok);
+}
+
+BOOST_AUTO_TEST_CASE(stopsWhenTheWriterRefuses)
+{
+    Util::FileReader reader;
+    BOOST_REQUIRE(reader.open(path));
+    int calls = 0;
+    const bool ok = reader.stream(0, content.size(), [&](const char *, std::size_t) {
+        ++calls;
+        return false;
+    });
+    BOOST_TEST(!ok);
+    BOOST_TEST(calls == 1);
+}
+
+BOOST_AUTO_TEST_CASE(failsToOpenMissingFiles)
+{
+    Util::FileReader reader;
+    BOOST_TEST(!reader.open(path.string() + ".missing"));
+    BOOST_TEST(!reader.isOpen());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "utils/fileWriter.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct Target
+    {
+        fs::path path = fs::temp_directory_path() / ("accio-writer-" + Util::String::generateRandomString(12));
+
+        ~Target()
+        {
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+
+        std::string read() const
+        {
+            std::ifstream file(path, std::ios::binary);
+            return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        }
+
+        // Larger than the writer's block, so both the buffered path and the direct path are taken.
+        static std::string sample(std::size_t size)
+        {
+            std::string content(size, '\0');
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                content[i] = static_cast<char>((i * 13U) ^ (i >> 11));
+            }
+            return content;
+        }
+    };
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(fileWriter, Target)
+
+BOOST_AUTO_TEST_CASE(coalescesSmallWrites)
+{
+    const std::string content = sample(3U * 1024U * 1024U + 123U);
+    Util::FileWriter writer;
+    BOOST_REQUIRE(writer.open(path));
+    for (std::size_t offset = 0; offset < content.size(); offset += 1000U)
+    {
+        BOOST_REQUIRE(writer.write(content.data() + offset, std::min<std::size_t>(1000U, content.size() - offset)));
+    }
+    BOOST_TEST(writer.size() == content.size());
+    BOOST_REQUIRE(writer.close());
+    BOOST_TEST(!writer.isOpen());
+    BOOST_TEST(read() == content);
+}
+
+BOOST_AUTO_TEST_CASE(mixesBufferedAndLargeWrites)
+{
+    const std::string content = sample(5U * 1024U * 1024U);
+    const std::size_t pieces[] = {17U, 2U * 1024U * 1024U, 4096U, 1024U * 1024U + 5U};
+    Util::FileWriter writer;
+    BOOST_REQUIRE(writer.open(path));
+    std::size_t offset = 0;
+    for (std::size_t piece : pieces)
+    {
+        BOOST_REQUIRE(writer.write(content.data() + offset, piece));
+        offset += piece;
+    }
+    BOOST_REQUIRE(writer.write(content.data() + offset, content.size() - offset));
+    BOOST_REQUIRE(writer.close());
+    BOOST_TEST(read() == content);
+}
+
+BOOST_AUTO_TEST_CASE(truncatesAnExistingFile)
+{
+    std::ofstream{path} << "a much longer previous content";
+    Util::FileWriter writer;
+    BOOST_REQUIRE(writer.open(path));
+    BOOST_REQUIRE(writer.write("new", 3));
+    BOOST_REQUIRE(writer.close());
+    BOOST_TEST(read() == "new");
+}
+
+BOOST_AUTO_TEST_CASE(closeTrimsAnUnfilledReservation)
+{
+    Util::FileWriter writer;
+    BOOST_REQUIRE(writer.open(path, 8U * 1024U * 1024U));
+    BOOST_REQUIRE(writer.write("short", 5));
+    BOOST_REQUIRE(writer.close());
+    BOOST_TEST(fs::file_size(path) == 5U);
+    BOOST_TEST(read() == "short");
+}
+
+BOOST_AUTO_TEST_CASE(everyModeWritesTheSameBytes)
+{
+    // Direct falls back to the page cache where O_DIRECT is refused, as on tmpfs, and for the unaligned tail.
+    const std::string content = sample(9U * 1024U * 1024U + 777U);
+    for (const Util::FileWriter::Mode mode : {Util::FileWriter::Mode::Cached, Util::FileWriter::Mode::WriteBehind, Util::FileWriter::Mode::Direct})
+    {
+        Util::FileWriter writer;
+        BOOST_REQUIRE(writer.open(path, content.size(), mode));
+        for (std::size_t offset = 0; offset < content.size(); offset += 64U * 1024U + 3U)
+        {
+            BOOST_REQUIRE(writer.write(content.data() + offset, std::min<std::size_t>(64U * 1024U + 3U, content.size() - offset)));
+        }
+        BOOST_REQUIRE(writer.close());
+        BOOST_TEST(!writer.outOfSpace());
+        BOOST_TEST(read() == content);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(failsInAMissingDirectory)
+{
+    Util::FileWriter writer;
+    BOOST_TEST(!writer.open(path / "missing" / "file"));
+    BOOST_TEST(!writer.isOpen());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
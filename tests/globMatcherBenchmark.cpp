@@ -0,0 +1,77 @@
+// Cost of matching one path against a large --deny-files pattern set compiled into a GlobMatcher: plain
+// names, *.ext patterns and anchored globs in the proportions 5:3:2. None of the sample paths match, so
+// every active state is followed to the end of the path.
+//
+// Usage: globMatcherBenchmark [patterns, default 10000]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "globMatcher.hpp"
+
+namespace
+{
+    constexpr int rounds = 5;
+    constexpr std::size_t repeats = 20000;
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const std::size_t patternCount = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 10000U;
+    if (patternCount < 10)
+    {
+        std::fprintf(stderr, "usage: %s [patterns, at least 10]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    GlobMatcher matcher;
+    const std::size_t names = patternCount / 2;
+    const std::size_t extensions = patternCount * 3 / 10;
+    for (std::size_t i = 0; i < patternCount; ++i)
+    {
+        const std::string index = std::to_string(i);
+        if (i < names)
+        {
+            matcher.add("cache" + index, 0);
+        }
+        else if (i < names + extensions)
+        {
+            matcher.add("*.x" + index, 0);
+        }
+        else
+        {
+            matcher.add("/data" + index + "/*/build?", 0);
+        }
+    }
+
+    const std::vector<std::string> paths{"photos/2024/summer/img_0001.jpg", "src/app/main.cpp", "readme.md",
+                                         "data17/project/output/result.bin", "a/b/c/d/e/f/g/h/notes.txt"};
+
+    double best = 1e18;
+    std::size_t matched = 0;
+    for (int round = 0; round < rounds; ++round)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < repeats; ++i)
+        {
+            for (const std::string &path : paths)
+            {
+                matched += matcher.match(path, false).matched != 0 ? 1U : 0U;
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, seconds * 1e9 / static_cast<double>(repeats * paths.size()));
+    }
+
+    std::printf("%zu patterns (%zu names, %zu *.ext, %zu anchored globs), best of %d rounds\n\n", patternCount, names,
+                extensions, patternCount - names - extensions, rounds);
+    std::printf("%-28s %12.0f\n", "ns/path", best);
+    if (matched != 0)
+    {
+        std::fprintf(stderr, "%zu unexpected matches\n", matched);
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <boost/test/unit_test.hpp>
+#include "globMatcher.hpp"
+
+namespace
+{
+    constexpr std::uint8_t tagBit = 1U << 0;
+
+    GlobMatcher makeMatcher(std::initializer_list<std::string_view> patterns)
+    {
+        GlobMatcher matcher;
+        for (const std::string_view pattern : patterns)
+        {
+            BOOST_REQUIRE(matcher.add(pattern, 0));
+        }
+        return matcher;
+    }
+
+    bool matches(const GlobMatcher &matcher, std::string_view path, bool isDirectory = false)
+    {
+        return (matcher.match(path, isDirectory).matched & tagBit) != 0;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(globMatcher)
+
+BOOST_AUTO_TEST_CASE(detectsPatterns)
+{
+    BOOST_TEST(GlobMatcher::isPattern("*.log"));
+    BOOST_TEST(GlobMatcher::isPattern("file?.txt"));
+    BOOST_TEST(GlobMatcher::isPattern("[ab].txt"));
+    BOOST_TEST(!GlobMatcher::isPattern("docs/readme.md"));
+}
+
+BOOST_AUTO_TEST_CASE(unanchoredPatternsMatchAtAnyDepth)
+{
+    const GlobMatcher matcher = makeMatcher({"*.tmp"});
+    BOOST_TEST(matches(matcher, "a.tmp"));
+    BOOST_TEST(matches(matcher, "x/y/a.tmp"));
+    BOOST_TEST(!matches(matcher, "a.tmpx"));
+    BOOST_TEST(!matches(matcher, "x/a.txt"));
+}
+
+BOOST_AUTO_TEST_CASE(slashAnchorsToTheRoot)
+{
+    const GlobMatcher matcher = makeMatcher({"docs/*.md"});
+    BOOST_TEST(matches(matcher, "docs/readme.md"));
+    BOOST_TEST(!matches(matcher, "other/docs/readme.md"));
+    BOOST_TEST(!matches(matcher, "docs/sub/readme.md"));
+}
+
+BOOST_AUTO_TEST_CASE(wildcardsStayWithinAComponent)
+{
+    const GlobMatcher matcher = makeMatcher({"/file?.[ch]", "/[!x]y"});
+    BOOST_TEST(matches(matcher, "file1.c"));
+    BOOST_TEST(matches(matcher, "fileA.h"));
+    BOOST_TEST(!matches(matcher, "file12.c"));
+    BOOST_TEST(!matches(matcher, "file1.o"));
+    BOOST_TEST(matches(matcher, "ay"));
+    BOOST_TEST(!matches(matcher, "xy"));
+}
+
+BOOST_AUTO_TEST_CASE(doubleStarSpansComponents)
+{
+    const GlobMatcher matcher = makeMatcher({"a/**/z", "logs/**"});
+    BOOST_TEST(matches(matcher, "a/z"));
+    BOOST_TEST(matches(matcher, "a/b/c/z"));
+    BOOST_TEST(!matches(matcher, "b/a/z"));
+    BOOST_TEST(matches(matcher, "logs/today.log"));
+    BOOST_TEST(!matches(matcher, "logs", true));
+}
+
+BOOST_AUTO_TEST_CASE(trailingSlashMatchesDirectoriesAndTheirContents)
+{
+    const GlobMatcher matcher = makeMatcher({"node_modules*/"});
+    BOOST_TEST(matches(matcher, "node_modules", true));
+    BOOST_TEST(!matches(matcher, "node_modules", false));
+    BOOST_TEST(matches(matcher, "app/node_modules2/pkg/index.js"));
+}
+
+BOOST_AUTO_TEST_CASE(reportsPatternsPendingBelowADirectory)
+{
+    const GlobMatcher matcher = makeMatcher({"docs/*.md"});
+    BOOST_TEST((matcher.match("docs", true).pending & tagBit) != 0);
+    BOOST_TEST((matcher.match("src", true).pending & tagBit) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(keepsTagsApart)
+{
+    GlobMatcher matcher;
+    BOOST_REQUIRE(matcher.add("*.log", 0));
+    BOOST_REQUIRE(matcher.add("*.md", 1));
+    BOOST_TEST(matcher.match("a.log", false).matched == 1U << 0);
+    BOOST_TEST(matcher.match("a.md", false).matched == 1U << 1);
+    BOOST_TEST(!matcher.add("", 0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+#include <boost/test/unit_test.hpp>
+#include "utils/http.hpp"
+
+namespace
+{
+    // The example date of RFC 9110 section 5.6.7.
+    constexpr std::int64_t exampleDate = 784111777;
+
+    Util::File::EntryStat makeStat()
+    {
+        Util::File::EntryStat stat;
+        stat.isRegularFile = true;
+        stat.size = 0x1234;
+        stat.mtimeSeconds = 1;
+        stat.mtimeNanoseconds = 5;
+        stat.inode = 0xabc;
+        return stat;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(http)
+
+BOOST_AUTO_TEST_CASE(formatsImfFixdate)
+{
+    BOOST_TEST(Util::Http::formatHttpDate(exampleDate) == "Sun, 06 Nov 1994 08:49:37 GMT");
+    BOOST_TEST(Util::Http::formatHttpDate(0) == "Thu, 01 Jan 1970 00:00:00 GMT");
+    BOOST_TEST(Util::Http::formatHttpDate(951782400) == "Tue, 29 Feb 2000 00:00:00 GMT");
+}
+
+BOOST_AUTO_TEST_CASE(parsesTheThreeDateFormats)
+{
+    for (const char *text : {"Sun, 06 Nov 1994 08:49:37 GMT", "Sunday, 06-Nov-94 08:49:37 GMT", "Sun Nov  6 08:49:37 1994"})
+    {
+        const auto [ok, seconds] = Util::Http::parseHttpDate(text);
+        BOOST_TEST(ok, text);
+        BOOST_TEST(seconds == exampleDate, text);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rejectsMalformedDates)
+{
+    for (const char *text : {"", "Sun", "Sun, 06 Nov 1994 08:49:37", "Sun, 06 Foo 1994 08:49:37 GMT",
+                             "Sun, 32 Nov 1994 08:49:37 GMT", "Sun, 06 Nov 1994 24:00:00 GMT", "Sun, 06 Nov 1994 08:49:37 GMT x"})
+    {
+        BOOST_TEST(!std::get<0>(Util::Http::parseHttpDate(text)), text);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(formatRoundTrips)
+{
+    for (const std::int64_t seconds : {std::int64_t{0}, exampleDate, std::int64_t{1700000000}, std::int64_t{4102444799}})
+    {
+        const auto [ok, parsed] = Util::Http::parseHttpDate(Util::Http::formatHttpDate(seconds));
+        BOOST_TEST(ok);
+        BOOST_TEST(parsed == seconds);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(buildsEntityTags)
+{
+    const Util::File::EntryStat stat = makeStat();
+    BOOST_TEST(Util::Http::buildEntityTag(stat, false) == "\"abc-1234-3b9aca05\"");
+    BOOST_TEST(Util::Http::buildEntityTag(stat, true) == "W/\"abc-1234-3b9aca05\"");
+    BOOST_TEST(Util::Http::buildEntityTag(stat, true, 0x7f) == "W/\"abc-1234-3b9aca05-7f\"");
+
+    Util::File::EntryStat changed = stat;
+    changed.mtimeNanoseconds = 6;
+    BOOST_TEST(Util::Http::buildEntityTag(changed, false) != Util::Http::buildEntityTag(stat, false));
+}
+
+BOOST_AUTO_TEST_CASE(ifNoneMatchComparesWeakly)
+{
+    const std::string tag = "\"abc-1\"";
+    BOOST_TEST(Util::Http::isNotModified(tag, "", tag, 0));
+    BOOST_TEST(Util::Http::isNotModified("W/\"abc-1\"", "", tag, 0));
+    BOOST_TEST(Util::Http::isNotModified(tag, "", "W/" + tag, 0));
+    BOOST_TEST(Util::Http::isNotModified("\"other\", \"abc-1\"", "", tag, 0));
+    BOOST_TEST(Util::Http::isNotModified("*", "", tag, 0));
+    BOOST_TEST(!Util::Http::isNotModified("\"other\"", "", tag, 0));
+}
+
+BOOST_AUTO_TEST_CASE(ifNoneMatchOverridesIfModifiedSince)
+{
+    const std::string date = Util::Http::formatHttpDate(exampleDate);
+    BOOST_TEST(!Util::Http::isNotModified("\"other\"", date, "\"abc-1\"", exampleDate));
+    BOOST_TEST(Util::Http::isNotModified("", date, "\"abc-1\"", exampleDate));
+    BOOST_TEST(Util::Http::isNotModified("", date, "\"abc-1\"", exampleDate - 1));
+    BOOST_TEST(!Util::Http::isNotModified("", date, "\"abc-1\"", exampleDate + 1));
+    BOOST_TEST(!Util::Http::isNotModified("", "yesterday", "\"abc-1\"", exampleDate));
+    BOOST_TEST(!Util::Http::isNotModified("", "", "\"abc-1\"", exampleDate));
+}
+
+BOOST_AUTO_TEST_CASE(ifRangeNeedsAStrongMatch)
+{
+    const std::string tag = "\"abc-1\"";
+    BOOST_TEST(Util::Http::isIfRangeSatisfied(tag, tag, 0));
+    BOOST_TEST(Util::Http::isIfRangeSatisfied(" " + tag + " ", tag, 0));
+    BOOST_TEST(!Util::Http::isIfRangeSatisfied("W/" + tag, tag, 0));
+    BOOST_TEST(!Util::Http::isIfRangeSatisfied(tag, "W/" + tag, 0));
+    BOOST_TEST(!Util::Http::isIfRangeSatisfied("\"other\"", tag, 0));
+}
+
+BOOST_AUTO_TEST_CASE(ifRangeDateMustBeExact)
+{
+    const std::string date = Util::Http::formatHttpDate(exampleDate);
+    BOOST_TEST(Util::Http::isIfRangeSatisfied(date, "\"abc-1\"", exampleDate));
+    BOOST_TEST(!Util::Http::isIfRangeSatisfied(date, "\"abc-1\"", exampleDate - 1));
+    BOOST_TEST(!Util::Http::isIfRangeSatisfied("not a date", "\"abc-1\"", exampleDate));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,200 @@
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "listingCache.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct SampleDirectory
+    {
+        fs::path path;
+        int loads = 0;
+        ListingCache::Loader loader;
+
+        SampleDirectory()
+        {
+            path = fs::temp_directory_path() / ("accio-listing-" + Util::String::generateRandomString(12));
+            fs::create_directory(path);
+            std::ofstream{path / "a.txt"} << "a";
+            loader = [this](const fs::path &directory) {
+                ++loads;
+                ListingCache::Entries entries;
+                for (const auto &entry : fs::directory_iterator(directory))
+                {
+                    entries.push_back({entry.path().filename().string(), entry.is_directory(), entry.is_directory() ? 0 : entry.file_size(), 0});
+                }
+                return entries;
+            };
+        }
+
+        ~SampleDirectory()
+        {
+            std::error_code ec;
+            fs::remove_all(path, ec);
+        }
+
+        Util::File::EntryStat stat() const
+        {
+            const auto [ok, entryStat] = Util::File::statEntry(path);
+            BOOST_REQUIRE(ok);
+            return entryStat;
+        }
+    };
+
+    // The watcher thread applies inotify events asynchronously.
+    bool waitForInvalidation(const ListingCache &cache, std::uint64_t before)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            if (cache.stats().invalidations > before)
+            {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return false;
+    }
+
+    // Inotify watches this process holds, as listed in /proc/self/fdinfo.
+    std::size_t countWatches()
+    {
+        std::size_t watches = 0;
+        std::error_code ec;
+        for (const auto &entry : fs::directory_iterator("/proc/self/fdinfo", ec))
+        {
+            std::ifstream info(entry.path());
+            std::string line;
+            while (std::getline(info, line))
+            {
+                watches += line.starts_with("inotify wd:") ? 1U : 0U;
+            }
+        }
+        return watches;
+    }
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(listingCache, SampleDirectory)
+
+BOOST_AUTO_TEST_CASE(servesRepeatedListingsFromTheCache)
+{
+    ListingCache cache{1024U * 1024U};
+    const auto first = cache.get(path, stat(), loader);
+    const auto second = cache.get(path, stat(), loader);
+
+    BOOST_TEST(loads == 1);
+    BOOST_TEST(first == second);
+    BOOST_REQUIRE(first->size() == 1U);
+    BOOST_TEST((*first)[0].name == "a.txt");
+
+    const ListingCache::Stats stats = cache.stats();
+    BOOST_TEST(stats.hits == 1U);
+    BOOST_TEST(stats.misses == 1U);
+    BOOST_TEST(stats.cachedDirectories == 1U);
+}
+
+BOOST_AUTO_TEST_CASE(zeroBudgetDisablesCaching)
+{
+    ListingCache cache{0};
+    cache.get(path, stat(), loader);
+    cache.get(path, stat(), loader);
+
+    BOOST_TEST(loads == 2);
+    BOOST_TEST(cache.stats().cachedDirectories == 0U);
+    BOOST_TEST(!cache.stats().watcherActive);
+}
+
+BOOST_AUTO_TEST_CASE(reloadsWhenTheDirectoryMtimeChanges)
+{
+    ListingCache cache{1024U * 1024U};
+    Util::File::EntryStat entryStat = stat();
+    cache.get(path, entryStat, loader);
+
+    ++entryStat.mtimeSeconds;
+    cache.get(path, entryStat, loader);
+    BOOST_TEST(loads == 2);
+}
+
+BOOST_AUTO_TEST_CASE(rewritingAChildInvalidatesTheListing)
+{
+    ListingCache cache{1024U * 1024U};
+    if (!cache.stats().watcherActive)
+    {
+        return;
+    }
+
+    // Rewriting a file in place leaves the directory mtime alone, so only the watch can notice.
+    const Util::File::EntryStat entryStat = stat();
+    cache.get(path, entryStat, loader);
+    const std::uint64_t before = cache.stats().invalidations;
+    std::ofstream{path / "a.txt"} << "longer contents";
+
+    BOOST_REQUIRE(waitForInvalidation(cache, before));
+    const auto entries = cache.get(path, entryStat, loader);
+    BOOST_TEST(loads == 2);
+    BOOST_TEST((*entries)[0].fileSize == 15U);
+}
+
+BOOST_AUTO_TEST_CASE(evictsTheLeastRecentlyUsedDirectoryOverBudget)
+{
+    const fs::path other = path / "other";
+    fs::create_directory(other);
+    const auto [ok, otherStat] = Util::File::statEntry(other);
+    BOOST_REQUIRE(ok);
+
+    std::size_t bothBytes = 0;
+    {
+        ListingCache measuring{1024U * 1024U};
+        measuring.get(other, otherStat, loader);
+        measuring.get(path, stat(), loader);
+        bothBytes = measuring.stats().cachedBytes;
+    }
+
+    // Room for either listing but not both.
+    ListingCache cache{bothBytes - 1U};
+    cache.get(other, otherStat, loader);
+    cache.get(path, stat(), loader);
+
+    const ListingCache::Stats stats = cache.stats();
+    BOOST_TEST(stats.evictions == 1U);
+    BOOST_TEST(stats.cachedDirectories == 1U);
+    BOOST_TEST(stats.cachedBytes <= stats.budgetBytes);
+}
+
+BOOST_AUTO_TEST_CASE(watchesLastOnlyAsLongAsTheListing)
+{
+    ListingCache cache{1024U * 1024U};
+    if (!cache.stats().watcherActive)
+    {
+        return;
+    }
+
+    const ListingCache::Loader failing = [](const fs::path &) -> ListingCache::Entries {
+        throw fs::filesystem_error("unreadable", std::make_error_code(std::errc::permission_denied));
+    };
+    BOOST_CHECK_THROW(cache.get(path, stat(), failing), fs::filesystem_error);
+    BOOST_TEST(countWatches() == 0U);
+
+    const Util::File::EntryStat entryStat = stat();
+    cache.get(path, entryStat, loader);
+    BOOST_TEST(countWatches() == 1U);
+
+    const std::uint64_t before = cache.stats().invalidations;
+    std::ofstream{path / "b.txt"} << "b";
+    BOOST_REQUIRE(waitForInvalidation(cache, before));
+    BOOST_TEST(countWatches() == 0U);
+
+    // A listing over the budget is served but neither cached nor watched.
+    ListingCache small{1};
+    small.get(path, stat(), loader);
+    BOOST_TEST(small.stats().cachedDirectories == 0U);
+    BOOST_TEST(countWatches() == 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
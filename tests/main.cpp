@@ -0,0 +1,3 @@
+// The header-only runner needs no Boost.Test library to link against; the other files share it.
+#define BOOST_TEST_MODULE accio
+#include <boost/test/included/unit_test.hpp>
@@ -0,0 +1,50 @@
+#include <boost/test/unit_test.hpp>
+#include "utils/network.hpp"
+
+namespace
+{
+    Util::Network::Address mappedIpv4(std::uint8_t a, std::uint8_t b, std::uint8_t c, std::uint8_t d)
+    {
+        Util::Network::Address address{};
+        address[10] = 0xFF;
+        address[11] = 0xFF;
+        address[12] = a;
+        address[13] = b;
+        address[14] = c;
+        address[15] = d;
+        return address;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(network)
+
+BOOST_AUTO_TEST_CASE(mapsIpv4Addresses)
+{
+    const auto address = Util::Network::parseAddress("192.168.1.20");
+    BOOST_REQUIRE(address.has_value());
+    BOOST_TEST((*address == mappedIpv4(192, 168, 1, 20)));
+
+    // Both spellings of the same client share one key.
+    BOOST_TEST((Util::Network::parseAddress("::ffff:192.168.1.20") == address));
+}
+
+BOOST_AUTO_TEST_CASE(parsesIpv6AndDropsTheZone)
+{
+    Util::Network::Address loopback{};
+    loopback[15] = 1;
+    BOOST_TEST((Util::Network::parseAddress("::1") == loopback));
+
+    const auto linkLocal = Util::Network::parseAddress("fe80::1%eth0");
+    BOOST_REQUIRE(linkLocal.has_value());
+    BOOST_TEST((linkLocal == Util::Network::parseAddress("fe80::1")));
+}
+
+BOOST_AUTO_TEST_CASE(rejectsNonAddresses)
+{
+    for (const char *text : {"", "localhost", "1.2.3", "1.2.3.4.5", "256.1.1.1", "1.2.3.4 ", "::g"})
+    {
+        BOOST_TEST(!Util::Network::parseAddress(text).has_value(), text);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "pathResolver.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct SampleTree
+    {
+        fs::path root;
+        fs::path base;
+
+        SampleTree()
+        {
+            root = fs::canonical(fs::temp_directory_path()) / ("accio-resolve-" + Util::String::generateRandomString(12));
+            base = root / "share";
+            fs::create_directories(base / "docs");
+            fs::create_directory(root / "outside");
+            std::ofstream{base / "docs" / "a.txt"} << "abc";
+            std::ofstream{root / "outside" / "secret.txt"} << "secret";
+        }
+
+        ~SampleTree()
+        {
+            std::error_code ec;
+            fs::remove_all(root, ec);
+        }
+    };
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(pathResolver)
+
+BOOST_AUTO_TEST_CASE(resolvesPlainPathsWithoutCanonicalising)
+{
+    SampleTree tree;
+    PathResolver resolver{tree.base};
+
+    const auto [found, path, stat] = resolver.resolve("docs/a.txt");
+    BOOST_REQUIRE(found);
+    BOOST_TEST(path == tree.base / "docs" / "a.txt");
+    BOOST_TEST(stat.isRegularFile);
+    BOOST_TEST(stat.size == 3U);
+
+    const auto [baseFound, basePath, baseStat] = resolver.resolve("");
+    BOOST_REQUIRE(baseFound);
+    BOOST_TEST(baseStat.isDirectory);
+
+    const PathResolver::Stats stats = resolver.stats();
+    if (stats.openat2)
+    {
+        BOOST_TEST(stats.direct == 2U);
+        BOOST_TEST(stats.canonicalised == 0U);
+    }
+    else
+    {
+        BOOST_TEST(stats.canonicalised == 2U);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(missingEntriesAreNotFound)
+{
+    SampleTree tree;
+    PathResolver resolver{tree.base};
+
+    BOOST_TEST(!std::get<0>(resolver.resolve("docs/missing.txt")));
+    BOOST_TEST(!std::get<0>(resolver.resolve("docs/a.txt/below")));
+}
+
+BOOST_AUTO_TEST_CASE(symlinksAreFollowedOnlyWithinTheBase)
+{
+    SampleTree tree;
+    std::error_code ec;
+    fs::create_directory_symlink(tree.base / "docs", tree.base / "inside", ec);
+    fs::create_directory_symlink(tree.root / "outside", tree.base / "escape", ec);
+    if (ec)
+    {
+        BOOST_TEST_MESSAGE("Symlinks are not available here; skipping");
+        return;
+    }
+
+    PathResolver resolver{tree.base};
+    const auto [found, path, stat] = resolver.resolve("inside/a.txt");
+    BOOST_REQUIRE(found);
+    BOOST_TEST(path == tree.base / "docs" / "a.txt");
+    BOOST_TEST(resolver.stats().canonicalised == 1U);
+
+    BOOST_TEST(!std::get<0>(resolver.resolve("escape/secret.txt")));
+    BOOST_TEST(!std::get<0>(resolver.resolve("../outside/secret.txt")));
+}
+
+BOOST_AUTO_TEST_CASE(aComponentSwappedForASymlinkIsNoLongerDirect)
+{
+    SampleTree tree;
+    PathResolver resolver{tree.base};
+    BOOST_REQUIRE(std::get<0>(resolver.resolve("docs/a.txt")));
+
+    // The same name now leads out of the base; nothing from the earlier resolution may carry over.
+    fs::rename(tree.base / "docs", tree.base / "moved");
+    std::ofstream{tree.root / "outside" / "a.txt"} << "x";
+    std::error_code ec;
+    fs::create_directory_symlink(tree.root / "outside", tree.base / "docs", ec);
+    if (ec)
+    {
+        BOOST_TEST_MESSAGE("Symlinks are not available here; skipping");
+        return;
+    }
+
+    BOOST_TEST(!std::get<0>(resolver.resolve("docs/a.txt")));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
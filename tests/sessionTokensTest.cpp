@@ -0,0 +1,156 @@
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "sessionTokens.hpp"
+#include "utils/checksum.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    const std::chrono::seconds hour{3600};
+    const std::string key(SessionTokens::keySize, 'k');
+    const std::string otherKey(SessionTokens::keySize, 'o');
+
+    // Splits "expires=<n>&signature=<hex>" as the server's query parsing would.
+    std::pair<std::string, std::string> splitQuery(const std::string &query)
+    {
+        const auto ampersand = query.find('&');
+        return {query.substr(8, ampersand - 8), query.substr(ampersand + 11)};
+    }
+
+    struct KeyDirectory
+    {
+        fs::path path = fs::temp_directory_path() / ("accio-key-" + Util::String::generateRandomString(12));
+        fs::path keyFile = path / "state" / "session.key";
+
+        ~KeyDirectory()
+        {
+            std::error_code ec;
+            fs::remove_all(path, ec);
+        }
+
+        std::string load(std::string_view password)
+        {
+            auto [ok, loaded, error] = SessionTokens::loadKey(keyFile, password);
+            BOOST_REQUIRE_MESSAGE(ok, error);
+            BOOST_TEST(loaded.size() == SessionTokens::keySize);
+            return loaded;
+        }
+    };
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(sessionTokens)
+
+BOOST_AUTO_TEST_CASE(verifiesIssuedTokens)
+{
+    const SessionTokens tokens{key, hour};
+    const std::string token = tokens.issue();
+    BOOST_TEST(tokens.verify(token));
+    BOOST_TEST(SessionTokens(key, hour).verify(token));
+}
+
+BOOST_AUTO_TEST_CASE(rejectsOtherKeysAndTampering)
+{
+    const SessionTokens tokens{key, hour};
+    std::string token = tokens.issue();
+    BOOST_TEST(!SessionTokens(otherKey, hour).verify(token));
+
+    std::string tampered = token;
+    tampered.back() = tampered.back() == '0' ? '1' : '0';
+    BOOST_TEST(!tokens.verify(tampered));
+
+    // Moving the expiry invalidates the MAC.
+    token.insert(token.begin(), '1');
+    BOOST_TEST(!tokens.verify(token));
+
+    BOOST_TEST(!tokens.verify(""));
+    BOOST_TEST(!tokens.verify("no-dot"));
+}
+
+BOOST_AUTO_TEST_CASE(rejectsExpiredTokens)
+{
+    const SessionTokens expired{key, std::chrono::seconds{-1}};
+    BOOST_TEST(!expired.verify(expired.issue()));
+}
+
+BOOST_AUTO_TEST_CASE(signedPathsBindThePath)
+{
+    const SessionTokens tokens{key, hour};
+    const auto [expires, signature] = splitQuery(tokens.signPath("/docs/a.txt", hour));
+    BOOST_TEST(tokens.verifyPath("/docs/a.txt", expires, signature));
+    BOOST_TEST(!tokens.verifyPath("/docs/b.txt", expires, signature));
+    BOOST_TEST(!tokens.verifyPath("/docs/a.txt", expires + "0", signature));
+    BOOST_TEST(!SessionTokens(otherKey, hour).verifyPath("/docs/a.txt", expires, signature));
+
+    const auto [pastExpires, pastSignature] = splitQuery(tokens.signPath("/docs/a.txt", std::chrono::seconds{-1}));
+    BOOST_TEST(!tokens.verifyPath("/docs/a.txt", pastExpires, pastSignature));
+}
+
+BOOST_AUTO_TEST_CASE(sessionTokensAndPathSignaturesDoNotMix)
+{
+    const SessionTokens tokens{key, hour};
+    const std::string token = tokens.issue();
+    const auto dot = token.find('.');
+    BOOST_TEST(!tokens.verifyPath("", token.substr(0, dot), token.substr(dot + 1)));
+
+    const auto [expires, signature] = splitQuery(tokens.signPath("", hour));
+    BOOST_TEST(!tokens.verify(expires + "." + signature));
+}
+
+BOOST_FIXTURE_TEST_CASE(theKeyFileSurvivesRestarts, KeyDirectory)
+{
+    const std::string first = load("secret");
+    BOOST_TEST(load("secret") == first);
+    BOOST_TEST(SessionTokens(load("secret"), hour).verify(SessionTokens(first, hour).issue()));
+#ifndef _WIN32
+    BOOST_TEST((fs::status(keyFile).permissions() == (fs::perms::owner_read | fs::perms::owner_write)));
+#endif
+}
+
+BOOST_FIXTURE_TEST_CASE(anotherPasswordReplacesTheKey, KeyDirectory)
+{
+    const std::string first = load("secret");
+    const std::string token = SessionTokens(first, hour).issue();
+
+    const std::string second = load("changed");
+    BOOST_TEST(second != first);
+    BOOST_TEST(!SessionTokens(second, hour).verify(token));
+
+    // Going back to the old password does not bring its key back either.
+    BOOST_TEST(load("secret") != first);
+}
+
+BOOST_FIXTURE_TEST_CASE(aDamagedKeyFileIsReplaced, KeyDirectory)
+{
+    const std::string first = load("secret");
+    std::ofstream{keyFile, std::ios::trunc} << "not a key file\n";
+    BOOST_TEST(load("secret") != first);
+}
+
+BOOST_FIXTURE_TEST_CASE(anUnwritableKeyFileFails, KeyDirectory)
+{
+    fs::create_directories(path);
+    std::ofstream{path / "state"} << "a file where the directory should be";
+    const auto [ok, loaded, error] = SessionTokens::loadKey(keyFile, "secret");
+    BOOST_TEST(!ok);
+    BOOST_TEST(!error.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(tokensDoNotIdentifyThePassword, KeyDirectory)
+{
+    const std::string token = SessionTokens(load("secret"), hour).issue();
+
+    // Someone holding a token who guesses the password right cannot confirm the guess: no key derived from
+    // the password alone, as the server once used, signs the token.
+    BOOST_TEST(!SessionTokens(Util::Checksum::hmacSha256("secret", "accio session key"), hour).verify(token));
+
+    // Nor does the password fix the key: another key file made for it signs differently.
+    KeyDirectory other;
+    BOOST_TEST(!SessionTokens(other.load("secret"), hour).verify(token));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+// Cost of sorting listing names. The lowercase-copy comparator is what the server did before: two
+// toLowerCopy allocations per comparison. It is compared with Util::String::compareCaseInsensitive and
+// compareNatural, which fold case while they compare.
+//
+// Usage: sortBenchmark [names, default 100000]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include "utils/string.hpp"
+
+namespace
+{
+    constexpr int rounds = 5;
+
+    using Less = std::function<bool(const std::string &, const std::string &)>;
+
+    // Mixed-case names with digit runs, roughly what a download or photo folder holds.
+    std::vector<std::string> makeNames(std::size_t count)
+    {
+        static constexpr char letters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_- ";
+        std::mt19937 random(12345);
+        std::uniform_int_distribution<std::size_t> letter(0, sizeof(letters) - 2);
+        std::uniform_int_distribution<int> length(4, 24);
+        std::uniform_int_distribution<int> number(0, 99999);
+
+        std::vector<std::string> names;
+        names.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::string name;
+            for (int j = length(random); j > 0; --j)
+            {
+                name.push_back(letters[letter(random)]);
+            }
+            name += std::to_string(number(random));
+            name += ".jpg";
+            names.push_back(std::move(name));
+        }
+        return names;
+    }
+
+    double bestMilliseconds(const std::vector<std::string> &names, const Less &less)
+    {
+        double best = 1e18;
+        for (int round = 0; round < rounds; ++round)
+        {
+            std::vector<std::string> copy = names;
+            const auto start = std::chrono::steady_clock::now();
+            std::sort(copy.begin(), copy.end(), less);
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const std::size_t count = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 100000U;
+    if (count == 0)
+    {
+        std::fprintf(stderr, "usage: %s [names]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<std::string> names = makeNames(count);
+
+    const double lowerCopy = bestMilliseconds(names, [](const std::string &lhs, const std::string &rhs) {
+        return Util::String::toLowerCopy(lhs) < Util::String::toLowerCopy(rhs);
+    });
+    const double caseInsensitive = bestMilliseconds(names, [](const std::string &lhs, const std::string &rhs) {
+        return Util::String::compareCaseInsensitive(lhs, rhs) < 0;
+    });
+    const double natural = bestMilliseconds(names, [](const std::string &lhs, const std::string &rhs) {
+        return Util::String::compareNatural(lhs, rhs) < 0;
+    });
+
+    std::printf("%zu names, best of %d rounds\n\n", count, rounds);
+    std::printf("%-28s %10s\n", "comparator", "ms");
+    std::printf("%-28s %10.1f\n", "toLowerCopy pair", lowerCopy);
+    std::printf("%-28s %10.1f\n", "compareCaseInsensitive", caseInsensitive);
+    std::printf("%-28s %10.1f\n", "compareNatural", natural);
+    return 0;
+}
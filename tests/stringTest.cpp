@@ -0,0 +1,81 @@
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "utils/string.hpp"
+
+BOOST_AUTO_TEST_SUITE(string)
+
+BOOST_AUTO_TEST_CASE(jsonEscapingLeavesPlainTextAlone)
+{
+    BOOST_TEST(Util::String::escapeForJson("report 2024.pdf") == "report 2024.pdf");
+    BOOST_TEST(Util::String::escapeForJson("\xe6\x96\x87\xe4\xbb\xb6") == "\xe6\x96\x87\xe4\xbb\xb6");
+}
+
+BOOST_AUTO_TEST_CASE(jsonEscapingHandlesQuotesAndControlCharacters)
+{
+    BOOST_TEST(Util::String::escapeForJson("say \"hi\"\\") == "say \\\"hi\\\"\\\\");
+    BOOST_TEST(Util::String::escapeForJson("a\nb\tc\r") == "a\\nb\\tc\\r");
+    BOOST_TEST(Util::String::escapeForJson(std::string{"\x01\x1f\x00", 3}) == "\\u0001\\u001f\\u0000");
+}
+
+BOOST_AUTO_TEST_CASE(caseInsensitiveOrderFoldsOnlyAsciiLetters)
+{
+    BOOST_TEST(Util::String::compareCaseInsensitive("apple", "Banana") < 0);
+    BOOST_TEST(Util::String::compareCaseInsensitive("file10", "file2") < 0);
+    BOOST_TEST(Util::String::compareCaseInsensitive("Z", "\xc3\xa4") < 0);
+    BOOST_TEST(Util::String::compareCaseInsensitive("abc", "ab") > 0);
+}
+
+BOOST_AUTO_TEST_CASE(caseInsensitiveOrderStaysTotal)
+{
+    BOOST_TEST(Util::String::compareCaseInsensitive("README", "readme") != 0);
+    BOOST_TEST(Util::String::compareCaseInsensitive("README", "readme") == -Util::String::compareCaseInsensitive("readme", "README"));
+    BOOST_TEST(Util::String::compareCaseInsensitive("same", "same") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(naturalOrderComparesDigitRunsByValue)
+{
+    BOOST_TEST(Util::String::compareNatural("file2", "file10") < 0);
+    BOOST_TEST(Util::String::compareNatural("file10", "file2") > 0);
+    BOOST_TEST(Util::String::compareNatural("a1b2", "a1b10") < 0);
+    BOOST_TEST(Util::String::compareNatural("99999999999999999999", "100000000000000000000") < 0);
+}
+
+BOOST_AUTO_TEST_CASE(naturalOrderFoldsCaseAndStaysTotal)
+{
+    BOOST_TEST(Util::String::compareNatural("Apple", "banana") < 0);
+    BOOST_TEST(Util::String::compareNatural("apple", "APPLE") != 0);
+    BOOST_TEST(Util::String::compareNatural("apple", "APPLE") == -Util::String::compareNatural("APPLE", "apple"));
+    BOOST_TEST(Util::String::compareNatural("same", "same") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(naturalOrderBreaksTiesOnLeadingZeros)
+{
+    BOOST_TEST(Util::String::compareNatural("1", "01") < 0);
+    BOOST_TEST(Util::String::compareNatural("01", "001") < 0);
+    BOOST_TEST(Util::String::compareNatural("01", "2") < 0);
+    BOOST_TEST(Util::String::compareNatural("file", "file1") < 0);
+}
+
+BOOST_AUTO_TEST_CASE(naturalOrderSortsAListing)
+{
+    std::vector<std::string> names{"img12.png", "IMG3.png", "img1.png", "img02.png", "notes", "img2.png"};
+    std::sort(names.begin(), names.end(), [](const std::string &lhs, const std::string &rhs) {
+        return Util::String::compareNatural(lhs, rhs) < 0;
+    });
+    const std::vector<std::string> expected{"img1.png", "img2.png", "img02.png", "IMG3.png", "img12.png", "notes"};
+    BOOST_TEST(names == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(hexAndBase64Encode)
+{
+    BOOST_TEST(Util::String::encodeHex(std::string{"\x00\x7f\xff", 3}) == "007fff");
+    BOOST_TEST(Util::String::encodeBase64("hello") == "aGVsbG8=");
+
+    std::string decoded;
+    BOOST_TEST(Util::String::decodeBase64("aGVsbG8=", decoded));
+    BOOST_TEST(decoded == "hello");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
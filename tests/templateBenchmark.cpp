@@ -0,0 +1,110 @@
+// Cost of producing the listing page around its rows, per request. The runtime variant is what the
+// server did before the template was split: copy index.html, then find and replace {{upload}} and
+// {{files}}. The segment variant writes the constexpr pieces generated at build time. Both deliver
+// to a sink that copies each piece once, as writing to the socket would.
+//
+// Usage: templateBenchmark [requests, default 200000]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "indexHtml.hpp"
+
+namespace
+{
+    constexpr int rounds = 5;
+    constexpr std::string_view rows = "<ul>\n<li><a href=\"/a.txt\">a.txt</a></li>\n</ul>\n";
+
+    struct Sink
+    {
+        std::vector<char> buffer = std::vector<char>(256U * 1024U);
+        std::size_t delivered = 0;
+
+        void write(const char *data, std::size_t length)
+        {
+            std::memcpy(buffer.data(), data, std::min(length, buffer.size()));
+            delivered += length;
+        }
+    };
+
+    void renderAtRuntime(const std::string &templateText, Sink &sink)
+    {
+        std::string page = templateText;
+        const std::string uploadPlaceholder = "{{upload}}";
+        if (std::size_t pos = page.find(uploadPlaceholder); pos != std::string::npos)
+        {
+            page.replace(pos, uploadPlaceholder.size(), resources::uploadHtml);
+        }
+
+        const std::string filesPlaceholder = "{{files}}";
+        if (std::size_t pos = page.find(filesPlaceholder); pos != std::string::npos)
+        {
+            page.replace(pos, filesPlaceholder.size(), rows);
+        }
+        sink.write(page.data(), page.size());
+    }
+
+    void renderFromSegments(Sink &sink)
+    {
+        sink.write(resources::indexHtmlBeforeUpload, sizeof(resources::indexHtmlBeforeUpload) - 1);
+        sink.write(resources::uploadHtml, sizeof(resources::uploadHtml) - 1);
+        sink.write(resources::indexHtmlBeforeFiles, sizeof(resources::indexHtmlBeforeFiles) - 1);
+        sink.write(rows.data(), rows.size());
+        sink.write(resources::indexHtmlAfterFiles, sizeof(resources::indexHtmlAfterFiles) - 1);
+    }
+
+    template <typename Render>
+    double bestNanosecondsPerRequest(std::size_t requests, Render render)
+    {
+        double best = 1e18;
+        for (int round = 0; round < rounds; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < requests; ++i)
+            {
+                render();
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = std::min(best, seconds * 1e9 / static_cast<double>(requests));
+        }
+        return best;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const std::size_t requests = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 200000U;
+    if (requests == 0)
+    {
+        std::fprintf(stderr, "usage: %s [requests]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // The template as the server used to embed it, placeholders included.
+    const std::string templateText = std::string{resources::indexHtmlBeforeUpload} + "{{upload}}" + resources::indexHtmlBeforeFiles
+                                     + "{{files}}" + resources::indexHtmlAfterFiles;
+
+    Sink runtimeSink;
+    Sink segmentSink;
+    renderAtRuntime(templateText, runtimeSink);
+    renderFromSegments(segmentSink);
+    if (runtimeSink.delivered != segmentSink.delivered)
+    {
+        std::fprintf(stderr, "pages differ: %zu and %zu bytes\n", runtimeSink.delivered, segmentSink.delivered);
+        return EXIT_FAILURE;
+    }
+    const std::size_t pageBytes = segmentSink.delivered;
+
+    const double runtime = bestNanosecondsPerRequest(requests, [&] { renderAtRuntime(templateText, runtimeSink); });
+    const double segments = bestNanosecondsPerRequest(requests, [&] { renderFromSegments(segmentSink); });
+
+    std::printf("%zu requests for a %zu byte page, best of %d rounds\n\n", requests, pageBytes, rounds);
+    std::printf("%-28s %12s\n", "template", "ns/request");
+    std::printf("%-28s %12.0f\n", "copy + find/replace", runtime);
+    std::printf("%-28s %12.0f\n", "constexpr segments", segments);
+    return 0;
+}
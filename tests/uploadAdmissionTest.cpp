@@ -0,0 +1,127 @@
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include "uploadAdmission.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr std::uint64_t mebibyte = 1024ULL * 1024ULL;
+
+    UploadAdmission::Limits limits(unsigned maxWriters, std::uint64_t maxPendingBytes = 0, std::uint64_t reserveBytes = 0)
+    {
+        return UploadAdmission::Limits{maxWriters, maxPendingBytes, reserveBytes};
+    }
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(uploadAdmission)
+
+BOOST_AUTO_TEST_CASE(ticketsHoldASlotAndTheirBytes)
+{
+    UploadAdmission admission{fs::temp_directory_path(), limits(4)};
+    {
+        auto [outcome, ticket] = admission.admit(mebibyte);
+        BOOST_TEST((outcome == UploadAdmission::Outcome::Admitted));
+        BOOST_TEST(admission.stats().writers == 1U);
+        BOOST_TEST(admission.stats().pendingBytes == mebibyte);
+    }
+    BOOST_TEST(admission.stats().writers == 0U);
+    BOOST_TEST(admission.stats().pendingBytes == 0U);
+    BOOST_TEST(admission.stats().admitted == 1U);
+}
+
+BOOST_AUTO_TEST_CASE(allocatedBytesLeaveTheReservation)
+{
+    UploadAdmission admission{fs::temp_directory_path(), limits(0)};
+    auto [outcome, ticket] = admission.admit(10 * mebibyte);
+    BOOST_REQUIRE((outcome == UploadAdmission::Outcome::Admitted));
+
+    // Small amounts are settled in batches.
+    ticket.allocated(mebibyte);
+    BOOST_TEST(admission.stats().pendingBytes == 10 * mebibyte);
+    ticket.allocated(4 * mebibyte);
+    BOOST_TEST(admission.stats().pendingBytes == 5 * mebibyte);
+    ticket.allocated(20 * mebibyte);
+    BOOST_TEST(admission.stats().pendingBytes == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(reservationsHoldBytesWithoutASlot)
+{
+    UploadAdmission admission{fs::temp_directory_path(), limits(1)};
+    {
+        auto [reserved, reservation] = admission.reserve(mebibyte);
+        BOOST_REQUIRE(reserved);
+        BOOST_TEST(admission.stats().writers == 0U);
+        BOOST_TEST(admission.stats().pendingBytes == mebibyte);
+
+        // The one writer slot is still free.
+        const auto [outcome, ticket] = admission.admit(0);
+        BOOST_TEST((outcome == UploadAdmission::Outcome::Admitted));
+    }
+    BOOST_TEST(admission.stats().writers == 0U);
+    BOOST_TEST(admission.stats().pendingBytes == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(reservationsCountAgainstTheFreeSpace)
+{
+    // Two reservations that each fit on their own cannot both be held at once.
+    const std::uint64_t available = fs::space(fs::temp_directory_path()).available;
+    UploadAdmission admission{fs::temp_directory_path(), limits(0)};
+    auto [first, held] = admission.reserve(available / 2 + mebibyte);
+    BOOST_REQUIRE(first);
+
+    const auto [second, refused] = admission.reserve(available / 2 + mebibyte);
+    BOOST_TEST(!second);
+    const auto [outcome, ticket] = admission.admit(available / 2 + mebibyte);
+    BOOST_TEST((outcome == UploadAdmission::Outcome::NoSpace));
+}
+
+BOOST_AUTO_TEST_CASE(aFullWriterTableTurnsRequestsAway)
+{
+    UploadAdmission admission{fs::temp_directory_path(), limits(1)};
+    auto [first, held] = admission.admit(0);
+    BOOST_REQUIRE((first == UploadAdmission::Outcome::Admitted));
+
+    const auto [second, refused] = admission.admit(0);
+    BOOST_TEST((second == UploadAdmission::Outcome::Busy));
+    BOOST_TEST(admission.stats().rejectedBusy == 1U);
+}
+
+BOOST_AUTO_TEST_CASE(waitersGetAFreedSlot)
+{
+    UploadAdmission admission{fs::temp_directory_path(), limits(1)};
+    auto [first, held] = admission.admit(0);
+    BOOST_REQUIRE((first == UploadAdmission::Outcome::Admitted));
+
+    std::thread releaser([ticket = std::move(held)]() mutable {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        UploadAdmission::Ticket released = std::move(ticket);
+    });
+    const auto [second, ticket] = admission.admit(0);
+    releaser.join();
+    BOOST_TEST((second == UploadAdmission::Outcome::Admitted));
+}
+
+BOOST_AUTO_TEST_CASE(pendingBytesAreCappedButOneUploadAlwaysFits)
+{
+    UploadAdmission admission{fs::temp_directory_path(), limits(0, 4 * mebibyte)};
+    auto [first, large] = admission.admit(8 * mebibyte);
+    BOOST_TEST((first == UploadAdmission::Outcome::Admitted));
+
+    const auto [second, refused] = admission.admit(mebibyte);
+    BOOST_TEST((second == UploadAdmission::Outcome::Busy));
+}
+
+BOOST_AUTO_TEST_CASE(theReserveMustStayFree)
+{
+    const std::uint64_t available = fs::space(fs::temp_directory_path()).available;
+    UploadAdmission admission{fs::temp_directory_path(), limits(0, 0, available + mebibyte)};
+    const auto [outcome, ticket] = admission.admit(0);
+    BOOST_TEST((outcome == UploadAdmission::Outcome::NoSpace));
+    BOOST_TEST(!std::get<0>(admission.reserve(1)));
+    BOOST_TEST(admission.stats().rejectedNoSpace == 2U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
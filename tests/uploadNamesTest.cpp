@@ -0,0 +1,131 @@
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "uploadNames.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct UploadsDirectory
+    {
+        fs::path path;
+        fs::path stagingDir;
+
+        UploadsDirectory()
+        {
+            path = fs::temp_directory_path() / ("accio-names-" + Util::String::generateRandomString(12));
+            stagingDir = path / ".staging";
+            fs::create_directories(stagingDir);
+        }
+
+        ~UploadsDirectory()
+        {
+            std::error_code ec;
+            fs::remove_all(path, ec);
+        }
+
+        fs::path stage(const std::string &content) const
+        {
+            const fs::path staged = stagingDir / (Util::String::generateRandomString(24) + ".part");
+            std::ofstream{staged} << content;
+            return staged;
+        }
+
+        std::string commit(UploadNames &names, const std::string &sanitized, const std::string &content = "x") const
+        {
+            const auto [ok, destination, error] = names.commit(stage(content), sanitized);
+            BOOST_REQUIRE_MESSAGE(ok, error);
+            return destination.filename().string();
+        }
+
+        std::string read(const std::string &fileName) const
+        {
+            std::ifstream file(path / fileName, std::ios::binary);
+            return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        }
+    };
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(uploadNames, UploadsDirectory)
+
+BOOST_AUTO_TEST_CASE(freshNamesAreKept)
+{
+    UploadNames names{path};
+    BOOST_TEST(commit(names, "report.pdf", "first") == "report.pdf");
+    BOOST_TEST(read("report.pdf") == "first");
+}
+
+BOOST_AUTO_TEST_CASE(duplicatesAreNumberedWithoutReplacing)
+{
+    UploadNames names{path};
+    BOOST_TEST(commit(names, "report.pdf", "first") == "report.pdf");
+    BOOST_TEST(commit(names, "report.pdf", "second") == "report_1.pdf");
+    BOOST_TEST(commit(names, "report.pdf", "third") == "report_2.pdf");
+    BOOST_TEST(read("report.pdf") == "first");
+    BOOST_TEST(read("report_1.pdf") == "second");
+    BOOST_TEST(fs::is_empty(stagingDir));
+}
+
+BOOST_AUTO_TEST_CASE(numbersContinueAfterTheHighestExistingOne)
+{
+    for (const char *existing : {"IMG_0001.jpg", "IMG_0001_3.jpg", "IMG_0001_x.jpg", "other_9.jpg"})
+    {
+        std::ofstream{path / existing};
+    }
+
+    UploadNames names{path};
+    BOOST_TEST(commit(names, "IMG_0001.jpg") == "IMG_0001_4.jpg");
+    BOOST_TEST(commit(names, "other.jpg") == "other.jpg");
+    BOOST_TEST(commit(names, "other.jpg") == "other_10.jpg");
+}
+
+BOOST_AUTO_TEST_CASE(namesTakenBehindTheServerAreSkipped)
+{
+    UploadNames names{path};
+    commit(names, "a.txt");
+    commit(names, "a.txt");
+    std::ofstream{path / "a_2.txt"} << "outside";
+
+    BOOST_TEST(commit(names, "a.txt") == "a_3.txt");
+    BOOST_TEST(read("a_2.txt") == "outside");
+}
+
+BOOST_AUTO_TEST_CASE(concurrentDuplicatesGetUniqueNames)
+{
+    constexpr int threads = 8;
+    constexpr int copiesPerThread = 500;
+
+    UploadNames names{path};
+    std::mutex resultMutex;
+    std::set<std::string> results;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&] {
+            for (int i = 0; i < copiesPerThread; ++i)
+            {
+                const auto [ok, destination, error] = names.commit(stage("x"), "IMG_0001.jpg");
+                std::lock_guard<std::mutex> guard(resultMutex);
+                results.insert(ok ? destination.filename().string() : "failed: " + error);
+            }
+        });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    BOOST_TEST(results.size() == static_cast<std::size_t>(threads * copiesPerThread));
+    BOOST_TEST(results.count("IMG_0001.jpg") == 1U);
+    BOOST_TEST(results.count("IMG_0001_3999.jpg") == 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,286 @@
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include "uploadSessions.hpp"
+#include "utils/checksum.hpp"
+#include "utils/file.hpp"
+#include "utils/string.hpp"
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr std::uint64_t chunkSize = 4;
+
+    struct UploadsDirectory
+    {
+        fs::path path;
+        fs::path stagingDir;
+        UploadSessions sessions;
+
+        UploadsDirectory()
+            : path(fs::temp_directory_path() / ("accio-sessions-" + Util::String::generateRandomString(12))),
+              stagingDir(prepare(path)),
+              sessions(std::make_shared<UploadNames>(path), nullptr, stagingDir, chunkSize, std::chrono::hours(1))
+        {
+        }
+
+        static fs::path prepare(const fs::path &uploadsDir)
+        {
+            fs::create_directory(uploadsDir);
+            return std::get<1>(Util::File::prepareStagingDirectory(uploadsDir));
+        }
+
+        ~UploadsDirectory()
+        {
+            std::error_code ec;
+            fs::remove_all(path, ec);
+        }
+
+        std::string create(const std::string &fileName, std::uint64_t length, std::optional<std::uint32_t> checksum = std::nullopt)
+        {
+            auto [outcome, id, error] = sessions.create(fileName, length, checksum);
+            BOOST_REQUIRE_MESSAGE(outcome == UploadSessions::Outcome::Ok, error);
+            return id;
+        }
+
+        std::tuple<UploadSessions::Outcome, UploadSessions::Status, std::string> send(const std::string &id, std::uint64_t offset, const std::string &data,
+                                                                                      std::optional<std::uint32_t> checksum = std::nullopt)
+        {
+            return sessions.writeChunk(id, offset, data.size(), checksum, [&data](const UploadSessions::Receiver &receive) {
+                return receive(data.data(), data.size());
+            });
+        }
+
+        std::string read(const std::string &fileName) const
+        {
+            std::ifstream file(path / fileName, std::ios::binary);
+            return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        }
+
+        // Finished uploads, not counting the staging directory.
+        std::size_t fileCount() const
+        {
+            return static_cast<std::size_t>(std::distance(fs::directory_iterator(path), fs::directory_iterator())) - 1U;
+        }
+
+        static std::uint32_t crc32cOf(const std::string &data)
+        {
+            Util::Checksum::Crc32c crc;
+            crc.update(data.data(), data.size());
+            return crc.value();
+        }
+
+        std::size_t stagedCount() const
+        {
+            return static_cast<std::size_t>(std::distance(fs::directory_iterator(stagingDir), fs::directory_iterator()));
+        }
+    };
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(uploadSessions, UploadsDirectory)
+
+BOOST_AUTO_TEST_CASE(rejectsEmptyUploads)
+{
+    const auto [outcome, id, error] = sessions.create("empty.txt", 0, std::nullopt);
+    BOOST_TEST((outcome == UploadSessions::Outcome::Invalid));
+    BOOST_TEST(stagedCount() == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(acceptsChunksOutOfOrder)
+{
+    const std::string id = create("notes.txt", 10);
+
+    auto [outcome, status, error] = send(id, 8, "ij");
+    BOOST_REQUIRE((outcome == UploadSessions::Outcome::Ok));
+    BOOST_TEST(status.offset == 0U);
+    BOOST_TEST(status.receivedChunks == "2");
+
+    std::tie(outcome, status, error) = send(id, 0, "abcd");
+    BOOST_REQUIRE((outcome == UploadSessions::Outcome::Ok));
+    BOOST_TEST(status.offset == 4U);
+    BOOST_TEST(status.receivedChunks == "0,2");
+    BOOST_TEST(!status.complete);
+
+    std::tie(outcome, status, error) = send(id, 4, "efgh");
+    BOOST_REQUIRE((outcome == UploadSessions::Outcome::Ok));
+    BOOST_TEST(status.complete);
+    BOOST_TEST(status.offset == 10U);
+    BOOST_TEST(status.receivedChunks == "0-2");
+    BOOST_TEST(status.fileName == "notes.txt");
+
+    BOOST_TEST(read("notes.txt") == "abcdefghij");
+    BOOST_TEST(fileCount() == 1U);
+    BOOST_TEST(stagedCount() == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(reportsWhetherTheFileIsPreallocated)
+{
+    BOOST_TEST(!sessions.isPreallocated("unknown"));
+
+    // Nothing has been written yet, so the file takes space on disk exactly when it was preallocated.
+    const std::string id = create("sized.bin", 3 * chunkSize);
+#ifdef _WIN32
+    BOOST_TEST(!sessions.isPreallocated(id));
+#else
+    struct stat info{};
+    BOOST_REQUIRE(::stat(fs::directory_iterator(stagingDir)->path().c_str(), &info) == 0);
+    BOOST_TEST(sessions.isPreallocated(id) == (static_cast<std::uint64_t>(info.st_blocks) * 512U >= 3 * chunkSize));
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(rejectsMisalignedAndShortChunks)
+{
+    const std::string id = create("notes.txt", 10);
+    BOOST_TEST((std::get<0>(send(id, 2, "cdef")) == UploadSessions::Outcome::Invalid));
+    BOOST_TEST((std::get<0>(send(id, 0, "abc")) == UploadSessions::Outcome::Invalid));
+    BOOST_TEST((std::get<0>(send(id, 8, "ijk")) == UploadSessions::Outcome::Invalid));
+    BOOST_TEST((std::get<0>(send(id, 12, "mnop")) == UploadSessions::Outcome::Invalid));
+
+    const auto [outcome, status] = sessions.status(id);
+    BOOST_TEST(status.receivedChunks.empty());
+}
+
+BOOST_AUTO_TEST_CASE(unknownSessionsAreNotFound)
+{
+    BOOST_TEST((std::get<0>(sessions.status("missing")) == UploadSessions::Outcome::NotFound));
+    BOOST_TEST((std::get<0>(send("missing", 0, "abcd")) == UploadSessions::Outcome::NotFound));
+    BOOST_TEST(!sessions.remove("missing"));
+}
+
+BOOST_AUTO_TEST_CASE(removingASessionDeletesItsPartialFile)
+{
+    const std::string id = create("notes.txt", 10);
+    BOOST_TEST(stagedCount() == 1U);
+    BOOST_TEST(sessions.remove(id));
+    BOOST_TEST(stagedCount() == 0U);
+    BOOST_TEST(fileCount() == 0U);
+    BOOST_TEST((std::get<0>(sessions.status(id)) == UploadSessions::Outcome::NotFound));
+}
+
+BOOST_AUTO_TEST_CASE(completionKeepsExistingFiles)
+{
+    std::ofstream{path / "notes.txt"} << "old";
+    const std::string id = create("notes.txt", 4);
+
+    const auto [outcome, status, error] = send(id, 0, "new!");
+    BOOST_REQUIRE(status.complete);
+    BOOST_TEST(status.fileName == "notes_1.txt");
+    BOOST_TEST(read("notes.txt") == "old");
+    BOOST_TEST(read(status.fileName) == "new!");
+}
+
+BOOST_AUTO_TEST_CASE(reportsTheChecksumOfTheWholeFile)
+{
+    const std::string id = create("notes.txt", 10, crc32cOf("abcdefghij"));
+    send(id, 4, "efgh");
+    send(id, 8, "ij");
+    const auto [outcome, status, error] = send(id, 0, "abcd");
+    BOOST_REQUIRE((outcome == UploadSessions::Outcome::Ok));
+    BOOST_TEST(status.complete);
+    BOOST_TEST(status.checksum == crc32cOf("abcdefghij"));
+}
+
+BOOST_AUTO_TEST_CASE(aCorruptChunkIsNotCounted)
+{
+    const std::string id = create("notes.txt", 10);
+    auto [outcome, status, error] = send(id, 0, "abcd", crc32cOf("abcX"));
+    BOOST_TEST((outcome == UploadSessions::Outcome::ChecksumMismatch));
+    BOOST_TEST(std::get<1>(sessions.status(id)).receivedChunks.empty());
+
+    std::tie(outcome, status, error) = send(id, 0, "abcd", crc32cOf("abcd"));
+    BOOST_TEST((outcome == UploadSessions::Outcome::Ok));
+    BOOST_TEST(status.receivedChunks == "0");
+}
+
+BOOST_AUTO_TEST_CASE(aFailedResendLeavesTheChunkMissing)
+{
+    const std::string id = create("notes.txt", 10);
+    BOOST_REQUIRE((std::get<0>(send(id, 0, "abcd")) == UploadSessions::Outcome::Ok));
+
+    BOOST_TEST((std::get<0>(send(id, 0, "abXd", crc32cOf("abcd"))) == UploadSessions::Outcome::ChecksumMismatch));
+    BOOST_TEST(std::get<1>(sessions.status(id)).receivedChunks.empty());
+
+    // A resend cut short leaves it missing too.
+    const auto [outcome, status, error] = sessions.writeChunk(id, 0, chunkSize, std::nullopt, [](const UploadSessions::Receiver &receive) {
+        return receive("ab", 2) && false;
+    });
+    BOOST_TEST((outcome == UploadSessions::Outcome::Invalid));
+    BOOST_TEST(std::get<1>(sessions.status(id)).receivedChunks.empty());
+
+    send(id, 4, "efgh");
+    send(id, 8, "ij");
+    BOOST_TEST(fileCount() == 0U);
+    BOOST_REQUIRE(std::get<1>(send(id, 0, "abcd")).complete);
+    BOOST_TEST(read("notes.txt") == "abcdefghij");
+}
+
+BOOST_AUTO_TEST_CASE(aRetryAfterCompletionReportsTheSavedFile)
+{
+    std::ofstream{path / "notes.txt"} << "old";
+    const std::string id = create("notes.txt", 4);
+    BOOST_REQUIRE(std::get<1>(send(id, 0, "abcd")).complete);
+
+    // The response to the last chunk was lost and the client sends it again.
+    const auto [outcome, status, error] = send(id, 0, "XXXX");
+    BOOST_TEST((outcome == UploadSessions::Outcome::Ok));
+    BOOST_TEST(status.complete);
+    BOOST_TEST(status.fileName == "notes_1.txt");
+    BOOST_TEST(read("notes_1.txt") == "abcd");
+    BOOST_TEST(fileCount() == 2U);
+
+    const auto [statusOutcome, current] = sessions.status(id);
+    BOOST_TEST((statusOutcome == UploadSessions::Outcome::Ok));
+    BOOST_TEST(current.complete);
+    BOOST_TEST(current.fileName == "notes_1.txt");
+}
+
+BOOST_AUTO_TEST_CASE(aWrongWholeFileChecksumDiscardsTheUpload)
+{
+    const std::string id = create("notes.txt", 4, crc32cOf("abcX"));
+    const auto [outcome, status, error] = send(id, 0, "abcd");
+    BOOST_TEST((outcome == UploadSessions::Outcome::ChecksumMismatch));
+    BOOST_TEST(fileCount() == 0U);
+    BOOST_TEST(stagedCount() == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(identicalUploadsShareStoredContent)
+{
+    const auto [storeOk, storeDir, storeError] = UploadStore::prepareDirectory(path);
+    BOOST_REQUIRE_MESSAGE(storeOk, storeError);
+    auto names = std::make_shared<UploadNames>(path);
+    auto store = std::make_shared<UploadStore>(names, storeDir, stagingDir);
+    UploadSessions deduplicating{names, store, stagingDir, chunkSize, std::chrono::hours(1)};
+
+    for (const char *fileName : {"first.txt", "second.txt"})
+    {
+        const std::string id = std::get<1>(deduplicating.create(fileName, 10, std::nullopt));
+        for (const std::uint64_t offset : {8U, 0U, 4U})
+        {
+            const std::string data = std::string{"abcdefghij"}.substr(offset, chunkSize);
+            const auto [outcome, status, error] = deduplicating.writeChunk(id, offset, data.size(), std::nullopt,
+                                                                           [&data](const UploadSessions::Receiver &receive) {
+                                                                               return receive(data.data(), data.size());
+                                                                           });
+            BOOST_REQUIRE_MESSAGE((outcome == UploadSessions::Outcome::Ok), error);
+        }
+    }
+
+    BOOST_TEST(read("first.txt") == "abcdefghij");
+    BOOST_TEST(read("second.txt") == "abcdefghij");
+    BOOST_TEST(stagedCount() == 0U);
+    // Without reflinks the store keeps nothing and each upload is saved on its own.
+    const bool cloning = Util::File::supportsCloning(path);
+    BOOST_TEST(store->stats().stored == (cloning ? 1U : 0U));
+    BOOST_TEST(store->stats().duplicates == (cloning ? 1U : 0U));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
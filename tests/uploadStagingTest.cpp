@@ -0,0 +1,67 @@
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "utils/file.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct UploadsDirectory
+    {
+        fs::path path;
+
+        UploadsDirectory()
+        {
+            path = fs::temp_directory_path() / ("accio-staging-" + Util::String::generateRandomString(12));
+            fs::create_directory(path);
+        }
+
+        ~UploadsDirectory()
+        {
+            std::error_code ec;
+            fs::remove_all(path, ec);
+        }
+
+        static std::string read(const fs::path &file)
+        {
+            std::ifstream stream(file, std::ios::binary);
+            return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+        }
+    };
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(uploadStaging, UploadsDirectory)
+
+BOOST_AUTO_TEST_CASE(preparingStagingRemovesLeftovers)
+{
+    fs::create_directories(path / ".accio-staging" / "old");
+    std::ofstream{path / ".accio-staging" / "abandoned.part"} << "partial";
+
+    const auto [ok, stagingDir, error] = Util::File::prepareStagingDirectory(path);
+    BOOST_REQUIRE_MESSAGE(ok, error);
+    BOOST_TEST(stagingDir.filename() == ".accio-staging");
+    BOOST_TEST(fs::is_empty(stagingDir));
+}
+
+BOOST_AUTO_TEST_CASE(renameNoReplaceRefusesAnExistingTarget)
+{
+    std::ofstream{path / "from"} << "new";
+    std::ofstream{path / "to"} << "old";
+
+    std::error_code ec;
+    BOOST_TEST(!Util::File::renameNoReplace(path / "from", path / "to", ec));
+    BOOST_TEST((ec == std::errc::file_exists));
+    BOOST_TEST(read(path / "from") == "new");
+    BOOST_TEST(read(path / "to") == "old");
+
+    BOOST_TEST(Util::File::renameNoReplace(path / "from", path / "moved", ec));
+    BOOST_TEST(!ec);
+    BOOST_TEST(!fs::exists(path / "from"));
+    BOOST_TEST(read(path / "moved") == "new");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
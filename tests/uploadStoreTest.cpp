@@ -0,0 +1,201 @@
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include "uploadStore.hpp"
+#include "utils/checksum.hpp"
+#include "utils/file.hpp"
+#include "utils/string.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct UploadsDirectory
+    {
+        fs::path path;
+        fs::path stagingDir;
+        fs::path storeDir;
+        std::shared_ptr<UploadNames> names;
+        // Content is shared only through reflinks; on other filesystems the store keeps nothing.
+        bool cloning = false;
+
+        UploadsDirectory()
+        {
+            path = fs::temp_directory_path() / ("accio-store-" + Util::String::generateRandomString(12));
+            fs::create_directory(path);
+            stagingDir = std::get<1>(Util::File::prepareStagingDirectory(path));
+            storeDir = std::get<1>(UploadStore::prepareDirectory(path));
+            names = std::make_shared<UploadNames>(path);
+            cloning = Util::File::supportsCloning(path);
+        }
+
+        ~UploadsDirectory()
+        {
+            std::error_code ec;
+            fs::remove_all(path, ec);
+        }
+
+        static std::string sha256Of(const std::string &content)
+        {
+            Util::Checksum::Sha256 sha;
+            sha.update(content.data(), content.size());
+            return sha.finish();
+        }
+
+        fs::path stage(const std::string &content) const
+        {
+            const fs::path staged = Util::File::makeStagingPath(stagingDir);
+            std::ofstream{staged, std::ios::binary} << content;
+            return staged;
+        }
+
+        std::string commit(UploadStore &store, const std::string &sanitized, const std::string &content) const
+        {
+            const auto [ok, destination, error] = store.commit(stage(content), sanitized, sha256Of(content), content.size());
+            BOOST_REQUIRE_MESSAGE(ok, error);
+            return destination.filename().string();
+        }
+
+        std::string read(const std::string &fileName) const
+        {
+            std::ifstream file(path / fileName, std::ios::binary);
+            return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        }
+    };
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(uploadStore, UploadsDirectory)
+
+BOOST_AUTO_TEST_CASE(newContentIsEnteredOnce)
+{
+    UploadStore store{names, storeDir, stagingDir};
+    BOOST_TEST(commit(store, "a.bin", "first content") == "a.bin");
+    BOOST_TEST(read("a.bin") == "first content");
+    BOOST_TEST(fs::hard_link_count(path / "a.bin") == 1U);
+
+    const fs::path object = storeDir / Util::String::encodeHex(sha256Of("first content"));
+    if (!cloning)
+    {
+        BOOST_TEST(!fs::exists(object));
+        BOOST_TEST(store.stats().stored == 0U);
+        return;
+    }
+    BOOST_TEST(fs::hard_link_count(object) == 1U);
+    BOOST_TEST(((fs::status(object).permissions() & fs::perms::owner_write) == fs::perms::none));
+    BOOST_TEST(store.stats().stored == 1U);
+    BOOST_TEST(store.stats().duplicates == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(withoutReflinksIdenticalUploadsStaySeparate)
+{
+    UploadStore store{names, storeDir, stagingDir};
+    commit(store, "a.bin", "same content");
+    commit(store, "b.bin", "same content");
+    BOOST_TEST(fs::hard_link_count(path / "a.bin") == 1U);
+    BOOST_TEST(fs::hard_link_count(path / "b.bin") == 1U);
+    if (!cloning)
+    {
+        BOOST_TEST(fs::is_empty(storeDir));
+        BOOST_TEST(store.stats().duplicates == 0U);
+        BOOST_TEST(!std::get<0>(store.commitKnown("c.bin", sha256Of("same content"), 12)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(duplicatesShareTheStoredContent)
+{
+    if (!cloning)
+    {
+        return;
+    }
+    UploadStore store{names, storeDir, stagingDir};
+    commit(store, "a.bin", "same content");
+    BOOST_TEST(commit(store, "b.bin", "same content") == "b.bin");
+    BOOST_TEST(commit(store, "a.bin", "same content") == "a_1.bin");
+
+    BOOST_TEST(read("b.bin") == "same content");
+    BOOST_TEST(read("a_1.bin") == "same content");
+    BOOST_TEST(fs::hard_link_count(path / "b.bin") == 1U);
+    BOOST_TEST(fs::is_empty(stagingDir));
+
+    const UploadStore::Stats stats = store.stats();
+    BOOST_TEST(stats.stored == 1U);
+    BOOST_TEST(stats.duplicates == 2U);
+    BOOST_TEST(stats.bytesSaved == 24U);
+}
+
+BOOST_AUTO_TEST_CASE(editingACopyInPlaceLeavesTheOthers)
+{
+    if (!cloning)
+    {
+        return;
+    }
+    UploadStore store{names, storeDir, stagingDir};
+    commit(store, "a.bin", "same content");
+    commit(store, "b.bin", "same content");
+
+    std::fstream{path / "a.bin", std::ios::in | std::ios::out | std::ios::binary} << "SAME";
+    BOOST_TEST(read("a.bin") == "SAME content");
+    BOOST_TEST(read("b.bin") == "same content");
+    BOOST_TEST(commit(store, "c.bin", "same content") == "c.bin");
+    BOOST_TEST(read("c.bin") == "same content");
+}
+
+BOOST_AUTO_TEST_CASE(aModifiedObjectIsNotShared)
+{
+    if (!cloning)
+    {
+        return;
+    }
+    UploadStore store{names, storeDir, stagingDir};
+    commit(store, "a.bin", "same content");
+
+    // Rewritten in place with the size unchanged; only the times give it away.
+    const fs::path object = storeDir / Util::String::encodeHex(sha256Of("same content"));
+    fs::permissions(object, fs::perms::owner_write, fs::perm_options::add);
+    std::fstream{object, std::ios::in | std::ios::out | std::ios::binary} << "XXXX";
+
+    commit(store, "b.bin", "same content");
+    BOOST_TEST(read("b.bin") == "same content");
+    BOOST_TEST(store.stats().duplicates == 0U);
+    BOOST_TEST(store.stats().stored == 2U);
+
+    // The upload that found it replaced the object.
+    commit(store, "c.bin", "same content");
+    BOOST_TEST(read("c.bin") == "same content");
+    BOOST_TEST(store.stats().duplicates == 1U);
+}
+
+BOOST_AUTO_TEST_CASE(knownDigestsFinishWithoutData)
+{
+    if (!cloning)
+    {
+        return;
+    }
+    UploadStore store{names, storeDir, stagingDir};
+    const auto [missing, missingPath, missingError] = store.commitKnown("c.bin", sha256Of("stored"), 6);
+    BOOST_TEST(!missing);
+    BOOST_TEST(missingError.empty());
+
+    commit(store, "a.bin", "stored");
+    const auto [ok, destination, error] = store.commitKnown("c.bin", sha256Of("stored"), 6);
+    BOOST_REQUIRE_MESSAGE(ok, error);
+    BOOST_TEST(read("c.bin") == "stored");
+    BOOST_TEST(store.stats().earlyFinishes == 1U);
+
+    // A length that disagrees with the stored content is not trusted.
+    BOOST_TEST(!std::get<0>(store.commitKnown("d.bin", sha256Of("stored"), 7)));
+}
+
+BOOST_AUTO_TEST_CASE(startupEmptiesTheStore)
+{
+    std::ofstream{storeDir / Util::String::encodeHex(sha256Of("left over"))} << "left over";
+
+    const auto [ok, preparedDir, error] = UploadStore::prepareDirectory(path);
+    BOOST_REQUIRE_MESSAGE(ok, error);
+    BOOST_TEST(fs::is_empty(preparedDir));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
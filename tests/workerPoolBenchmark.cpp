@@ -0,0 +1,121 @@
+// Trade-offs of --workers, --worker-queue and --connections-per-ip. Each scenario drives a WorkerPool the
+// way the server does, one task per connection: a greedy client opens slow connections (a download blocked
+// on a slow reader) while many other clients each make one short request from their own address. The table
+// shows how long those short requests wait, how many connections are turned away and how long the load
+// takes to drain.
+//
+// The tasks only sleep; no sockets or HTTP are involved, so keep-alive and the read and write timeouts are
+// not measured here.
+//
+// Usage: workerPoolBenchmark
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "workerPool.hpp"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    constexpr unsigned greedyConnections = 32;
+    constexpr auto greedyDuration = std::chrono::milliseconds(300);
+    constexpr unsigned quickClients = 200;
+    constexpr auto quickDuration = std::chrono::milliseconds(1);
+    constexpr auto quickInterval = std::chrono::microseconds(500);
+
+    struct Scenario
+    {
+        const char *name;
+        WorkerPool::Limits limits;
+    };
+
+    struct Result
+    {
+        std::vector<double> quickLatencies;
+        unsigned dropped = 0;
+        unsigned refused = 0;
+        double seconds = 0;
+    };
+
+    Result run(const Scenario &scenario)
+    {
+        WorkerPool pool{scenario.limits};
+        Result result;
+        std::mutex resultMutex;
+        std::atomic<unsigned> refused{0};
+        const Clock::time_point start = Clock::now();
+
+        for (unsigned i = 0; i < greedyConnections; ++i)
+        {
+            const bool queued = pool.enqueue([&pool, &refused] {
+                if (!pool.admitConnection("10.0.0.1"))
+                {
+                    refused.fetch_add(1);
+                    return;
+                }
+                std::this_thread::sleep_for(greedyDuration);
+            });
+            result.dropped += queued ? 0 : 1;
+        }
+
+        for (unsigned client = 0; client < quickClients; ++client)
+        {
+            std::this_thread::sleep_for(quickInterval);
+            const Clock::time_point arrived = Clock::now();
+            const std::string address = "10.1." + std::to_string(client / 250) + "." + std::to_string(client % 250);
+            const bool queued = pool.enqueue([&pool, &result, &resultMutex, arrived, address] {
+                pool.admitConnection(address);
+                std::this_thread::sleep_for(quickDuration);
+                const double latency = Milliseconds(Clock::now() - arrived).count();
+                std::lock_guard<std::mutex> guard(resultMutex);
+                result.quickLatencies.push_back(latency);
+            });
+            result.dropped += queued ? 0 : 1;
+        }
+
+        pool.shutdown();
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        result.refused = refused.load();
+        std::sort(result.quickLatencies.begin(), result.quickLatencies.end());
+        return result;
+    }
+
+    double percentile(const std::vector<double> &sorted, double fraction)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(sorted.size())))];
+    }
+} // namespace
+
+int main()
+{
+    const Scenario scenarios[] = {
+        {"8 workers", {8, 0, 0}},
+        {"64 workers", {64, 0, 0}},
+        {"8 workers, 4 per address", {8, 0, 4}},
+        {"8 workers, queue of 16", {8, 16, 0}},
+        {"64 workers, 4 per address", {64, 0, 4}},
+    };
+
+    std::printf("%u greedy %lld ms connections from one address, %u quick %lld ms requests from others\n\n",
+                greedyConnections, static_cast<long long>(greedyDuration.count()),
+                quickClients, static_cast<long long>(quickDuration.count()));
+    std::printf("%-28s %10s %10s %8s %8s %8s %8s\n", "scenario", "p50 (ms)", "p99 (ms)", "served", "dropped", "refused", "wall (s)");
+    for (const Scenario &scenario : scenarios)
+    {
+        const Result result = run(scenario);
+        std::printf("%-28s %10.1f %10.1f %4zu/%-3u %8u %8u %8.2f\n", scenario.name,
+                    percentile(result.quickLatencies, 0.5), percentile(result.quickLatencies, 0.99),
+                    result.quickLatencies.size(), quickClients, result.dropped, result.refused, result.seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <future>
+#include "workerPool.hpp"
+
+BOOST_AUTO_TEST_SUITE(workerPool)
+
+BOOST_AUTO_TEST_CASE(shutdownServesQueuedTasks)
+{
+    WorkerPool pool{{2, 0, 0}};
+    std::atomic<unsigned> ran{0};
+    for (int i = 0; i < 50; ++i)
+    {
+        BOOST_REQUIRE(pool.enqueue([&ran] { ran.fetch_add(1); }));
+    }
+    pool.shutdown();
+    BOOST_TEST(ran.load() == 50U);
+    BOOST_TEST(pool.stats().served == 50U);
+    BOOST_TEST(!pool.enqueue([] {}));
+}
+
+BOOST_AUTO_TEST_CASE(fullQueueRefusesConnections)
+{
+    WorkerPool pool{{1, 1, 0}};
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> started;
+
+    BOOST_REQUIRE(pool.enqueue([&started, released] {
+        started.set_value();
+        released.wait();
+    }));
+    started.get_future().wait();
+    BOOST_TEST(pool.enqueue([] {}));
+    BOOST_TEST(!pool.enqueue([] {}));
+
+    const WorkerPool::Stats stats = pool.stats();
+    BOOST_TEST(stats.busy == 1U);
+    BOOST_TEST(stats.queued == 1U);
+    BOOST_TEST(stats.rejectedQueueFull == 1U);
+
+    release.set_value();
+    pool.shutdown();
+    BOOST_TEST(pool.stats().served == 2U);
+}
+
+BOOST_AUTO_TEST_CASE(perAddressCapCountsConnectionsUntilTheyFinish)
+{
+    WorkerPool pool{{3, 0, 1}};
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<bool> first;
+    std::promise<bool> second;
+
+    BOOST_REQUIRE(pool.enqueue([&pool, &first, released] {
+        // Later requests on the same connection are not counted again.
+        const bool admitted = pool.admitConnection("192.0.2.1") && pool.admitConnection("192.0.2.1");
+        first.set_value(admitted);
+        released.wait();
+    }));
+    BOOST_TEST(first.get_future().get());
+
+    // The IPv4-mapped spelling is the same client.
+    BOOST_REQUIRE(pool.enqueue([&pool, &second] { second.set_value(pool.admitConnection("::ffff:192.0.2.1")); }));
+    BOOST_TEST(!second.get_future().get());
+
+    std::promise<bool> other;
+    BOOST_REQUIRE(pool.enqueue([&pool, &other] { other.set_value(pool.admitConnection("192.0.2.2")); }));
+    BOOST_TEST(other.get_future().get());
+
+    release.set_value();
+    pool.shutdown();
+    BOOST_TEST(pool.stats().rejectedPerAddress == 1U);
+}
+
+BOOST_AUTO_TEST_CASE(finishedConnectionsReleaseTheirCount)
+{
+    WorkerPool pool{{1, 0, 1}};
+    for (int i = 0; i < 3; ++i)
+    {
+        std::promise<bool> admitted;
+        BOOST_REQUIRE(pool.enqueue([&pool, &admitted] { admitted.set_value(pool.admitConnection("2001:db8::1")); }));
+        BOOST_TEST(admitted.get_future().get());
+    }
+    pool.shutdown();
+    BOOST_TEST(pool.stats().rejectedPerAddress == 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()